@@ -0,0 +1,49 @@
+// Replays recorded predicate traces through the searcher, so that the cost
+// of the search itself can be measured without the original predicate.
+//
+// usage: bm_replay [benchmark options] TRACE...
+//
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <predicate_trace.h>
+
+
+static void bm_replay(benchmark::State& state, const segments::TraceReplay* replay) {
+    for (auto _ : state) {
+        auto result = segments::replay_segment(*replay);
+        benchmark::DoNotOptimize(result.data());
+        benchmark::ClobberMemory();
+    }
+    const auto probes = static_cast<double>(replay->records().size());
+    state.counters["probes"] = probes;
+    state.counters["probe_rate"] = benchmark::Counter(probes, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+
+    std::vector<std::unique_ptr<segments::TraceReplay>> replays;
+    for (int i = 1; i < argc; ++i) {
+        std::string path(argv[i]);
+        replays.push_back(std::make_unique<segments::TraceReplay>(path));
+
+        auto name = path.substr(path.find_last_of("/\\") + 1);
+        benchmark::RegisterBenchmark(("bm_replay/" + name).c_str(), bm_replay, replays.back().get());
+    }
+
+    if (replays.empty()) {
+        std::cerr << "usage: " << argv[0] << " [benchmark options] TRACE...\n";
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -4,10 +4,13 @@
 
 
 #include <cmath>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
 #include <segments.h>
+#include <run_segmentation.h>
+#include <sample_grid.h>
 
 
 static void bm_single_interval(benchmark::State& state) {
@@ -53,6 +56,77 @@ static void bm_multiple_intervals(benchmark::State& state) {
 
 }
 
+static void bm_multiple_intervals_runs(benchmark::State& state) {
+
+    segments::interval base(0.0, 10.0);
+    segments::RunSet runs(std::vector<segments::interval>{
+            {0.234, 0.9523}, {1.042, 1.093}, {1.252, 1.301}, {1.354, 2.252}, {2.852, 3.401},
+            {3.405, 3.509}, {3.791, 4.411}, {4.925, 5.995}, {6.013, 6.521}, {6.525, 6.599},
+            {7.354, 8.023}, {8.154, 8.832}, {9.021, 9.411}
+    });
+
+    for (auto _ : state) {
+        auto result = segments::segment_runs(base, runs, int(state.range(0)));
+        benchmark::DoNotOptimize(result.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetComplexityN(1LL<<state.range(0));
+
+}
+
+/*
+ * A signal of 2^16 samples on [0, 16), with a prefix count of the samples
+ * below a threshold, so the predicate itself costs almost nothing and the
+ * two benchmarks below differ only in how a probe is mapped to samples.
+ */
+static const std::vector<std::size_t>& below_threshold_counts() {
+    static const std::vector<std::size_t> counts = [] {
+        std::vector<std::size_t> result(1, 0);
+        for (std::size_t i = 0; i < (1 << 16); ++i) {
+            const bool below = std::sin(double(i) / 512.0) + 0.3 * std::sin(double(i) / 37.0) < 0.2;
+            result.push_back(result.back() + below);
+        }
+        return result;
+    }();
+    return counts;
+}
+
+static void bm_sampled_interval(benchmark::State& state) {
+    segments::interval base(0.0, 16.0);
+    const auto& counts = below_threshold_counts();
+    const auto samples = double(counts.size() - 1);
+    auto predicate = [&counts, samples](const segments::interval& arg) {
+        auto begin = std::min(samples, std::max(0.0, std::ceil(arg.inf() * 4096.0)));
+        auto end = std::min(samples, std::max(0.0, std::ceil(arg.sup() * 4096.0)));
+        return begin < end && counts[std::size_t(end)] == counts[std::size_t(begin)];
+    };
+
+    for (auto _ : state) {
+        auto result = segments::segment(base, predicate, int(state.range(0)));
+        benchmark::DoNotOptimize(result.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetComplexityN(1LL<<state.range(0));
+}
+
+static void bm_sampled_grid(benchmark::State& state) {
+    segments::interval base(0.0, 16.0);
+    const auto& counts = below_threshold_counts();
+    auto predicate = segments::on_grid({12, 0, counts.size() - 1}, [&counts](std::size_t begin, std::size_t end) {
+        return begin < end && counts[end] == counts[begin];
+    });
+
+    for (auto _ : state) {
+        auto result = segments::segment(base, predicate, int(state.range(0)));
+        benchmark::DoNotOptimize(result.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetComplexityN(1LL<<state.range(0));
+}
+
 
 BENCHMARK(bm_single_interval)->DenseRange(1, 20, 1)->Complexity();
 BENCHMARK(bm_multiple_intervals)->DenseRange(1, 20, 1)->Complexity();
+BENCHMARK(bm_multiple_intervals_runs)->DenseRange(1, 20, 1)->Complexity();
+BENCHMARK(bm_sampled_interval)->DenseRange(1, 12, 1)->Complexity();
+BENCHMARK(bm_sampled_grid)->DenseRange(1, 12, 1)->Complexity();
@@ -0,0 +1,223 @@
+"""
+End-to-end benchmarks of the pysegments bindings.
+
+The C++ benchmarks in this directory measure the search itself. These
+measure what a Python caller pays on top of it: boxing each probe as an
+Interval, calling back into the interpreter, converting the results, and
+holding or releasing the GIL.
+
+Every case searches a price-like random walk with a NumPy predicate, at a
+range of tolerances and for thresholds giving few or many segments.
+
+    python benchmarks/python/run_benchmarks.py
+    python benchmarks/python/run_benchmarks.py --save baselines/mymachine.json
+    python benchmarks/python/run_benchmarks.py --compare baselines/mymachine.json
+
+With --compare, the run fails if any case is slower than the baseline by
+more than --threshold (a fraction, 0.1 by default), or fails with an error
+where the baseline did not. Baselines are only
+comparable when taken on the same machine and Python version.
+"""
+import argparse
+import ctypes
+import json
+import platform
+import statistics
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from datetime import datetime, timezone
+
+import numpy as np
+
+import pysegments
+from pysegments import Interval, NativePredicate, segment, segment_dyadic
+
+
+BASE = Interval(0.0, 100.0)
+TOLERANCES = (6, 10, 14)
+
+# Thresholds on the range of the series within an interval. The smaller one
+# gives a few short segments, the larger one many segments.
+THRESHOLDS = {"few": 0.5, "many": 2.0}
+
+THREADS = 4
+
+
+def make_series(seed=12345, count=200_000):
+    rng = np.random.default_rng(seed)
+    times = np.linspace(BASE.inf, BASE.sup, count, endpoint=False)
+    values = np.cumsum(rng.normal(0.0, 0.05, count))
+    return times, values
+
+
+TIMES, VALUES = make_series()
+
+
+def range_below(inf, sup, threshold):
+    lo, hi = np.searchsorted(TIMES, (inf, sup))
+    if lo == hi:
+        return True
+    window = VALUES[lo:hi]
+    return window.max() - window.min() <= threshold
+
+
+def interval_predicate(threshold):
+    return lambda ivl: range_below(ivl.inf, ivl.sup, threshold)
+
+
+NATIVE_TYPE = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+
+def native_predicate(threshold):
+    # A ctypes callback still runs Python, but goes through the native
+    # predicate path of the bindings.
+    callback = NATIVE_TYPE(lambda inf, sup, data: bool(range_below(inf, sup, threshold)))
+    return NativePredicate(callback)
+
+
+def count_probes(predicate):
+    count = 0
+
+    def counting(ivl):
+        nonlocal count
+        count += 1
+        return predicate(ivl)
+
+    return counting, lambda: count
+
+
+def make_cases():
+    """Yield (name, run) for every case."""
+    for size, threshold in THRESHOLDS.items():
+        for tol in TOLERANCES:
+            suffix = f"{size}/tol={tol}"
+
+            yield (f"segment/interval/{suffix}",
+                   lambda t=threshold, n=tol: segment(BASE, interval_predicate(t), n))
+            yield (f"segment/reuse_interval/{suffix}",
+                   lambda t=threshold, n=tol: segment(BASE, interval_predicate(t), n, reuse_interval=True))
+            yield (f"segment/native/{suffix}",
+                   lambda t=threshold, n=tol: segment(BASE, native_predicate(t), n))
+            yield (f"segment_dyadic/interval/{suffix}",
+                   lambda t=threshold, n=tol: segment_dyadic(BASE, interval_predicate(t), n))
+
+    # Several searches at once from a thread pool, to show whether the
+    # bindings serialise them on the GIL.
+    for kind, make in (("interval", interval_predicate), ("native", native_predicate)):
+        def run_threaded(make=make):
+            with ThreadPoolExecutor(THREADS) as pool:
+                futures = [pool.submit(segment, BASE, make(THRESHOLDS["many"]), 10) for _ in range(THREADS)]
+                return [f.result() for f in futures][0]
+
+        yield f"threads={THREADS}/{kind}/many/tol=10", run_threaded
+
+
+def probes_for(name):
+    """The number of predicate calls made by the search in case name."""
+    parts = dict(part.split("=") for part in name.split("/") if "=" in part)
+    size = next(s for s in THRESHOLDS if f"/{s}/" in name)
+    counting, count = count_probes(interval_predicate(THRESHOLDS[size]))
+    segment(BASE, counting, int(parts["tol"]))
+    return count() * (THREADS if name.startswith("threads") else 1)
+
+
+def time_case(run, repeat):
+    timings = []
+    result = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = run()
+        timings.append(time.perf_counter() - start)
+    return timings, result
+
+
+def run_cases(repeat, pattern):
+    results = {}
+    for name, run in make_cases():
+        if pattern and pattern not in name:
+            continue
+
+        try:
+            run()  # warm up
+            timings, result = time_case(run, repeat)
+        except Exception as exc:
+            results[name] = {"error": f"{type(exc).__name__}: {exc}"}
+            print(f"{name:45s} error: {results[name]['error']}")
+            continue
+
+        probes = probes_for(name)
+        median = statistics.median(timings)
+        results[name] = {
+            "median_s": median,
+            "min_s": min(timings),
+            "probes": probes,
+            "ns_per_probe": 1e9 * median / probes if probes else None,
+            "segments": len(result[0]) if isinstance(result, tuple) else len(result),
+        }
+        print(f"{name:45s} {1e3 * median:10.3f} ms  {results[name]['ns_per_probe']:10.1f} ns/probe"
+              f"  {results[name]['segments']:6d} segments")
+    return results
+
+
+def metadata():
+    return {
+        "date": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+        "python": sys.version.split()[0],
+        "numpy": np.__version__,
+        "pysegments": getattr(pysegments, "__version__", "unknown"),
+        "machine": platform.machine(),
+        "platform": platform.platform(),
+    }
+
+
+def compare(results, baseline, threshold):
+    """Print the change against baseline and return the names of regressions."""
+    regressions = []
+    print(f"\nCompared with baseline from {baseline['metadata'].get('date', 'unknown')}")
+    for name, result in results.items():
+        before = baseline["results"].get(name)
+        if before is None or "median_s" not in before:
+            continue
+        if "median_s" not in result:
+            regressions.append(name)
+            print(f"{name:45s} {'error':>9s}  REGRESSION")
+            continue
+
+        change = result["median_s"] / before["median_s"] - 1.0
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        elif change < -threshold:
+            flag = "  improved"
+        print(f"{name:45s} {100 * change:+8.1f}%{flag}")
+    return regressions
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--repeat", type=int, default=5, help="timed runs of each case")
+    parser.add_argument("--filter", default="", help="only run cases whose name contains this")
+    parser.add_argument("--save", metavar="PATH", help="write the results as JSON")
+    parser.add_argument("--compare", metavar="PATH", help="compare with a saved baseline")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="relative slowdown counted as a regression")
+    args = parser.parse_args(argv)
+
+    results = run_cases(args.repeat, args.filter)
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump({"metadata": metadata(), "results": results}, f, indent=2, sort_keys=True)
+
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+        if compare(results, baseline, args.threshold):
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
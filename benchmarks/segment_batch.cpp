@@ -0,0 +1,127 @@
+// Segments every window of a batch input file on a pool of threads and
+// writes the segments to a batch output file, reporting progress and
+// throughput on stderr. See batch_segmentation.h for the file formats.
+//
+// usage: segment_batch [options] INPUT OUTPUT
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <batch_segmentation.h>
+
+
+static const char usage[] =
+        "usage: segment_batch [options] INPUT OUTPUT\n"
+        "\n"
+        "  --threshold LOWER UPPER  segments where every value lies in [LOWER, UPPER]\n"
+        "  --runs                   segments inside the runs of each window, stored as the\n"
+        "                           run starts followed by the run ends\n"
+        "  --tolerance N            trim tolerance (default: the signal tolerance)\n"
+        "  --signal-tolerance N     signal tolerance (required)\n"
+        "  --start-depth N          depth at which each search begins (default 0)\n"
+        "  --threads N              worker threads (default: one per core)\n"
+        "  --chunk N                windows handed to a thread at a time (default 256)\n"
+        "  --quiet                  report only the totals\n";
+
+
+static void report(const segments::batch_progress& progress, bool last) {
+    const auto seconds = progress.elapsed.count();
+    const auto rate = seconds > 0.0 ? double(progress.windows) / seconds : 0.0;
+    std::fprintf(stderr, "\r%zu/%zu windows (%.1f%%), %zu segments, %.1f s, %.0f windows/s%s",
+                 progress.windows, progress.total_windows,
+                 progress.total_windows != 0 ? 100.0 * double(progress.windows) / double(progress.total_windows) : 100.0,
+                 progress.segments, seconds, rate, last ? "\n" : "");
+    std::fflush(stderr);
+}
+
+
+int main(int argc, char** argv) {
+    segments::batch_options options{-1};
+    segments::window_predicate_t predicate;
+    bool has_trim = false;
+    bool quiet = false;
+    std::string paths[2];
+    int path_count = 0;
+
+    try {
+        auto next = [&](int& i) -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(std::string(argv[i]) + " requires a value");
+            }
+            return argv[++i];
+        };
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            if (arg == "--threshold") {
+                const auto lower = std::stod(next(i));
+                const auto upper = std::stod(next(i));
+                predicate = segments::threshold_predicate(lower, upper);
+            } else if (arg == "--runs") {
+                predicate = segments::run_predicate();
+            } else if (arg == "--tolerance") {
+                options.trim_tolerance = std::stoi(next(i));
+                has_trim = true;
+            } else if (arg == "--signal-tolerance") {
+                options.signal_tolerance = std::stoi(next(i));
+            } else if (arg == "--start-depth") {
+                options.start_depth = std::stoi(next(i));
+            } else if (arg == "--threads") {
+                options.threads = static_cast<unsigned>(std::stoul(next(i)));
+            } else if (arg == "--chunk") {
+                options.chunk_size = std::stoul(next(i));
+            } else if (arg == "--quiet") {
+                quiet = true;
+            } else if (arg == "--help" || arg == "-h") {
+                std::cout << usage;
+                return 0;
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                throw std::invalid_argument("unknown option " + arg);
+            } else if (path_count < 2) {
+                paths[path_count++] = arg;
+            } else {
+                throw std::invalid_argument("unexpected argument " + arg);
+            }
+        }
+
+        if (path_count != 2 || options.signal_tolerance < 0) {
+            throw std::invalid_argument("an input, an output and a signal tolerance are required");
+        }
+        if (!has_trim) {
+            options.trim_tolerance = options.signal_tolerance;
+        }
+        if (!predicate) {
+            throw std::invalid_argument("one of --threshold and --runs is required");
+        }
+    } catch (const std::exception& err) {
+        std::cerr << "segment_batch: " << err.what() << "\n\n" << usage;
+        return 2;
+    }
+
+    try {
+        segments::BatchInput input(paths[0]);
+        segments::BatchOutputWriter output(paths[1], input.size());
+
+        std::function<void(const segments::batch_progress&)> progress;
+        if (!quiet) {
+            progress = [](const segments::batch_progress& progress) {
+                report(progress, progress.windows == progress.total_windows);
+            };
+        }
+
+        auto totals = segments::segment_batch(input, predicate, options, output, progress);
+        if (quiet) {
+            report(totals, true);
+        }
+    } catch (const std::exception& err) {
+        std::cerr << "\nsegment_batch: " << err.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -5,10 +5,65 @@ This module provide Python classes that represent intervals and dyadic
 intervals, and a routine for performing segmentation of an interval
 according to a characteristic function.
 """
+from contextlib import contextmanager
+
 from pysegments._segments import *
 
 
+@contextmanager
+def trace(path):
+    """
+    Record the timeline of every search run inside the block to path as
+    Chrome trace-event JSON, which can be opened in Perfetto
+    (ui.perfetto.dev) or chrome://tracing.
+    """
+    start_trace(path)
+    try:
+        yield
+    finally:
+        stop_trace()
+
+
 __all__ = [
     "Interval",
+    "DyadicInterval",
+    "IntervalView",
+    "NativePredicate",
+    "NativePredicate2D",
+    "PredicateCache",
+    "all_of",
+    "any_of",
+    "negate",
+    "compile_predicate",
+    "AggregateTree",
     "segment",
+    "segment_dyadic",
+    "any_segment",
+    "first_segment",
+    "count_segments",
+    "segment_measure",
+    "segment_pyramid",
+    "segment_stream",
+    "segment2d",
+    "segment_runs",
+    "segment_vectorised",
+    "segment_many",
+    "SegmentStream",
+    "SegmentIndex",
+    "ShardPlan",
+    "plan_shards",
+    "segment_shard",
+    "stitch_shards",
+    "record_trace",
+    "replay_trace",
+    "trace",
+    "start_trace",
+    "stop_trace",
+    "to_dyadic_intervals",
+    "dyadic_bracket",
+    "dyadic_parent",
+    "dyadic_children",
+    "dyadic_contains",
+    "dyadic_argsort",
+    "dyadic_sort",
 ]
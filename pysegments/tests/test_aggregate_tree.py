@@ -0,0 +1,58 @@
+import math
+
+import numpy as np
+import pytest
+
+from pysegments import AggregateTree, DyadicInterval, Interval, NativePredicate, segment
+
+
+def make_samples():
+    rng = np.random.default_rng(7)
+    positions = np.sort(rng.uniform(0.0, 10.0, 4000))
+    values = np.sin(positions) + rng.normal(0.0, 0.1, positions.shape)
+    return positions, values
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_query_matches_numpy():
+    positions, values = make_samples()
+    tree = AggregateTree(positions, values, 6)
+
+    probe = DyadicInterval(3, 2).to_interval()
+    mask = (probe.inf <= positions) & (positions < probe.sup)
+    found = tree.query(probe)
+    assert found["count"] == mask.sum()
+    assert found["min"] == values[mask].min()
+    assert found["max"] == values[mask].max()
+    assert found["mean"] == pytest.approx(values[mask].mean())
+    assert found["variance"] == pytest.approx(values[mask].var())
+
+    empty = tree.query(DyadicInterval(-1, 0).to_interval())
+    assert empty["count"] == 0
+    assert math.isnan(empty["mean"])
+
+
+def test_within_matches_python_predicate():
+    positions, values = make_samples()
+    tree = AggregateTree(positions, values, 10)
+
+    def spread_ok(ivl):
+        mask = (ivl.inf <= positions) & (positions < ivl.sup)
+        return bool(mask.any()) and values[mask].max() <= 0.5
+
+    predicate = tree.within("max", upper=0.5)
+    assert isinstance(predicate, NativePredicate)
+
+    base = Interval(0.0, 10.0)
+    assert as_pairs(segment(base, predicate, 10)) == as_pairs(segment(base, spread_ok, 10))
+
+
+def test_errors():
+    with pytest.raises(ValueError):
+        AggregateTree([1.0, 0.0], [1.0, 2.0], 4)
+    tree = AggregateTree([0.0], [1.0], 4)
+    with pytest.raises(ValueError):
+        tree.within("median", 0.0, 1.0)
@@ -0,0 +1,149 @@
+import numpy as np
+import pytest
+
+from pysegments import (
+    Interval,
+    DyadicInterval,
+    to_dyadic_intervals,
+    dyadic_bracket,
+    dyadic_parent,
+    dyadic_children,
+    dyadic_contains,
+    dyadic_argsort,
+    dyadic_sort,
+)
+
+
+def test_dyadic_interval_endpoints():
+    di = DyadicInterval(3, 2)
+
+    assert di.k == 3
+    assert di.n == 2
+    assert di.inf == 0.75
+    assert di.sup == 1.0
+
+
+def test_dyadic_interval_bracket():
+    di = DyadicInterval.bracket(0.3, 2)
+
+    assert di == DyadicInterval(1, 2)
+    assert di.contains(0.3)
+    assert not di.contains(0.5)
+
+
+def test_dyadic_interval_parent_children():
+    di = DyadicInterval(3, 2)
+    left, right = di.parent().children()
+
+    assert di.parent() == DyadicInterval(1, 1)
+    assert left == DyadicInterval(2, 2)
+    assert right == di
+    assert di.parent().contains(di)
+
+
+def test_dyadic_interval_tree_order():
+    ivls = [DyadicInterval(1, 1), DyadicInterval(0, 2), DyadicInterval(0, 1), DyadicInterval(1, 2)]
+
+    assert sorted(ivls) == [DyadicInterval(0, 1), DyadicInterval(0, 2),
+                            DyadicInterval(1, 2), DyadicInterval(1, 1)]
+
+
+def test_dyadic_interval_hashable():
+    assert len({DyadicInterval(1, 2), DyadicInterval(1, 2), DyadicInterval(2, 2)}) == 2
+
+
+def test_to_dyadic_intervals_scalar():
+    dis = to_dyadic_intervals(Interval(0.25, 1.0), 3)
+
+    assert dis == [DyadicInterval(1, 2), DyadicInterval(1, 1)]
+
+
+def test_dyadic_bracket_array():
+    values = np.array([0.0, 0.3, 0.74, -0.1])
+    k = dyadic_bracket(values, 2)
+
+    assert k.tolist() == [0, 1, 2, -1]
+
+
+def test_dyadic_bracket_overflow():
+    with pytest.raises(OverflowError):
+        dyadic_bracket(np.array([1.0e10]), 2)
+
+
+def test_dyadic_parent_children_arrays():
+    k = np.array([0, 1, 2, 3])
+
+    pk, pn = dyadic_parent(k, 2)
+    assert pk.tolist() == [0, 0, 1, 1]
+    assert pn.tolist() == [1, 1, 1, 1]
+
+    lk, rk, cn = dyadic_children(pk, pn)
+    assert lk.tolist() == [0, 0, 2, 2]
+    assert rk.tolist() == [1, 1, 3, 3]
+    assert cn.tolist() == [2, 2, 2, 2]
+
+
+def test_dyadic_contains_arrays():
+    result = dyadic_contains(0, 0, np.array([0, 1, 4, -1]), 2)
+
+    assert result.tolist() == [True, True, False, False]
+
+
+def test_dyadic_sort_matches_tree_order():
+    k = np.array([1, 0, 0, 1])
+    n = np.array([1, 2, 1, 2])
+
+    order = dyadic_argsort(k, n)
+    sk, sn = dyadic_sort(k, n)
+
+    assert order.tolist() == [2, 1, 3, 0]
+    assert list(zip(sk.tolist(), sn.tolist())) == [(0, 1), (0, 2), (1, 2), (1, 1)]
+
+
+def test_to_dyadic_intervals_batch():
+    infs = np.array([0.25, 0.0])
+    sups = np.array([1.0, 0.5])
+
+    k, n, offsets = to_dyadic_intervals(infs, sups, 3)
+
+    assert offsets.tolist() == [0, 2, 3]
+    assert list(zip(k.tolist(), n.tolist())) == [(1, 2), (1, 1), (0, 1)]
+
+
+def test_arrays_must_have_matching_shapes():
+    k = np.zeros((2, 3), dtype=np.int32)
+    n = np.zeros((3, 2), dtype=np.int32)
+
+    with pytest.raises(ValueError):
+        dyadic_parent(k, n)
+    with pytest.raises(ValueError):
+        dyadic_contains(k, n, k, 2)
+
+    pk, pn = dyadic_parent(k, n.reshape(1, 2, 3))
+    assert pk.shape == (1, 2, 3)
+
+
+def test_comparisons_reject_unrepresentable_rescaling():
+    with pytest.raises(ValueError):
+        dyadic_contains(0, 0, np.array([0, 1]), 40)
+    with pytest.raises(ValueError):
+        dyadic_contains(1 << 20, 0, 0, 20)
+    with pytest.raises(ValueError):
+        dyadic_argsort(np.array([1, 0]), np.array([0, 35]))
+    with pytest.raises(ValueError):
+        DyadicInterval(0, 0) < DyadicInterval(0, 31)
+    with pytest.raises(ValueError):
+        dyadic_children(np.array([1 << 30]), 0)
+
+    # A coarser inner interval is never contained, at any depth difference.
+    assert not dyadic_contains(0, 40, 0, 0)
+    assert dyadic_contains(0, 0, np.array([3, -1]), 29).tolist() == [True, False]
+
+
+def test_to_dyadic_intervals_rejects_unrepresentable_bounds():
+    with pytest.raises(ValueError):
+        to_dyadic_intervals(np.array([1.0]), np.array([0.0]), 3)
+    with pytest.raises(OverflowError):
+        to_dyadic_intervals(np.array([0.0]), np.array([1.0e10]), 3)
+    with pytest.raises(OverflowError):
+        to_dyadic_intervals(Interval(0.0, 1.0), 40)
@@ -0,0 +1,49 @@
+import numpy as np
+import pytest
+
+from pysegments import Interval, NativePredicate, compile_predicate, segment
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_readme_expression_matches_callable():
+    base = Interval(-5.0, 5.0)
+    predicate = compile_predicate("inf >= 0.3 and sup <= 0.752")
+
+    assert isinstance(predicate, NativePredicate)
+    expected = segment(base, lambda ivl: ivl.inf >= 0.3 and ivl.sup <= 0.752, 2)
+    assert as_pairs(segment(base, predicate, 2)) == as_pairs(expected)
+
+
+def test_constants_are_bound_by_keyword():
+    base = Interval(0.0, 10.0)
+    predicate = compile_predicate("lo <= inf and sup <= hi", lo=0.234, hi=0.9523)
+
+    expected = segment(base, lambda ivl: 0.234 <= ivl.inf and ivl.sup <= 0.9523, 8)
+    assert as_pairs(segment(base, predicate, 8)) == as_pairs(expected)
+
+
+def test_range_aggregates_match_numpy():
+    positions = np.linspace(0.0, 10.0, 2000, endpoint=False)
+    values = np.sin(positions * 3.0) + 0.2 * np.cos(positions * 17.0)
+
+    def spread_ok(ivl):
+        mask = (ivl.inf <= positions) & (positions < ivl.sup)
+        return mask.any() and values[mask].max() - values[mask].min() <= 1.0
+
+    predicate = compile_predicate("max(x) - min(x) <= 1.0", x=(positions, values))
+    base = Interval(0.0, 10.0)
+    assert as_pairs(segment(base, predicate, 8)) == as_pairs(segment(base, spread_ok, 8))
+
+
+def test_errors():
+    with pytest.raises(ValueError):
+        compile_predicate("inf >=")
+    with pytest.raises(ValueError):
+        compile_predicate("inf >= lo")
+    with pytest.raises(ValueError):
+        compile_predicate("inf >= lo", hi=1.0)
+    with pytest.raises(ValueError):
+        compile_predicate("mean(x) > 0", x=([1.0, 0.0], [1.0, 2.0]))
@@ -0,0 +1,57 @@
+from pysegments import Interval, IntervalView, segment, segment_dyadic
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_reuse_matches_fresh_intervals():
+    base = Interval(0.0, 10.0)
+
+    fresh = segment(base, in_character_fn, 8)
+    reused = segment(base, in_character_fn, 8, reuse_interval=True)
+
+    assert as_pairs(reused) == as_pairs(fresh)
+
+
+def test_reuse_dyadic_matches_fresh_intervals():
+    base = Interval(0.0, 10.0)
+
+    fresh = segment_dyadic(base, in_character_fn, 8)
+    reused = segment_dyadic(base, in_character_fn, 8, reuse_interval=True)
+
+    for a, b in zip(fresh, reused):
+        assert list(a) == list(b)
+
+
+def test_predicate_receives_single_view():
+    seen = set()
+    probes = []
+
+    def predicate(view):
+        seen.add(id(view))
+        probes.append(view.to_interval())
+        return view.contains(0.5)
+
+    segment(Interval(0.0, 1.0), predicate, 4, reuse_interval=True)
+
+    assert len(seen) == 1
+    assert len(probes) > 1
+    assert all(isinstance(probe, Interval) for probe in probes)
+
+
+def test_view_is_an_interval_view():
+    kinds = set()
+
+    def predicate(view):
+        kinds.add(type(view))
+        return True
+
+    segment(Interval(0.0, 1.0), predicate, 2, reuse_interval=True)
+
+    assert kinds == {IntervalView}
@@ -0,0 +1,83 @@
+import ctypes
+
+import numpy as np
+import pytest
+
+from pysegments import Interval, NativePredicate, segment, segment_dyadic
+
+
+PREDICATE_TYPE = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+@PREDICATE_TYPE
+def native_in_character_fn(inf, sup, data):
+    return in_character_fn(Interval(inf, sup))
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_ctypes_matches_python():
+    base = Interval(0.0, 10.0)
+    predicate = NativePredicate(native_in_character_fn)
+
+    assert as_pairs(segment(base, predicate, 8)) == as_pairs(segment(base, in_character_fn, 8))
+
+
+def test_address_matches_ctypes():
+    base = Interval(0.0, 10.0)
+    address = ctypes.cast(native_in_character_fn, ctypes.c_void_p).value
+
+    assert as_pairs(segment(base, NativePredicate(address), 8)) \
+        == as_pairs(segment(base, NativePredicate(native_in_character_fn), 8))
+
+
+def test_user_data_is_passed():
+    bounds = np.array([0.234, 0.9523])
+
+    @PREDICATE_TYPE
+    def within(inf, sup, data):
+        lo, hi = ctypes.cast(data, ctypes.POINTER(ctypes.c_double))[0:2]
+        return lo <= inf and sup <= hi
+
+    found = segment(Interval(0.0, 1.0), NativePredicate(within, bounds), 8)
+    assert len(found) == 1
+    assert found[0].inf >= 0.234
+    assert found[0].sup <= 0.9523
+
+
+def test_segment_dyadic_native():
+    base = Interval(0.0, 10.0)
+    expected = segment_dyadic(base, in_character_fn, 8)
+    found = segment_dyadic(base, NativePredicate(native_in_character_fn), 8)
+
+    for lhs, rhs in zip(found, expected):
+        assert np.array_equal(lhs, rhs)
+
+
+def test_call():
+    predicate = NativePredicate(native_in_character_fn)
+    assert predicate(Interval(0.5, 0.75))
+    assert not predicate(Interval(0.0, 0.75))
+
+
+def test_null_address():
+    with pytest.raises(ValueError):
+        NativePredicate(0)
+
+
+def test_numba_cfunc():
+    numba = pytest.importorskip("numba")
+
+    @numba.cfunc(numba.types.boolean(numba.types.float64, numba.types.float64, numba.types.voidptr))
+    def compiled(inf, sup, data):
+        return (0.234 <= inf and sup <= 0.9523) or (4.925 <= inf and sup <= 5.995)
+
+    base = Interval(0.0, 10.0)
+    assert as_pairs(segment(base, NativePredicate(compiled), 8)) == as_pairs(segment(base, in_character_fn, 8))
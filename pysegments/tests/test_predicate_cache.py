@@ -0,0 +1,56 @@
+import pytest
+
+from pysegments import Interval, PredicateCache, segment
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_cached_matches_uncached():
+    cache = PredicateCache(4096)
+    base = Interval(0.0, 10.0)
+
+    assert as_pairs(segment(base, in_character_fn, 8, cache=cache)) == as_pairs(segment(base, in_character_fn, 8))
+    assert len(cache) == cache.misses
+
+
+def test_overlapping_windows_reuse_results():
+    cache = PredicateCache(1 << 16)
+    calls = []
+
+    def predicate(interval):
+        calls.append(interval)
+        return in_character_fn(interval)
+
+    segment(Interval(0.0, 6.0), predicate, 8, cache=cache)
+    calls.clear()
+    result = segment(Interval(0.5, 6.5), predicate, 8, cache=cache)
+
+    assert as_pairs(result) == as_pairs(segment(Interval(0.5, 6.5), in_character_fn, 8))
+    assert cache.hits > len(calls)
+
+
+def test_invalidate():
+    cache = PredicateCache(1024, "fifo")
+    segment(Interval(0.0, 10.0), in_character_fn, 4, cache=cache)
+    size = len(cache)
+
+    cache.invalidate(Interval(0.0, 1.0))
+    assert 0 < len(cache) < size
+
+    cache.invalidate()
+    assert len(cache) == 0
+    assert cache.policy == "fifo"
+
+
+def test_bad_arguments():
+    with pytest.raises(ValueError):
+        PredicateCache(16, "random")
+    with pytest.raises(ValueError):
+        PredicateCache(0)
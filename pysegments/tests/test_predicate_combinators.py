@@ -0,0 +1,70 @@
+import ctypes
+from concurrent.futures import ThreadPoolExecutor
+
+import pytest
+
+from pysegments import Interval, NativePredicate, all_of, any_of, negate, segment
+
+
+PREDICATE_TYPE = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+def left_half(interval):
+    return interval.sup <= 5.0
+
+
+@PREDICATE_TYPE
+def native_left_half(inf, sup, data):
+    return sup <= 5.0
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_all_of_matches_conjunction():
+    base = Interval(0.0, 10.0)
+    combined = all_of(in_character_fn, negate(NativePredicate(native_left_half)), reorder_interval=8)
+
+    expected = segment(base, lambda ivl: in_character_fn(ivl) and not left_half(ivl), 8)
+    assert as_pairs(segment(base, combined, 8)) == as_pairs(expected)
+
+
+def test_any_of_matches_disjunction():
+    base = Interval(0.0, 10.0)
+    combined = any_of(NativePredicate(native_left_half), in_character_fn)
+
+    expected = segment(base, lambda ivl: left_half(ivl) or in_character_fn(ivl), 8)
+    assert as_pairs(segment(base, combined, 8)) == as_pairs(expected)
+
+
+def test_combined_is_callable():
+    combined = all_of(left_half, in_character_fn)
+
+    assert combined(Interval(0.25, 0.5))
+    assert not combined(Interval(5.0, 5.5))
+
+
+def test_rejects_non_callables():
+    with pytest.raises(TypeError):
+        all_of(left_half, 3)
+
+
+def test_nested_combinators_are_shared_between_threads():
+    base = Interval(0.0, 10.0)
+    inner = any_of(NativePredicate(native_left_half), in_character_fn, reorder_interval=2)
+    combined = all_of(inner, negate(NativePredicate(native_left_half)), reorder_interval=2)
+    expected = as_pairs(segment(base, combined, 10))
+
+    def search(predicate):
+        return as_pairs(segment(base, predicate, 10))
+
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        found = list(pool.map(search, [combined, inner] * 8))
+    assert found[0::2] == [expected] * 8
+    assert found[1::2] == [search(inner)] * 8
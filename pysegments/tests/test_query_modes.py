@@ -0,0 +1,53 @@
+import ctypes
+
+import pytest
+
+from pysegments import Interval, NativePredicate, any_segment, count_segments, first_segment, segment, \
+    segment_measure
+
+
+PREDICATE_TYPE = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+@PREDICATE_TYPE
+def native_in_character_fn(inf, sup, data):
+    return in_character_fn(Interval(inf, sup))
+
+
+@pytest.mark.parametrize("predicate", [in_character_fn, NativePredicate(native_in_character_fn)])
+@pytest.mark.parametrize("signal", [2, 4, 8])
+def test_queries_match_segment(predicate, signal):
+    base = Interval(0.0, 10.0)
+    expected = segment(base, in_character_fn, 10, signal)
+
+    assert any_segment(base, predicate, 10, signal) == bool(expected)
+    assert count_segments(base, predicate, 10, signal) == len(expected)
+    assert segment_measure(base, predicate, 10, signal) == pytest.approx(sum(s.sup - s.inf for s in expected))
+
+    first = first_segment(base, predicate, 10, signal)
+    if expected:
+        leftmost = min(expected, key=lambda s: s.inf)
+        assert (first.inf, first.sup) == (leftmost.inf, leftmost.sup)
+    else:
+        assert first is None
+
+
+def test_any_segment_stops_early():
+    calls = []
+
+    def counting(interval):
+        calls.append(interval)
+        return interval.sup <= 2.0
+
+    assert any_segment(Interval(0.0, 8.0), counting, 20, 10)
+    assert len(calls) == 1
+
+
+def test_rejects_non_callables():
+    with pytest.raises(TypeError):
+        any_segment(Interval(0.0, 1.0), 3, 4)
@@ -1,7 +1,7 @@
 import pytest
 
 
-from pysegments import segment, Interval
+from pysegments import segment, segment_dyadic, Interval
 
 
 INTERVALS = (
@@ -46,3 +46,43 @@ def test_segment_function_resolution_5():
     segments = segment(test_interval, in_character_fn, 5)
 
     assert len(segments) == 2
+
+
+@pytest.mark.parametrize("start_depth", [None, -3, 2, "auto"])
+def test_segment_start_depth(start_depth):
+    test_interval = Interval(0, 15.2)
+    segments = segment(test_interval, in_character_fn, 5, start_depth=start_depth)
+
+    assert len(segments) == 2
+
+
+def test_segment_adaptive_start_probes_fewer():
+    probes = {"default": 0, "auto": 0}
+
+    def counting(key):
+        def fn(interval):
+            probes[key] += 1
+            return 0.0 <= interval.inf and interval.sup <= 4096.0
+        return fn
+
+    segment(Interval(0.0, 4096.0), counting("default"), 0)
+    segment(Interval(0.0, 4096.0), counting("auto"), 0, start_depth="auto")
+
+    assert probes["auto"] == 1
+    assert probes["default"] == 4096
+
+
+def test_segment_start_depth_invalid():
+    with pytest.raises(ValueError):
+        segment(Interval(0, 1), in_character_fn, 2, start_depth="coarse")
+
+
+def test_segment_dyadic_endpoints():
+    test_interval = Interval(0, 15.2)
+    segments = segment(test_interval, in_character_fn, 5)
+    inf_k, inf_n, sup_k, sup_n = segment_dyadic(test_interval, in_character_fn, 5)
+
+    assert len(inf_k) == len(segments)
+    for ivl, ik, i_n, sk, sn in zip(segments, inf_k, inf_n, sup_k, sup_n):
+        assert ivl.inf == ik * 2.0 ** -i_n
+        assert ivl.sup == sk * 2.0 ** -sn
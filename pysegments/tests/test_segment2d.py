@@ -0,0 +1,49 @@
+import ctypes
+
+import numpy as np
+
+from pysegments import Interval, NativePredicate2D, segment2d
+
+
+def in_box(x_inf, x_sup, y_inf, y_sup):
+    return (0.1 <= x_inf) & (x_sup <= 0.83) & (0.27 <= y_inf) & (y_sup <= 0.6)
+
+
+def area(squares):
+    return float(((squares[:, 1] - squares[:, 0]) * (squares[:, 3] - squares[:, 2])).sum())
+
+
+def test_scalar_predicate():
+    squares = segment2d(Interval(0, 1), Interval(0, 1), in_box, 6, 4)
+
+    assert squares.shape[1] == 4
+    assert all(in_box(*square) for square in squares)
+    assert 0.0 < area(squares) <= 0.73 * 0.33
+
+
+def test_vectorised_matches_scalar():
+    scalar = segment2d(Interval(0, 1), Interval(0, 1), in_box, 6, 4)
+    vectorised = segment2d(Interval(0, 1), Interval(0, 1), in_box, 6, 4, vectorised=True)
+
+    assert np.array_equal(scalar, vectorised)
+
+
+def test_native_matches_scalar():
+    predicate_type = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double,
+                                      ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+    @predicate_type
+    def native_in_box(x_inf, x_sup, y_inf, y_sup, data):
+        return bool(in_box(x_inf, x_sup, y_inf, y_sup))
+
+    scalar = segment2d(Interval(0, 1), Interval(0, 1), in_box, 6, 4)
+    native = segment2d(Interval(0, 1), Interval(0, 1), NativePredicate2D(native_in_box), 6, 4)
+
+    assert np.array_equal(scalar, native)
+
+
+def test_clipped_to_base():
+    squares = segment2d(Interval(0.1, 0.7), Interval(-0.2, 0.3), lambda *bounds: True, 2)
+
+    assert np.isclose(area(squares), 0.6 * 0.5)
+    assert squares[:, 0].min() >= 0.1 and squares[:, 1].max() <= 0.7
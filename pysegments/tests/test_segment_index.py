@@ -0,0 +1,58 @@
+import numpy as np
+import pytest
+
+from pysegments import Interval, SegmentIndex, segment
+
+
+@pytest.fixture
+def index():
+    return SegmentIndex([Interval(0.625, 0.75), Interval(0.125, 0.25), Interval(0.875, 1.0)])
+
+
+def test_index_sorted(index):
+    assert len(index) == 3
+    assert [ivl.inf for ivl in index.segments] == [0.125, 0.625, 0.875]
+    assert index[-1].sup == 1.0
+
+
+def test_index_rejects_overlapping():
+    with pytest.raises(ValueError):
+        SegmentIndex([Interval(0.0, 0.5), Interval(0.25, 1.0)])
+
+
+def test_locate_scalar(index):
+    assert index.locate(0.2) == 0
+    assert index.locate(0.5) == -1
+    assert index.contains(0.7)
+    assert not index.contains(0.75)
+
+
+def test_locate_array(index):
+    points = np.array([0.0, 0.125, 0.3, 0.7, 0.9, 1.0])
+
+    assert index.locate(points).tolist() == [-1, 0, -1, 1, 2, -1]
+    assert index.locate(points[::-1].copy()).tolist() == [-1, 2, 1, -1, 0, -1]
+    assert index.contains(points).tolist() == [False, True, False, True, True, False]
+
+
+def test_locate_sorted_hint_matches(index):
+    points = np.linspace(0.0, 1.0, 1001)
+
+    assert (index.locate(points, sorted=True) == index.locate(points, sorted=False)).all()
+
+
+def test_overlapping(index):
+    assert index.overlapping(Interval(0.2, 0.7)) == (0, 2)
+
+    first, last = index.overlapping(np.array([0.0, 0.3]), np.array([0.2, 0.9]))
+    assert first.tolist() == [0, 1]
+    assert last.tolist() == [1, 3]
+
+
+def test_index_from_segment_result():
+    def predicate(ivl):
+        return ivl.inf >= 0.25 and ivl.sup <= 0.75
+
+    index = SegmentIndex(segment(Interval(0.0, 1.0), predicate, 3))
+
+    assert index.locate(np.array([0.1, 0.5])).tolist() == [-1, 0]
@@ -0,0 +1,56 @@
+import ctypes
+
+import pytest
+
+from pysegments import Interval, NativePredicate, all_of, segment, segment_many
+
+
+PREDICATE_TYPE = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+@PREDICATE_TYPE
+def native_in_character_fn(inf, sup, data):
+    return in_character_fn(Interval(inf, sup))
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+BASES = [Interval(float(i), float(i + 3)) for i in range(8)]
+
+
+@pytest.mark.parametrize("threads", [0, 1, 4])
+def test_matches_segment(threads):
+    found = segment_many(BASES, in_character_fn, 8, threads=threads)
+    assert [as_pairs(ivls) for ivls in found] == [as_pairs(segment(base, in_character_fn, 8)) for base in BASES]
+
+
+@pytest.mark.parametrize("predicate", [
+    NativePredicate(native_in_character_fn),
+    all_of(NativePredicate(native_in_character_fn), in_character_fn),
+])
+def test_native_matches_segment(predicate):
+    found = segment_many(BASES, predicate, 8, 4, threads=4)
+    assert [as_pairs(ivls) for ivls in found] == [as_pairs(segment(base, in_character_fn, 8, 4)) for base in BASES]
+
+
+def test_errors_propagate():
+    def failing(interval):
+        if interval.inf >= 5.0:
+            raise KeyError("too far")
+        return True
+
+    with pytest.raises(KeyError):
+        segment_many(BASES, failing, 4, threads=4)
+    with pytest.raises(TypeError):
+        segment_many(BASES, 3, 4)
+
+
+def test_empty():
+    assert segment_many([], in_character_fn, 4) == []
@@ -0,0 +1,37 @@
+from pysegments import Interval, segment, segment_pyramid
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_levels_match_segment():
+    base = Interval(0.0, 10.0)
+
+    levels = segment_pyramid(base, in_character_fn, [2, 6, 10])
+
+    assert sorted(levels) == [2, 6, 10]
+    for tol, found in levels.items():
+        assert as_pairs(found) == as_pairs(segment(base, in_character_fn, 10, tol))
+
+
+def test_fewer_probes_than_separate_searches():
+    base = Interval(0.0, 10.0)
+    counts = {"pyramid": 0, "separate": 0}
+
+    def counting(key):
+        def fn(interval):
+            counts[key] += 1
+            return in_character_fn(interval)
+        return fn
+
+    segment_pyramid(base, counting("pyramid"), [4, 8, 12])
+    for tol in (4, 8, 12):
+        segment(base, counting("separate"), 12, tol)
+
+    assert counts["pyramid"] < counts["separate"]
@@ -0,0 +1,37 @@
+import numpy as np
+import pytest
+
+from pysegments import Interval, segment, segment_runs
+
+
+STARTS = np.array([0.234, 1.042, 2.852, 4.925, 6.013])
+ENDS = np.array([0.9523, 1.093, 3.401, 5.995, 6.521])
+
+
+def in_runs(interval):
+    return any(s <= interval.inf and interval.sup <= e for s, e in zip(STARTS, ENDS))
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+@pytest.mark.parametrize("tolerance", [0, 3, 8, 12])
+def test_matches_segment(tolerance):
+    base = Interval(0.0, 10.0)
+
+    assert as_pairs(segment_runs(base, STARTS, ENDS, tolerance)) == as_pairs(segment(base, in_runs, tolerance))
+
+
+def test_threads_sorted():
+    base = Interval(0.0, 10.0)
+
+    expected = sorted(as_pairs(segment(base, in_runs, 8, 10)))
+    assert as_pairs(segment_runs(base, STARTS, ENDS, 10, 8, threads=4)) == expected
+
+
+def test_bad_runs():
+    with pytest.raises(ValueError):
+        segment_runs(Interval(0.0, 1.0), STARTS, ENDS[:2], 4)
+    with pytest.raises(ValueError):
+        segment_runs(Interval(0.0, 1.0), STARTS[::-1], ENDS[::-1], 4)
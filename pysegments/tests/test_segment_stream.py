@@ -0,0 +1,65 @@
+import ctypes
+from concurrent.futures import ThreadPoolExecutor
+
+from pysegments import Interval, NativePredicate, all_of, segment, segment_stream
+
+
+PREDICATE_TYPE = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_double, ctypes.c_double, ctypes.c_void_p)
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (3.791 <= interval.inf and interval.sup <= 4.411) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+@PREDICATE_TYPE
+def native_in_character_fn(inf, sup, data):
+    return in_character_fn(Interval(inf, sup))
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_stream_matches_segment():
+    base = Interval(0.0, 10.0)
+
+    assert as_pairs(segment_stream(base, in_character_fn, 8)) \
+        == sorted(as_pairs(segment(base, in_character_fn, 8)))
+
+
+def test_stream_is_lazy():
+    probes = []
+
+    def counting(interval):
+        probes.append(interval)
+        return in_character_fn(interval)
+
+    stream = segment_stream(Interval(0.0, 10.0), counting, 8)
+    first = next(stream)
+    probes_to_first = len(probes)
+    rest = list(stream)
+
+    assert first.sup < 1.0
+    assert len(rest) == 2
+    assert probes_to_first < len(probes)
+
+
+def test_exhausted_stream():
+    stream = segment_stream(Interval(0.0, 1.0), lambda ivl: False, 3)
+    assert list(stream) == []
+    assert list(stream) == []
+
+
+def test_stream_shared_between_threads():
+    base = Interval(0.0, 10.0)
+    predicate = all_of(NativePredicate(native_in_character_fn), in_character_fn)
+    stream = segment_stream(base, predicate, 8)
+
+    def drain(_):
+        return as_pairs(stream)
+
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        found = [pair for pairs in pool.map(drain, range(4)) for pair in pairs]
+    assert sorted(found) == sorted(as_pairs(segment(base, in_character_fn, 8)))
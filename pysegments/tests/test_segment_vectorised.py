@@ -0,0 +1,53 @@
+import numpy as np
+import pytest
+
+from pysegments import Interval, segment, segment_vectorised
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+def vectorised_fn(inf, sup):
+    return ((0.234 <= inf) & (sup <= 0.9523)) | ((4.925 <= inf) & (sup <= 5.995))
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+@pytest.mark.parametrize("engine", ["auto", "bottom_up", "top_down"])
+@pytest.mark.parametrize("signal, trim", [(4, 4), (8, 8), (4, 12)])
+def test_engines_match_segment(engine, signal, trim):
+    base = Interval(0.0, 10.0)
+    expected = segment(base, in_character_fn, trim, signal)
+    found = segment_vectorised(base, vectorised_fn, trim, signal, engine=engine, batch_size=100)
+    assert as_pairs(found) == as_pairs(expected)
+
+
+def test_default_engine_allows_any_predicate():
+    # True on long intervals only, so not decided by the finest intervals.
+    base = Interval(0.0, 10.0)
+    expected = segment(base, lambda ivl: ivl.sup - ivl.inf >= 0.5, 4)
+    found = segment_vectorised(base, lambda inf, sup: sup - inf >= 0.5, 4)
+    assert as_pairs(found) == as_pairs(expected)
+
+
+def test_bottom_up_batches():
+    calls = []
+
+    def counting(inf, sup):
+        calls.append(len(inf))
+        return vectorised_fn(inf, sup)
+
+    segment_vectorised(Interval(0.0, 10.0), counting, 8, engine="bottom_up", batch_size=1000)
+    assert sum(calls) == 10 * 256
+    assert max(calls) == 1000
+
+
+def test_errors():
+    with pytest.raises(ValueError):
+        segment_vectorised(Interval(0.0, 1.0), vectorised_fn, 4, engine="sideways")
+    with pytest.raises(ValueError):
+        segment_vectorised(Interval(0.0, 1.0), lambda inf, sup: np.ones(1, dtype=bool), 4, engine="bottom_up")
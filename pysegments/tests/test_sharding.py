@@ -0,0 +1,59 @@
+import pickle
+from multiprocessing import Pool
+
+from pysegments import Interval, segment, plan_shards, segment_shard, stitch_shards
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 3.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995) \
+        or (7.5 <= interval.inf and interval.sup <= 12.25)
+
+
+def search_shard(job):
+    plan, shard = job
+    return segment_shard(plan, shard, in_character_fn)
+
+
+def as_pairs(ivls):
+    return [(ivl.inf, ivl.sup) for ivl in ivls]
+
+
+def test_plan_is_aligned():
+    plan = plan_shards(Interval(0.3, 10.7), 4, 6)
+
+    assert len(plan) == 4
+    assert plan.shards[0].inf == 0.3
+    assert plan.shards[-1].sup == 10.7
+    for left, right in zip(plan.shards, plan.shards[1:]):
+        assert left.sup == right.inf
+        assert right.inf == int(right.inf)
+
+
+def test_stitched_matches_segment():
+    base = Interval(-0.7, 16.3)
+    expected = sorted(as_pairs(segment(base, in_character_fn, 8)))
+
+    for count in range(1, 9):
+        plan = plan_shards(base, count, 8)
+        results = [segment_shard(plan, i, in_character_fn) for i in range(len(plan))]
+        assert as_pairs(stitch_shards(plan, results, in_character_fn)) == expected
+
+
+def test_plan_pickles():
+    plan = plan_shards(Interval(0.0, 16.0), 4, 8, start_depth="auto")
+    copy = pickle.loads(pickle.dumps(plan))
+
+    assert as_pairs(copy.shards) == as_pairs(plan.shards)
+    assert copy.start_depth == plan.start_depth
+
+
+def test_process_pool():
+    base = Interval(0.0, 16.0)
+    plan = plan_shards(base, 4, 8)
+
+    with Pool(2) as pool:
+        results = pool.map(search_shard, [(plan, shard) for shard in range(len(plan))])
+
+    found = stitch_shards(plan, results, in_character_fn)
+    assert as_pairs(found) == sorted(as_pairs(segment(base, in_character_fn, 8)))
@@ -0,0 +1,61 @@
+import json
+
+from pysegments import Interval, segment, record_trace, replay_trace, trace
+
+
+def in_character_fn(interval):
+    return (0.234 <= interval.inf and interval.sup <= 0.9523) \
+        or (4.925 <= interval.inf and interval.sup <= 5.995)
+
+
+def test_record_and_replay(tmp_path):
+    path = str(tmp_path / "search.trace")
+    base = Interval(0.0, 10.0)
+
+    recorded = record_trace(path, base, in_character_fn, 8)
+    expected = segment(base, in_character_fn, 8)
+    replayed = replay_trace(path)
+
+    as_pairs = lambda ivls: [(ivl.inf, ivl.sup) for ivl in ivls]
+    assert as_pairs(recorded) == as_pairs(expected)
+    assert as_pairs(replayed) == as_pairs(expected)
+
+
+def test_trace_is_compact(tmp_path):
+    path = tmp_path / "search.trace"
+    probes = []
+
+    def counting(interval):
+        probes.append(interval)
+        return in_character_fn(interval)
+
+    record_trace(str(path), Interval(0.0, 10.0), counting, 6)
+
+    assert path.stat().st_size == 40 + 9 * len(probes)
+
+
+def test_timeline_trace(tmp_path):
+    path = tmp_path / "search.json"
+
+    with trace(str(path)):
+        found = segment(Interval(0.0, 10.0), in_character_fn, 6)
+
+    events = json.loads(path.read_text())["traceEvents"]
+    names = [event["name"] for event in events]
+    assert names.count("search") == 2
+    assert names.count("expand") == 2 * len(found)
+    assert "predicate" in names
+
+
+def test_nested_search_is_not_traced(tmp_path):
+    path = tmp_path / "search.json"
+
+    def nested(interval):
+        return in_character_fn(interval) and len(segment(interval, in_character_fn, 2)) > 0
+
+    with trace(str(path)):
+        found = segment(Interval(0.0, 10.0), nested, 6)
+
+    events = json.loads(path.read_text())["traceEvents"]
+    assert [event["name"] for event in events].count("search") == 2
+    assert len(found) == 2
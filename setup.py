@@ -40,6 +40,7 @@ setup(
     package_dir={"pysegments": "pysegments"},
     cmake_args=CMAKE_SETTINGS,
     python_requires=">=3.5",
+    install_requires=["numpy"],
     tests_require=["pytest"],
     test_suite="pysegments/tests",
     classifiers=CLASSIFIERS
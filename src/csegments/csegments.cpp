@@ -0,0 +1,285 @@
+#include "csegments.h"
+
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <expanding_searcher.h>
+
+
+using namespace segments;
+
+
+struct segments_searcher
+{
+    ExpandingSearcher searcher;
+    std::vector<segments_interval> result;
+    std::vector<segments_dyadic_segment> dyadic_result;
+    std::size_t batch_size = 64;
+    std::size_t probes = 0;
+    std::string last_error;
+
+    segments_searcher(depth_t signal_tolerance, depth_t trim_tolerance, depth_t start_depth)
+        : searcher(std::max(signal_tolerance, trim_tolerance), signal_tolerance, start_depth)
+    {
+        searcher.m_record_dyadic = true;
+    }
+};
+
+
+namespace
+{
+    /*
+     * Serves the probes of a search from a batched predicate. When a probe
+     * is not in the current batch but follows straight on from it, the next
+     * batch_size intervals at its depth are evaluated in one call, stopping
+     * at the end of the base interval. The scans of the search probe
+     * consecutive intervals at one depth, so most probes are then served
+     * from the batch. Any other probe, such as the pieces of an expansion,
+     * which change depth at every step, or the first probe of a scan, is
+     * evaluated on its own, so that the lookahead is only spent on scans.
+     */
+    class BatchAdaptor
+    {
+        segments_batch_predicate_fn m_predicate;
+        void* m_user_data;
+        double m_limit;
+        std::size_t m_batch_size;
+        std::size_t& m_probes;
+
+        depth_t m_depth = 0;
+        mult_t m_first = 0;
+        std::vector<double> m_infs;
+        std::vector<double> m_sups;
+        std::unique_ptr<bool[]> m_results;
+        std::size_t m_count = 0;
+
+    public:
+        BatchAdaptor(segments_batch_predicate_fn predicate, void* user_data, double limit, std::size_t batch_size,
+                     std::size_t& probes)
+            : m_predicate(predicate), m_user_data(user_data), m_limit(limit), m_batch_size(batch_size),
+              m_probes(probes), m_results(new bool[batch_size])
+        {
+            m_infs.reserve(batch_size);
+            m_sups.reserve(batch_size);
+        }
+
+        bool operator()(const interval& probe)
+        {
+            const auto coords = probe_coordinates(probe);
+            if (coords.n == m_depth && m_first <= coords.k && coords.k - m_first < static_cast<mult_t>(m_count))
+            {
+                return m_results[static_cast<std::size_t>(coords.k - m_first)];
+            }
+
+            const bool scanning = coords.n == m_depth && coords.k - m_first == static_cast<mult_t>(m_count);
+            const auto batch_size = scanning ? m_batch_size : std::size_t(1);
+
+            m_infs.assign(1, probe.inf());
+            m_sups.assign(1, probe.sup());
+            for (mult_t k = coords.k + 1; m_infs.size() < batch_size; ++k)
+            {
+                const auto sup = std::ldexp(static_cast<double>(k) + 1.0, -coords.n);
+                if (sup > m_limit)
+                {
+                    break;
+                }
+                m_infs.push_back(std::ldexp(static_cast<double>(k), -coords.n));
+                m_sups.push_back(sup);
+            }
+
+            m_depth = coords.n;
+            m_first = coords.k;
+            m_count = m_infs.size();
+            m_probes += m_count;
+            m_predicate(m_infs.data(), m_sups.data(), m_count, m_results.get(), m_user_data);
+            return m_results[0];
+        }
+    };
+
+    template <typename Fn>
+    segments_status guarded(segments_searcher* searcher, Fn&& fn) noexcept
+    {
+        try
+        {
+            searcher->last_error.clear();
+            fn();
+            return SEGMENTS_OK;
+        }
+        catch (const std::bad_alloc&)
+        {
+            searcher->last_error = "out of memory";
+            return SEGMENTS_OUT_OF_MEMORY;
+        }
+        catch (const std::invalid_argument& err)
+        {
+            searcher->last_error = err.what();
+            return SEGMENTS_INVALID_ARGUMENT;
+        }
+        catch (const std::exception& err)
+        {
+            searcher->last_error = err.what();
+            return SEGMENTS_ERROR;
+        }
+        catch (...)
+        {
+            searcher->last_error = "unknown error";
+            return SEGMENTS_ERROR;
+        }
+    }
+
+    void check_base(double inf, double sup)
+    {
+        if (!(inf < sup) || !std::isfinite(inf) || !std::isfinite(sup))
+        {
+            throw std::invalid_argument("the base interval must be finite and non-empty");
+        }
+    }
+
+    void search(segments_searcher* searcher, double inf, double sup, const predicate_t& predicate)
+    {
+        searcher->searcher.search_interval(interval(inf, sup), predicate);
+
+        const auto& found = searcher->searcher.m_found;
+        const auto& found_dyadic = searcher->searcher.m_found_dyadic;
+        searcher->result.clear();
+        searcher->dyadic_result.clear();
+        for (std::size_t i = 0; i < found.size(); ++i)
+        {
+            searcher->result.push_back({found[i].inf(), found[i].sup()});
+            searcher->dyadic_result.push_back({
+                    found_dyadic[i].inf.k, found_dyadic[i].inf.n,
+                    found_dyadic[i].sup.k, found_dyadic[i].sup.n
+            });
+        }
+    }
+}
+
+
+int segments_abi_version(void)
+{
+    return SEGMENTS_ABI_VERSION;
+}
+
+segments_searcher* segments_searcher_new(int signal_tolerance, int trim_tolerance, int start_depth)
+{
+    try
+    {
+        return new segments_searcher(signal_tolerance, trim_tolerance, start_depth);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void segments_searcher_free(segments_searcher* searcher)
+{
+    delete searcher;
+}
+
+segments_status segments_searcher_set_batch_size(segments_searcher* searcher, size_t batch_size)
+{
+    if (searcher == nullptr)
+    {
+        return SEGMENTS_INVALID_ARGUMENT;
+    }
+    return guarded(searcher, [=] {
+        if (batch_size == 0)
+        {
+            throw std::invalid_argument("batch size must be positive");
+        }
+        searcher->batch_size = batch_size;
+    });
+}
+
+segments_status segments_search(segments_searcher* searcher, double inf, double sup,
+                                segments_predicate_fn predicate, void* user_data)
+{
+    if (searcher == nullptr)
+    {
+        return SEGMENTS_INVALID_ARGUMENT;
+    }
+    return guarded(searcher, [=] {
+        check_base(inf, sup);
+        if (predicate == nullptr)
+        {
+            throw std::invalid_argument("predicate must not be null");
+        }
+
+        searcher->probes = 0;
+        auto& probes = searcher->probes;
+        search(searcher, inf, sup, [predicate, user_data, &probes](const interval& probe) {
+            ++probes;
+            return predicate(probe.inf(), probe.sup(), user_data);
+        });
+    });
+}
+
+segments_status segments_search_batched(segments_searcher* searcher, double inf, double sup,
+                                        segments_batch_predicate_fn predicate, void* user_data)
+{
+    if (searcher == nullptr)
+    {
+        return SEGMENTS_INVALID_ARGUMENT;
+    }
+    return guarded(searcher, [=] {
+        check_base(inf, sup);
+        if (predicate == nullptr)
+        {
+            throw std::invalid_argument("predicate must not be null");
+        }
+
+        searcher->probes = 0;
+        BatchAdaptor adaptor(predicate, user_data, sup, searcher->batch_size, searcher->probes);
+        search(searcher, inf, sup, std::ref(adaptor));
+    });
+}
+
+const segments_interval* segments_result(const segments_searcher* searcher, size_t* count)
+{
+    if (searcher == nullptr)
+    {
+        if (count != nullptr)
+        {
+            *count = 0;
+        }
+        return nullptr;
+    }
+    if (count != nullptr)
+    {
+        *count = searcher->result.size();
+    }
+    return searcher->result.data();
+}
+
+const segments_dyadic_segment* segments_dyadic_result(const segments_searcher* searcher, size_t* count)
+{
+    if (searcher == nullptr)
+    {
+        if (count != nullptr)
+        {
+            *count = 0;
+        }
+        return nullptr;
+    }
+    if (count != nullptr)
+    {
+        *count = searcher->dyadic_result.size();
+    }
+    return searcher->dyadic_result.data();
+}
+
+size_t segments_probe_count(const segments_searcher* searcher)
+{
+    return searcher == nullptr ? 0 : searcher->probes;
+}
+
+const char* segments_last_error(const segments_searcher* searcher)
+{
+    return searcher == nullptr ? "searcher is null" : searcher->last_error.c_str();
+}
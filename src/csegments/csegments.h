@@ -0,0 +1,114 @@
+/*
+ * A C interface to the segments library, for embedding the search in C or
+ * other languages with a C FFI without going through Python.
+ *
+ * A searcher handle holds the tolerances of a search and the buffers for its
+ * results, and can be reused for any number of searches. Results are stored
+ * in flat arrays owned by the handle, which remain valid until the next
+ * search with, or destruction of, the handle. Handles are not thread-safe,
+ * but separate handles can be used concurrently.
+ *
+ * Functions that can fail return a segments_status, and a description of
+ * the last failure on a handle is available from segments_last_error.
+ */
+
+#ifndef CSEGMENTS_H
+#define CSEGMENTS_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(CSEGMENTS_BUILDING)
+#    define CSEGMENTS_API __declspec(dllexport)
+#  else
+#    define CSEGMENTS_API __declspec(dllimport)
+#  endif
+#else
+#  define CSEGMENTS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a declaration in this header changes incompatibly. */
+#define SEGMENTS_ABI_VERSION 1
+
+/* Passed as the start depth to begin the search at the coarsest dyadic
+ * level whose intervals are no longer than the base interval. They need not
+ * be aligned with it, so the first and last probes may overhang its ends. */
+#define SEGMENTS_ADAPTIVE_START_DEPTH INT_MIN
+
+typedef enum segments_status {
+    SEGMENTS_OK = 0,
+    SEGMENTS_INVALID_ARGUMENT = 1,
+    SEGMENTS_OUT_OF_MEMORY = 2,
+    SEGMENTS_ERROR = 3
+} segments_status;
+
+typedef struct segments_interval {
+    double inf;
+    double sup;
+} segments_interval;
+
+/* A segment with exact dyadic endpoints inf_k/2^inf_n and sup_k/2^sup_n. */
+typedef struct segments_dyadic_segment {
+    int inf_k;
+    int inf_n;
+    int sup_k;
+    int sup_n;
+} segments_dyadic_segment;
+
+/* Evaluate the predicate on the interval [inf, sup). This has the same
+ * signature as the functions accepted by pysegments.NativePredicate. */
+typedef bool (*segments_predicate_fn)(double inf, double sup, void* user_data);
+
+/* Evaluate the predicate on each of the intervals [infs[i], sups[i]),
+ * writing true or false to results[i]. */
+typedef void (*segments_batch_predicate_fn)(const double* infs, const double* sups, size_t count,
+                                            bool* results, void* user_data);
+
+typedef struct segments_searcher segments_searcher;
+
+
+CSEGMENTS_API int segments_abi_version(void);
+
+/* Create a searcher. The trim tolerance is raised to the signal tolerance
+ * if it is smaller. Returns NULL if memory cannot be allocated. */
+CSEGMENTS_API segments_searcher* segments_searcher_new(int signal_tolerance, int trim_tolerance, int start_depth);
+
+CSEGMENTS_API void segments_searcher_free(segments_searcher* searcher);
+
+/* The number of probes a batched search evaluates in one call, default 64. */
+CSEGMENTS_API segments_status segments_searcher_set_batch_size(segments_searcher* searcher, size_t batch_size);
+
+/* Search [inf, sup) for the segments on which predicate holds. */
+CSEGMENTS_API segments_status segments_search(segments_searcher* searcher, double inf, double sup,
+                                              segments_predicate_fn predicate, void* user_data);
+
+/* As segments_search, evaluating consecutive probes at the same depth in
+ * batches. The batches look ahead of the sequential search, so the
+ * predicate may be evaluated on intervals the sequential search would have
+ * skipped, but never outside [inf, sup) beyond the first dyadic interval. */
+CSEGMENTS_API segments_status segments_search_batched(segments_searcher* searcher, double inf, double sup,
+                                                      segments_batch_predicate_fn predicate, void* user_data);
+
+/* The segments found by the last search, in the order they were found. */
+CSEGMENTS_API const segments_interval* segments_result(const segments_searcher* searcher, size_t* count);
+
+CSEGMENTS_API const segments_dyadic_segment* segments_dyadic_result(const segments_searcher* searcher,
+                                                                    size_t* count);
+
+/* The number of predicate evaluations made by the last search. */
+CSEGMENTS_API size_t segments_probe_count(const segments_searcher* searcher);
+
+/* A description of the last failure on searcher, or an empty string. */
+CSEGMENTS_API const char* segments_last_error(const segments_searcher* searcher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CSEGMENTS_H */
@@ -0,0 +1,124 @@
+/*
+ * A small C harness for the segments C interface. Each check prints the
+ * failing condition and the harness exits with the number of failures.
+ */
+
+#include "csegments.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                       \
+        }                                                                     \
+    } while (0)
+
+
+static bool multiple_intervals(double inf, double sup, void* user_data)
+{
+    int* calls = (int*) user_data;
+    if (calls != NULL) {
+        ++*calls;
+    }
+    return (inf >= 0.234 && sup <= 0.9523)
+           || (inf >= 2.852 && sup <= 3.401)
+           || (inf >= 6.013 && sup <= 6.521);
+}
+
+static void multiple_intervals_batch(const double* infs, const double* sups, size_t count,
+                                     bool* results, void* user_data)
+{
+    int* batches = (int*) user_data;
+    ++*batches;
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = multiple_intervals(infs[i], sups[i], NULL);
+    }
+}
+
+static void test_scalar_search(void)
+{
+    segments_searcher* searcher = segments_searcher_new(8, 10, 0);
+    CHECK(searcher != NULL);
+
+    int calls = 0;
+    CHECK(segments_search(searcher, 0.0, 10.0, multiple_intervals, &calls) == SEGMENTS_OK);
+
+    size_t count = 0;
+    const segments_interval* found = segments_result(searcher, &count);
+    CHECK(count == 3);
+    for (size_t i = 0; i < count; ++i) {
+        CHECK(multiple_intervals(found[i].inf, found[i].sup, NULL));
+    }
+    CHECK(segments_probe_count(searcher) == (size_t) calls);
+
+    size_t dyadic_count = 0;
+    const segments_dyadic_segment* dyadic = segments_dyadic_result(searcher, &dyadic_count);
+    CHECK(dyadic_count == count);
+    CHECK(dyadic[0].inf_n >= 0);
+
+    /* Handles are reusable and each search replaces the previous results. */
+    CHECK(segments_search(searcher, 0.0, 1.0, multiple_intervals, NULL) == SEGMENTS_OK);
+    segments_result(searcher, &count);
+    CHECK(count == 1);
+
+    segments_searcher_free(searcher);
+}
+
+static void test_batched_search(void)
+{
+    segments_searcher* scalar = segments_searcher_new(8, 10, 0);
+    segments_searcher* batched = segments_searcher_new(8, 10, 0);
+    CHECK(segments_searcher_set_batch_size(batched, 32) == SEGMENTS_OK);
+
+    int batches = 0;
+    CHECK(segments_search(scalar, 0.0, 10.0, multiple_intervals, NULL) == SEGMENTS_OK);
+    CHECK(segments_search_batched(batched, 0.0, 10.0, multiple_intervals_batch, &batches) == SEGMENTS_OK);
+
+    size_t scalar_count = 0, batched_count = 0;
+    const segments_interval* expected = segments_result(scalar, &scalar_count);
+    const segments_interval* found = segments_result(batched, &batched_count);
+    CHECK(scalar_count == batched_count);
+    for (size_t i = 0; i < scalar_count && i < batched_count; ++i) {
+        CHECK(expected[i].inf == found[i].inf);
+        CHECK(expected[i].sup == found[i].sup);
+    }
+    CHECK((size_t) batches < segments_probe_count(scalar));
+    CHECK(2 * segments_probe_count(batched) <= 3 * segments_probe_count(scalar));
+
+    segments_searcher_free(scalar);
+    segments_searcher_free(batched);
+}
+
+static void test_errors(void)
+{
+    segments_searcher* searcher = segments_searcher_new(4, 0, SEGMENTS_ADAPTIVE_START_DEPTH);
+
+    CHECK(segments_search(searcher, 1.0, 0.0, multiple_intervals, NULL) == SEGMENTS_INVALID_ARGUMENT);
+    CHECK(segments_last_error(searcher)[0] != '\0');
+    CHECK(segments_search(searcher, 0.0, 1.0, NULL, NULL) == SEGMENTS_INVALID_ARGUMENT);
+    CHECK(segments_searcher_set_batch_size(searcher, 0) == SEGMENTS_INVALID_ARGUMENT);
+    CHECK(segments_search(NULL, 0.0, 1.0, multiple_intervals, NULL) == SEGMENTS_INVALID_ARGUMENT);
+
+    CHECK(segments_search(searcher, 0.0, 1.0, multiple_intervals, NULL) == SEGMENTS_OK);
+    CHECK(segments_last_error(searcher)[0] == '\0');
+
+    segments_searcher_free(searcher);
+    segments_searcher_free(NULL);
+}
+
+int main(void)
+{
+    CHECK(segments_abi_version() == SEGMENTS_ABI_VERSION);
+    test_scalar_search();
+    test_batched_search();
+    test_errors();
+
+    if (failures != 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+    }
+    return failures;
+}
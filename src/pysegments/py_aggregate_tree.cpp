@@ -0,0 +1,123 @@
+#include "pysegments.h"
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/numpy.h>
+
+#include <aggregate_tree.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+using pysegments::NativePredicate;
+
+namespace
+{
+    using sample_array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+    using moments_tree = AggregateTree<moments_monoid>;
+
+    /*
+     * The Python AggregateTree is the moments tree, which gives the count,
+     * sum, mean, variance, min and max of the samples in any probe. The tree
+     * is shared with the predicates made from it, so they stay valid after
+     * the Python object is released.
+     */
+    struct PyAggregateTree
+    {
+        std::shared_ptr<const moments_tree> tree;
+    };
+
+    using statistic_t = double (*)(const moments&);
+
+    statistic_t get_statistic(const std::string& name)
+    {
+        if (name == "count") return [](const moments& m) { return m.count; };
+        if (name == "sum") return [](const moments& m) { return m.sum(); };
+        if (name == "mean") return [](const moments& m) { return m.mean; };
+        if (name == "variance") return [](const moments& m) { return m.variance(); };
+        if (name == "min") return [](const moments& m) { return m.min; };
+        if (name == "max") return [](const moments& m) { return m.max; };
+        throw py::value_error("statistic must be one of \"count\", \"sum\", \"mean\", \"variance\", \"min\" or \"max\"");
+    }
+
+    PyAggregateTree make_tree(const sample_array& positions, const sample_array& values, depth_t resolution)
+    {
+        if (positions.ndim() != 1 || values.ndim() != 1)
+        {
+            throw py::value_error("positions and values must be one-dimensional arrays");
+        }
+
+        std::vector<double> pos(positions.data(), positions.data() + positions.size());
+        std::vector<moments> lifted(values.data(), values.data() + values.size());
+
+        py::gil_scoped_release release;
+        return {std::make_shared<const moments_tree>(std::move(pos), std::move(lifted), resolution)};
+    }
+
+    py::dict query(const PyAggregateTree& self, const interval& probe)
+    {
+        auto found = self.tree->query(probe);
+        return py::dict("count"_a = static_cast<std::size_t>(found.count),
+                        "sum"_a = found.sum(),
+                        "mean"_a = found.count > 0.0 ? found.mean : std::numeric_limits<double>::quiet_NaN(),
+                        "variance"_a = found.variance(),
+                        "min"_a = found.min,
+                        "max"_a = found.max);
+    }
+
+    NativePredicate within(const PyAggregateTree& self, const std::string& name, double lower, double upper)
+    {
+        auto statistic = get_statistic(name);
+        auto tree = self.tree;
+        predicate_t predicate = [tree, statistic, lower, upper](const interval& probe)
+        {
+            auto found = tree->query(probe);
+            if (found.count == 0.0)
+            {
+                return false;
+            }
+            auto value = statistic(found);
+            return lower <= value && value <= upper;
+        };
+        return {std::move(predicate), py::none()};
+    }
+} // namespace
+
+
+void pysegments::init_aggregate_tree(py::module_& m)
+{
+    py::class_<PyAggregateTree> klass(m, "AggregateTree", R"pbdoc(
+    Precomputed statistics of a sampled signal over every dyadic block.
+
+    The count, sum, mean, variance, min and max of the samples in each
+    dyadic block, from blocks of length 2**-resolution upward, are computed
+    once, so every probe of a search reads one stored node rather than
+    visiting its samples. Probes finer than the resolution combine the few
+    samples they contain. positions must be sorted.
+    )pbdoc");
+
+    klass.def(py::init(&make_tree), "positions"_a, "values"_a, "resolution"_a);
+
+    klass.def("__len__", [](const PyAggregateTree& self) { return self.tree->size(); });
+    klass.def_property_readonly("resolution", [](const PyAggregateTree& self) { return self.tree->resolution(); });
+
+    klass.def("query", &query, "interval"_a, R"pbdoc(
+    The statistics of the samples in interval, which must be a dyadic
+    interval such as a probe passed to a predicate, as a dict with keys
+    count, sum, mean, variance, min and max.
+    )pbdoc");
+
+    klass.def("within", &within, "statistic"_a,
+              "lower"_a = -std::numeric_limits<double>::infinity(),
+              "upper"_a = std::numeric_limits<double>::infinity(), R"pbdoc(
+    A NativePredicate that is true on probes containing at least one sample
+    whose statistic, one of "count", "sum", "mean", "variance", "min" or
+    "max", lies in [lower, upper]. The search runs without the GIL.
+    )pbdoc");
+}
@@ -0,0 +1,107 @@
+#include "pysegments.h"
+
+#include <algorithm>
+#include <string>
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <bottom_up.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    using bool_array = py::array_t<bool, py::array::c_style | py::array::forcecast>;
+
+    /*
+     * The vectorised predicate is called with NumPy arrays of the bounds of
+     * a batch of intervals and returns a boolean array of the same length.
+     */
+    batch_predicate_t vectorised_predicate(const py::function& predicate)
+    {
+        return [&predicate](const double* infs, const double* sups, std::size_t count, bool* results)
+        {
+            const auto size = static_cast<py::ssize_t>(count);
+            py::array_t<double> inf_array(size, infs), sup_array(size, sups);
+
+            auto answer = bool_array::ensure(predicate(inf_array, sup_array));
+            if (!answer || answer.size() != size)
+            {
+                throw py::value_error("vectorised predicate must return one boolean for each interval");
+            }
+            std::copy(answer.data(), answer.data() + size, results);
+        };
+    }
+
+    std::vector<interval> segment_vectorised(interval arg,
+                                             const py::function& predicate,
+                                             py::object pytol,
+                                             py::object pysignal_tol,
+                                             py::object pystart,
+                                             const std::string& engine,
+                                             std::size_t batch_size)
+    {
+        auto tol = pysegments::get_tolerance(arg, pytol, pysignal_tol);
+        auto start_depth = pysegments::get_start_depth(pystart);
+        auto batch = vectorised_predicate(predicate);
+
+        search_engine chosen;
+        if (engine == "auto")
+        {
+            chosen = choose_engine(arg, tol.signal, tol.trim);
+        }
+        else if (engine == "bottom_up")
+        {
+            chosen = search_engine::bottom_up;
+        }
+        else if (engine == "top_down")
+        {
+            chosen = search_engine::top_down;
+        }
+        else
+        {
+            throw py::value_error("engine must be \"auto\", \"bottom_up\" or \"top_down\"");
+        }
+
+        if (chosen == search_engine::bottom_up)
+        {
+            return segment_bottom_up(arg, batch, tol.signal, tol.trim, start_depth, batch_size);
+        }
+        return segment(arg, [&batch](const interval& probe)
+        {
+            const double inf = probe.inf();
+            const double sup = probe.sup();
+            bool result = false;
+            batch(&inf, &sup, 1, &result);
+            return result;
+        }, tol.signal, tol.trim, start_depth);
+    }
+} // namespace
+
+
+void pysegments::init_bottom_up(py::module_& m)
+{
+    m.def("segment_vectorised", &segment_vectorised, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "engine"_a = "top_down",
+          "batch_size"_a = 65536, R"pbdoc(
+    Segment interval with a vectorised predicate, called with NumPy arrays of
+    the inf and sup of many intervals and returning a boolean array.
+
+    By default (engine="top_down") the search is the one segment makes, with
+    the predicate called on one interval at a time. With engine="bottom_up"
+    the predicate is evaluated on every dyadic interval at the trim
+    tolerance, batch_size at a time, and the true runs are merged into
+    segments, making a few large calls instead of many small ones.
+    engine="auto" picks the engine with the lower estimated cost.
+
+    The bottom-up engine, and so "auto", requires the predicate to hold on
+    an interval exactly when it holds on each of its finest intervals, as
+    bounds on the values of a signal do. For other predicates its result
+    differs from that of segment.
+    )pbdoc");
+}
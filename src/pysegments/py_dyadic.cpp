@@ -0,0 +1,480 @@
+#include "pysegments.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    using k_array = py::array_t<mult_t, py::array::c_style | py::array::forcecast>;
+    using n_array = py::array_t<depth_t, py::array::c_style | py::array::forcecast>;
+    using f_array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+    std::vector<py::ssize_t> shape_of(const py::array& arr)
+    {
+        return {arr.shape(), arr.shape() + arr.ndim()};
+    }
+
+    std::string shape_str(const py::array& arr)
+    {
+        std::string result = "(";
+        for (py::ssize_t i = 0; i < arr.ndim(); ++i)
+        {
+            result += std::to_string(arr.shape(i)) + (arr.ndim() == 1 || i + 1 < arr.ndim() ? "," : "");
+        }
+        return result + ")";
+    }
+
+    /// The shape of arr without its leading dimensions of length one.
+    std::vector<py::ssize_t> trimmed_shape(const py::array& arr)
+    {
+        auto shape = shape_of(arr);
+        auto first = std::find_if(shape.begin(), shape.end(), [](py::ssize_t extent) { return extent != 1; });
+        return {first, shape.end()};
+    }
+
+    /*
+     * Element-wise operations accept a k array and an n array of the same
+     * shape, up to leading dimensions of length one, or where one of the two
+     * has a single element that is applied to every element of the other.
+     */
+    const py::array& broadcast_shape(const py::array& lhs, const py::array& rhs)
+    {
+        if (trimmed_shape(lhs) == trimmed_shape(rhs))
+        {
+            return lhs.ndim() >= rhs.ndim() ? lhs : rhs;
+        }
+        if (rhs.size() == 1)
+        {
+            return lhs;
+        }
+        if (lhs.size() == 1)
+        {
+            return rhs;
+        }
+        throw py::value_error("arrays of shapes " + shape_str(lhs) + " and " + shape_str(rhs)
+                              + " cannot be broadcast together");
+    }
+
+    inline py::ssize_t stride_of(const py::array& arr) noexcept
+    {
+        return arr.size() == 1 ? 0 : 1;
+    }
+
+    inline mult_t checked_bracket(double value, depth_t resolution)
+    {
+        if (std::isnan(value))
+        {
+            throw std::domain_error("cannot bracket NaN");
+        }
+        auto rescaled = std::ldexp(value, resolution);
+        if (!(std::abs(rescaled) < double(std::numeric_limits<mult_t>::max())))
+        {
+            throw std::overflow_error("value " + std::to_string(value)
+                                      + " cannot be represented at resolution " + std::to_string(resolution));
+        }
+        return dyadic_interval(value, resolution).k;
+    }
+
+    /*
+     * Comparing two dyadic intervals, for containment or for tree order,
+     * rescales them to the depth of the finer one. The rescaled k must stay
+     * well inside mult_t, so that it and differences of it cannot overflow.
+     * Unchecked, large k or depth differences of 31 or more are undefined
+     * behaviour rather than an error.
+     */
+    constexpr std::int64_t max_rescaled_k = std::int64_t(1) << (std::numeric_limits<mult_t>::digits - 1);
+
+    inline bool rescales_to(mult_t k, std::int64_t depth_change) noexcept
+    {
+        return depth_change >= 0 && depth_change < std::numeric_limits<mult_t>::digits - 1
+               && std::abs(std::int64_t(k)) < (max_rescaled_k >> depth_change);
+    }
+
+    [[noreturn]] void not_comparable(const dyadic_interval& lhs, const dyadic_interval& rhs)
+    {
+        throw py::value_error("dyadic intervals (" + std::to_string(lhs.k) + ", " + std::to_string(lhs.n) + ") and ("
+                              + std::to_string(rhs.k) + ", " + std::to_string(rhs.n)
+                              + ") are too far apart in depth or position to compare");
+    }
+
+    inline void check_comparable(const dyadic_interval& lhs, const dyadic_interval& rhs)
+    {
+        const auto change = std::int64_t(lhs.n) - std::int64_t(rhs.n);
+        if (!rescales_to(lhs.k, change < 0 ? -change : 0) || !rescales_to(rhs.k, change > 0 ? change : 0))
+        {
+            not_comparable(lhs, rhs);
+        }
+    }
+
+    /// Whether outer contains inner. Only an inner interval at least as fine
+    /// as outer is rescaled.
+    inline bool checked_contains(const dyadic_interval& outer, const dyadic_interval& inner)
+    {
+        if (inner.n < outer.n)
+        {
+            return false;
+        }
+        check_comparable(outer, inner);
+        return outer.contains(inner);
+    }
+
+    inline bool checked_less(const dyadic_interval& lhs, const dyadic_interval& rhs)
+    {
+        check_comparable(lhs, rhs);
+        return lhs < rhs;
+    }
+
+    inline dyadic_interval parent_of(const dyadic_interval& di)
+    {
+        if (di.n == std::numeric_limits<depth_t>::min())
+        {
+            throw py::value_error("dyadic interval at depth " + std::to_string(di.n) + " has no parent");
+        }
+        dyadic_interval result(di);
+        return result.expand_interval();
+    }
+
+    inline void check_children(const dyadic_interval& di)
+    {
+        if (di.n == std::numeric_limits<depth_t>::max() || !rescales_to(di.k, 1))
+        {
+            throw py::value_error("the children of dyadic interval (" + std::to_string(di.k) + ", "
+                                  + std::to_string(di.n) + ") cannot be represented");
+        }
+    }
+
+    /// Check that inf and sup can be bracketed at tolerance, and that the
+    /// intervals between them can be compared.
+    inline void check_decomposable(double inf, double sup, depth_t tolerance)
+    {
+        if (tolerance < std::numeric_limits<depth_t>::min() + std::numeric_limits<mult_t>::digits)
+        {
+            throw py::value_error("tolerance " + std::to_string(tolerance) + " is too coarse");
+        }
+        if (!(inf <= sup))
+        {
+            throw py::value_error("interval [" + std::to_string(inf) + ", " + std::to_string(sup) + ") is empty");
+        }
+        for (const auto value : {inf, sup})
+        {
+            if (!rescales_to(checked_bracket(value, tolerance), 1))
+            {
+                throw std::overflow_error("value " + std::to_string(value)
+                                          + " cannot be represented at resolution " + std::to_string(tolerance));
+            }
+        }
+    }
+
+    k_array py_dyadic_bracket(const f_array& values, depth_t resolution)
+    {
+        k_array result(shape_of(values));
+        auto* out = result.mutable_data();
+        const auto* in = values.data();
+        const auto size = values.size();
+
+        py::gil_scoped_release release;
+        for (py::ssize_t i = 0; i < size; ++i)
+        {
+            out[i] = checked_bracket(in[i], resolution);
+        }
+        return result;
+    }
+
+    py::tuple py_dyadic_parent(const k_array& ks, const n_array& ns)
+    {
+        const auto& shape = broadcast_shape(ks, ns);
+        k_array out_k(shape_of(shape));
+        n_array out_n(shape_of(shape));
+
+        auto* pk = out_k.mutable_data();
+        auto* pn = out_n.mutable_data();
+        const auto* k = ks.data();
+        const auto* n = ns.data();
+        const auto sk = stride_of(ks);
+        const auto sn = stride_of(ns);
+        const auto size = shape.size();
+
+        {
+            py::gil_scoped_release release;
+            for (py::ssize_t i = 0; i < size; ++i)
+            {
+                auto parent = parent_of(dyadic_interval(k[i * sk], n[i * sn]));
+                pk[i] = parent.k;
+                pn[i] = parent.n;
+            }
+        }
+        return py::make_tuple(std::move(out_k), std::move(out_n));
+    }
+
+    py::tuple py_dyadic_children(const k_array& ks, const n_array& ns)
+    {
+        const auto& shape = broadcast_shape(ks, ns);
+        k_array out_left(shape_of(shape));
+        k_array out_right(shape_of(shape));
+        n_array out_n(shape_of(shape));
+
+        auto* pl = out_left.mutable_data();
+        auto* pr = out_right.mutable_data();
+        auto* pn = out_n.mutable_data();
+        const auto* k = ks.data();
+        const auto* n = ns.data();
+        const auto sk = stride_of(ks);
+        const auto sn = stride_of(ns);
+        const auto size = shape.size();
+
+        {
+            py::gil_scoped_release release;
+            for (py::ssize_t i = 0; i < size; ++i)
+            {
+                dyadic_interval di(k[i * sk], n[i * sn]);
+                check_children(di);
+                auto left = di.shrink_to_contained_end();
+                pl[i] = left.k;
+                pr[i] = di.shrink_to_omitted_end().k;
+                pn[i] = left.n;
+            }
+        }
+        return py::make_tuple(std::move(out_left), std::move(out_right), std::move(out_n));
+    }
+
+    py::array_t<bool> py_dyadic_contains(const k_array& outer_k, const n_array& outer_n,
+                                         const k_array& inner_k, const n_array& inner_n)
+    {
+        const auto& outer = broadcast_shape(outer_k, outer_n);
+        const auto& inner = broadcast_shape(inner_k, inner_n);
+        const auto& shape = broadcast_shape(outer, inner);
+        py::array_t<bool> result(shape_of(shape));
+
+        auto* out = result.mutable_data();
+        const auto* ok = outer_k.data();
+        const auto* on = outer_n.data();
+        const auto* ik = inner_k.data();
+        const auto* in = inner_n.data();
+        const auto sok = stride_of(outer_k) * stride_of(outer);
+        const auto son = stride_of(outer_n) * stride_of(outer);
+        const auto sik = stride_of(inner_k) * stride_of(inner);
+        const auto sin = stride_of(inner_n) * stride_of(inner);
+        const auto size = shape.size();
+
+        py::gil_scoped_release release;
+        for (py::ssize_t i = 0; i < size; ++i)
+        {
+            dyadic_interval lhs(ok[i * sok], on[i * son]);
+            dyadic_interval rhs(ik[i * sik], in[i * sin]);
+            out[i] = checked_contains(lhs, rhs);
+        }
+        return result;
+    }
+
+    py::array_t<py::ssize_t> py_dyadic_argsort(const k_array& ks, const n_array& ns)
+    {
+        const auto& shape = broadcast_shape(ks, ns);
+        const auto size = shape.size();
+        py::array_t<py::ssize_t> result(size);
+
+        auto* out = result.mutable_data();
+        const auto* k = ks.data();
+        const auto* n = ns.data();
+        const auto sk = stride_of(ks);
+        const auto sn = stride_of(ns);
+
+        py::gil_scoped_release release;
+
+        // Every pair is compared by rescaling to the finer depth, so every
+        // interval must rescale to the finest depth of the array.
+        if (size != 0)
+        {
+            const auto finest = *std::max_element(n, n + (sn == 0 ? 1 : size));
+            for (py::ssize_t i = 0; i < size; ++i)
+            {
+                if (!rescales_to(k[i * sk], std::int64_t(finest) - n[i * sn]))
+                {
+                    throw py::value_error("dyadic interval (" + std::to_string(k[i * sk]) + ", "
+                                          + std::to_string(n[i * sn]) + ") cannot be ordered against depth "
+                                          + std::to_string(finest));
+                }
+            }
+        }
+
+        std::iota(out, out + size, py::ssize_t(0));
+        std::stable_sort(out, out + size, [=](py::ssize_t lhs, py::ssize_t rhs) {
+            return dyadic_interval(k[lhs * sk], n[lhs * sn]) < dyadic_interval(k[rhs * sk], n[rhs * sn]);
+        });
+        return result;
+    }
+
+    py::tuple py_dyadic_sort(const k_array& ks, const n_array& ns)
+    {
+        auto order = py_dyadic_argsort(ks, ns);
+        const auto size = order.size();
+        k_array out_k(size);
+        n_array out_n(size);
+
+        auto* pk = out_k.mutable_data();
+        auto* pn = out_n.mutable_data();
+        const auto* idx = order.data();
+        const auto* k = ks.data();
+        const auto* n = ns.data();
+        const auto sk = stride_of(ks);
+        const auto sn = stride_of(ns);
+
+        for (py::ssize_t i = 0; i < size; ++i)
+        {
+            pk[i] = k[idx[i] * sk];
+            pn[i] = n[idx[i] * sn];
+        }
+        return py::make_tuple(std::move(out_k), std::move(out_n));
+    }
+
+    std::vector<dyadic_interval> py_to_dyadic_intervals(const interval& arg, depth_t tolerance)
+    {
+        check_decomposable(arg.inf(), arg.sup(), tolerance);
+        auto dis = to_dyadic_intervals<clopen, dyadic>(arg.inf(), arg.sup(), tolerance, clopen);
+        return {dis.begin(), dis.end()};
+    }
+
+    py::tuple py_to_dyadic_intervals_batch(const f_array& infs, const f_array& sups, depth_t tolerance)
+    {
+        if (infs.size() != sups.size())
+        {
+            throw py::value_error("infs and sups must have the same size");
+        }
+
+        const auto size = infs.size();
+        const auto* inf = infs.data();
+        const auto* sup = sups.data();
+
+        std::vector<mult_t> ks;
+        std::vector<depth_t> ns;
+        py::array_t<py::ssize_t> offsets(size + 1);
+        auto* off = offsets.mutable_data();
+
+        {
+            py::gil_scoped_release release;
+            off[0] = 0;
+            for (py::ssize_t i = 0; i < size; ++i)
+            {
+                check_decomposable(inf[i], sup[i], tolerance);
+            }
+            for (py::ssize_t i = 0; i < size; ++i)
+            {
+                for (const auto& di : to_dyadic_intervals<clopen, dyadic>(inf[i], sup[i], tolerance, clopen))
+                {
+                    ks.push_back(di.k);
+                    ns.push_back(di.n);
+                }
+                off[i + 1] = static_cast<py::ssize_t>(ks.size());
+            }
+        }
+
+        k_array out_k(static_cast<py::ssize_t>(ks.size()));
+        n_array out_n(static_cast<py::ssize_t>(ns.size()));
+        std::copy(ks.begin(), ks.end(), out_k.mutable_data());
+        std::copy(ns.begin(), ns.end(), out_n.mutable_data());
+
+        return py::make_tuple(std::move(out_k), std::move(out_n), std::move(offsets));
+    }
+
+    std::string dyadic_str(const dyadic_interval& self)
+    {
+        return "[" + std::to_string(double(self.inf())) + ", " + std::to_string(double(self.sup())) + ")";
+    }
+
+} // namespace
+
+
+void pysegments::init_dyadic(py::module_& m)
+{
+    py::class_<dyadic_interval> py_dyadic(m, "DyadicInterval");
+
+    py_dyadic.def(py::init<mult_t, depth_t>(), "k"_a = 0, "n"_a = 0);
+
+    py_dyadic.def_static("bracket", [](double value, depth_t resolution)
+    {
+        return dyadic_interval(checked_bracket(value, resolution), resolution);
+    }, "value"_a, "resolution"_a);
+
+    py_dyadic.def_property_readonly("k", [](const dyadic_interval& self) { return self.k; });
+    py_dyadic.def_property_readonly("n", [](const dyadic_interval& self) { return self.n; });
+    py_dyadic.def_property_readonly("inf", [](const dyadic_interval& self) { return double(self.inf()); });
+    py_dyadic.def_property_readonly("sup", [](const dyadic_interval& self) { return double(self.sup()); });
+
+    py_dyadic.def("included_end", [](const dyadic_interval& self) { return double(self.included_end()); });
+    py_dyadic.def("excluded_end", [](const dyadic_interval& self) { return double(self.excluded_end()); });
+    py_dyadic.def("aligned", &dyadic_interval::aligned);
+
+    py_dyadic.def("parent", &parent_of);
+    py_dyadic.def("children", [](const dyadic_interval& self)
+    {
+        check_children(self);
+        return py::make_tuple(self.shrink_to_contained_end(), self.shrink_to_omitted_end());
+    });
+
+    py_dyadic.def("contains", [](const dyadic_interval& self, const dyadic_interval& other)
+    {
+        return checked_contains(self, other);
+    }, "other"_a);
+    py_dyadic.def("contains", [](const dyadic_interval& self, double arg)
+    {
+        return interval(self).contains(arg);
+    }, "arg"_a);
+
+    py_dyadic.def("to_interval", [](const dyadic_interval& self) { return interval(self); });
+
+    py_dyadic.def("__lt__", [](const dyadic_interval& self, const dyadic_interval& other)
+    {
+        return checked_less(self, other);
+    }, py::is_operator());
+    py_dyadic.def("__eq__", [](const dyadic_interval& self, const dyadic_interval& other)
+    {
+        return self == other;
+    }, py::is_operator());
+    py_dyadic.def("__ne__", [](const dyadic_interval& self, const dyadic_interval& other)
+    {
+        return self != other;
+    }, py::is_operator());
+    py_dyadic.def("__hash__", [](const dyadic_interval& self)
+    {
+        return py::hash(py::make_tuple(self.k, self.n));
+    });
+
+    py_dyadic.def("__str__", &dyadic_str);
+    py_dyadic.def("__repr__", [](const dyadic_interval& self)
+    {
+        return "DyadicInterval(" + std::to_string(self.k) + ", " + std::to_string(self.n) + ")";
+    });
+
+    py_dyadic.def("__copy__", [](const dyadic_interval& self)
+    {
+        return dyadic_interval(self);
+    });
+    py_dyadic.def("__deepcopy__", [](const dyadic_interval& self, const py::dict&)
+    {
+        return dyadic_interval(self);
+    }, "memo"_a);
+
+    m.def("dyadic_bracket", &py_dyadic_bracket, "values"_a, "resolution"_a);
+    m.def("dyadic_parent", &py_dyadic_parent, "k"_a, "n"_a);
+    m.def("dyadic_children", &py_dyadic_children, "k"_a, "n"_a);
+    m.def("dyadic_contains", &py_dyadic_contains, "outer_k"_a, "outer_n"_a, "inner_k"_a, "inner_n"_a);
+    m.def("dyadic_argsort", &py_dyadic_argsort, "k"_a, "n"_a);
+    m.def("dyadic_sort", &py_dyadic_sort, "k"_a, "n"_a);
+
+    m.def("to_dyadic_intervals", &py_to_dyadic_intervals, "interval"_a, "tolerance"_a);
+    m.def("to_dyadic_intervals", &py_to_dyadic_intervals_batch, "infs"_a, "sups"_a, "tolerance"_a);
+}
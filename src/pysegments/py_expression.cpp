@@ -0,0 +1,96 @@
+#include "pysegments.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+
+#include <expression.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+using pysegments::NativePredicate;
+
+namespace
+{
+    using sample_array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+    std::vector<double> to_vector(const py::handle& values)
+    {
+        auto array = sample_array::ensure(values);
+        if (!array || array.ndim() != 1)
+        {
+            throw py::value_error("sample positions and values must be one-dimensional arrays");
+        }
+        return {array.data(), array.data() + array.size()};
+    }
+
+    /*
+     * The compiled expression is owned by the predicate itself, so the
+     * result needs nothing kept alive and the search runs without the GIL.
+     */
+    NativePredicate compile_predicate(const std::string& source, const py::kwargs& bindings)
+    {
+        Expression expr(source);
+
+        for (const auto& item : bindings)
+        {
+            auto name = item.first.cast<std::string>();
+            const auto& value = item.second;
+            if (py::isinstance<py::tuple>(value) || py::isinstance<py::list>(value))
+            {
+                auto pair = value.cast<py::sequence>();
+                if (pair.size() != 2)
+                {
+                    throw py::value_error("sample array '" + name + "' must be given as (positions, values)");
+                }
+                expr.bind(name, to_vector(pair[0]), to_vector(pair[1]));
+            }
+            else
+            {
+                expr.bind(name, value.cast<double>());
+            }
+        }
+
+        for (const auto& name : expr.names())
+        {
+            if (!bindings.contains(name))
+            {
+                throw py::value_error("name '" + name + "' in expression is not bound");
+            }
+        }
+
+        try
+        {
+            return {expr.predicate(), py::none()};
+        }
+        catch (const std::logic_error& err)
+        {
+            throw py::value_error(err.what());
+        }
+    }
+} // namespace
+
+
+void pysegments::init_expression(py::module_& m)
+{
+    m.def("compile_predicate", &compile_predicate, "source"_a, R"pbdoc(
+    Compile a predicate expression to a NativePredicate, so that segment
+    evaluates it natively without the GIL.
+
+    The expression is written in Python syntax over the probe's inf, sup and
+    length, with comparisons (which chain), and, or, not, + - * /, abs, and
+    the aggregates min, max, mean, sum and count over a sample array. Every
+    other name must be given as a keyword argument: a number, or a pair
+    (positions, values) of arrays with sorted positions. An aggregate covers
+    the samples with positions in [inf, sup); min, max and mean of an empty
+    range are NaN, so comparisons with them are false.
+
+        compile_predicate("max(price) - min(price) <= spread",
+                          price=(times, prices), spread=0.5)
+    )pbdoc");
+}
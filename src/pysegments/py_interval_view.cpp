@@ -0,0 +1,90 @@
+#include "pysegments.h"
+
+#include <pybind11/functional.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    /*
+     * The interval passed to a predicate searched with reuse_interval=True.
+     * A single view is created for each search and its endpoints are
+     * overwritten before every call, so no Python object is allocated per
+     * probe. Predicates must not keep a reference to the view; call
+     * to_interval() to take a copy.
+     */
+    struct IntervalView
+    {
+        double inf;
+        double sup;
+    };
+
+    bool call_with(PyObject* function, PyObject* arg)
+    {
+#if PY_VERSION_HEX >= 0x03090000
+        PyObject* result = PyObject_CallOneArg(function, arg);
+#else
+        PyObject* result = PyObject_CallFunctionObjArgs(function, arg, nullptr);
+#endif
+        if (result == nullptr)
+        {
+            throw py::error_already_set();
+        }
+
+        int truth = PyObject_IsTrue(result);
+        Py_DECREF(result);
+        if (truth < 0)
+        {
+            throw py::error_already_set();
+        }
+        return truth != 0;
+    }
+} // namespace
+
+
+predicate_t pysegments::make_scalar_predicate(const py::function& predicate, bool reuse_interval)
+{
+    if (!reuse_interval)
+    {
+        return predicate.cast<predicate_t>();
+    }
+
+    py::object view = py::cast(IntervalView{0.0, 0.0});
+    auto* ptr = view.cast<IntervalView*>();
+
+    return [predicate, view, ptr](const interval& probe)
+    {
+        ptr->inf = probe.inf();
+        ptr->sup = probe.sup();
+        return call_with(predicate.ptr(), view.ptr());
+    };
+}
+
+
+void pysegments::init_interval_view(py::module_& m)
+{
+    py::class_<IntervalView> klass(m, "IntervalView", R"pbdoc(
+    A read-only view of the interval being probed, passed to predicates when
+    segment is called with reuse_interval=True. The same view is updated in
+    place for every probe, so predicates must not keep a reference to it.
+    )pbdoc");
+
+    klass.def_readonly("inf", &IntervalView::inf);
+    klass.def_readonly("sup", &IntervalView::sup);
+    klass.def("contains", [](const IntervalView& self, double arg)
+    {
+        return self.inf <= arg && arg < self.sup;
+    }, "arg"_a);
+    klass.def("to_interval", [](const IntervalView& self)
+    {
+        return interval(self.inf, self.sup);
+    }, "Copy the current probe into a new Interval.");
+    klass.def("__repr__", [](const IntervalView& self)
+    {
+        return "IntervalView(" + std::to_string(self.inf) + ", " + std::to_string(self.sup) + ")";
+    });
+}
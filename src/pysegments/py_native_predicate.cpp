@@ -0,0 +1,146 @@
+#include "pysegments.h"
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+using pysegments::NativePredicate;
+using pysegments::NativePredicate2D;
+using pysegments::function_address;
+using pysegments::data_address;
+
+namespace
+{
+    NativePredicate make_native_predicate(const py::object& function, const py::object& data)
+    {
+        auto address = function_address(function);
+        if (address == 0)
+        {
+            throw py::value_error("function address must not be null");
+        }
+
+        auto* fn = reinterpret_cast<NativePredicate::function_t>(address);
+        auto* user_data = reinterpret_cast<void*>(data_address(data));
+
+        return {
+                [fn, user_data](const interval& ivl) { return fn(ivl.inf(), ivl.sup(), user_data); },
+                py::make_tuple(function, data)
+        };
+    }
+
+    NativePredicate2D make_native_predicate_2d(const py::object& function, const py::object& data)
+    {
+        auto address = function_address(function);
+        if (address == 0)
+        {
+            throw py::value_error("function address must not be null");
+        }
+
+        auto* fn = reinterpret_cast<NativePredicate2D::function_t>(address);
+        auto* user_data = reinterpret_cast<void*>(data_address(data));
+
+        return {
+                [fn, user_data](const rectangle& rect)
+                {
+                    return fn(rect.x.inf(), rect.x.sup(), rect.y.inf(), rect.y.sup(), user_data);
+                },
+                py::make_tuple(function, data)
+        };
+    }
+} // namespace
+
+
+/*
+ * Function pointers are accepted as a plain integer address, as a numba
+ * cfunc (which exposes its address), or as a ctypes function pointer.
+ * cffi pointers can be passed as int(ffi.cast("uintptr_t", fn)).
+ */
+std::uintptr_t pysegments::function_address(const py::object& function)
+{
+    if (py::isinstance<py::int_>(function))
+    {
+        return function.cast<std::uintptr_t>();
+    }
+    if (py::hasattr(function, "address"))
+    {
+        return function.attr("address").cast<std::uintptr_t>();
+    }
+
+    auto ctypes = py::module_::import("ctypes");
+    if (py::isinstance(function, ctypes.attr("_CFuncPtr")))
+    {
+        return ctypes.attr("cast")(function, ctypes.attr("c_void_p")).attr("value").cast<std::uintptr_t>();
+    }
+
+    throw py::type_error("expected a function address, a numba cfunc or a ctypes function pointer");
+}
+
+/*
+ * User data is passed to the function unchanged. It may be None, an
+ * integer address, a NumPy array or a ctypes object.
+ */
+std::uintptr_t pysegments::data_address(const py::object& data)
+{
+    if (data.is_none())
+    {
+        return 0;
+    }
+    if (py::isinstance<py::int_>(data))
+    {
+        return data.cast<std::uintptr_t>();
+    }
+    if (py::hasattr(data, "__array_interface__"))
+    {
+        return data.attr("__array_interface__")["data"].cast<py::tuple>()[0].cast<std::uintptr_t>();
+    }
+    return py::module_::import("ctypes").attr("addressof")(data).cast<std::uintptr_t>();
+}
+
+
+void pysegments::init_native_predicate(py::module_& m)
+{
+    py::class_<NativePredicate> klass(m, "NativePredicate", R"pbdoc(
+    A predicate implemented in native code with the C signature
+
+        bool predicate(double inf, double sup, void* user_data)
+
+    for example a numba cfunc with signature boolean(float64, float64, voidptr).
+    Searches with a native predicate do not enter the interpreter to evaluate
+    the predicate and run with the GIL released, so the function must not
+    call back into Python. The function and user data are kept alive for as
+    long as the predicate is.
+    )pbdoc");
+
+    klass.def(py::init(&make_native_predicate), "function"_a, "user_data"_a = py::none());
+    klass.def("__call__", [](const NativePredicate& self, const interval& arg)
+    {
+        if (!self.lock)
+        {
+            return self.predicate(arg);
+        }
+        std::unique_lock<std::mutex> guard(*self.lock, std::try_to_lock);
+        if (!guard)
+        {
+            py::gil_scoped_release release;
+            guard.lock();
+        }
+        return self.predicate(arg);
+    }, "interval"_a);
+
+    py::class_<NativePredicate2D> klass_2d(m, "NativePredicate2D", R"pbdoc(
+    A two-dimensional predicate implemented in native code with the C
+    signature
+
+        bool predicate(double x_inf, double x_sup, double y_inf, double y_sup, void* user_data)
+
+    for use with segment2d. As with NativePredicate, the search runs with
+    the GIL released.
+    )pbdoc");
+
+    klass_2d.def(py::init(&make_native_predicate_2d), "function"_a, "user_data"_a = py::none());
+    klass_2d.def("__call__", [](const NativePredicate2D& self, const interval& x, const interval& y)
+    {
+        return self.predicate({x, y});
+    }, "x"_a, "y"_a);
+}
@@ -0,0 +1,78 @@
+#include "pysegments.h"
+
+#include <utility>
+
+#include <predicate_cache.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    PredicateCache::eviction_policy get_policy(const std::string& policy)
+    {
+        if (policy == "lru")
+        {
+            return PredicateCache::eviction_policy::lru;
+        }
+        if (policy == "fifo")
+        {
+            return PredicateCache::eviction_policy::fifo;
+        }
+        throw py::value_error("eviction policy must be \"lru\" or \"fifo\"");
+    }
+} // namespace
+
+
+predicate_t pysegments::with_cache(const py::object& cache, predicate_t predicate)
+{
+    if (cache.is_none())
+    {
+        return predicate;
+    }
+    return cached_predicate(cache.cast<PredicateCache&>(), std::move(predicate));
+}
+
+
+void pysegments::init_predicate_cache(py::module_& m)
+{
+    py::class_<PredicateCache> klass(m, "PredicateCache", R"pbdoc(
+    A bounded, thread-safe cache of predicate results keyed on the exact
+    dyadic coordinates of each probe.
+
+    Pass the same cache to segment or segment_dyadic on overlapping windows
+    to reuse the results of probes that have already been evaluated. A cache
+    must only be shared by searches with the same predicate, and entries
+    must be invalidated when the data behind the predicate changes.
+    )pbdoc");
+
+    klass.def(py::init([](std::size_t capacity, const std::string& policy)
+    {
+        return new PredicateCache(capacity, get_policy(policy));
+    }), "capacity"_a, "policy"_a = "lru");
+
+    klass.def("invalidate", [](PredicateCache& self, const py::object& region)
+    {
+        if (region.is_none())
+        {
+            self.invalidate();
+        }
+        else
+        {
+            self.invalidate(region.cast<const interval&>());
+        }
+    }, "region"_a = py::none(),
+    "Remove every entry, or only those overlapping region.");
+
+    klass.def("__len__", &PredicateCache::size);
+    klass.def_property_readonly("capacity", &PredicateCache::capacity);
+    klass.def_property_readonly("policy", [](const PredicateCache& self)
+    {
+        return self.policy() == PredicateCache::eviction_policy::lru ? "lru" : "fifo";
+    });
+    klass.def_property_readonly("hits", &PredicateCache::hits);
+    klass.def_property_readonly("misses", &PredicateCache::misses);
+}
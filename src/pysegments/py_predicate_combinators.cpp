@@ -0,0 +1,104 @@
+#include "pysegments.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <predicate_combinators.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+using pysegments::NativePredicate;
+
+namespace
+{
+    /*
+     * Combined predicates are NativePredicates, so searches run with the GIL
+     * released. Native children are called directly; Python children take
+     * the GIL for each call. The Python objects are owned by the keep_alive
+     * tuple of the result, so the wrappers hold only borrowed pointers and
+     * can be copied without the GIL.
+     *
+     * A native child that carries a lock, such as a nested combinator, may
+     * be shared with other searches and combinators, so each call to it
+     * holds its lock. Locks are only ever taken from a parent to a child,
+     * so they cannot deadlock.
+     */
+    predicate_t as_predicate(const py::handle& child)
+    {
+        if (py::isinstance<NativePredicate>(child))
+        {
+            const auto& native = child.cast<const NativePredicate&>();
+            if (!native.lock)
+            {
+                return native.predicate;
+            }
+            return [predicate = native.predicate, lock = native.lock](const interval& probe)
+            {
+                std::lock_guard<std::mutex> guard(*lock);
+                return predicate(probe);
+            };
+        }
+        if (!PyCallable_Check(child.ptr()))
+        {
+            throw py::type_error("predicates must be callables or NativePredicate objects");
+        }
+
+        PyObject* function = child.ptr();
+        return [function](const interval& probe)
+        {
+            py::gil_scoped_acquire gil;
+            return py::handle(function)(probe).cast<bool>();
+        };
+    }
+
+    template <predicate_t (*Combine)(std::vector<predicate_t>, std::uint64_t)>
+    NativePredicate combine(const py::args& children, std::uint64_t reorder_interval)
+    {
+        std::vector<predicate_t> predicates;
+        predicates.reserve(children.size());
+        for (const auto& child : children)
+        {
+            predicates.push_back(as_predicate(child));
+        }
+        // The statistics of a combinator are not synchronised.
+        return {Combine(std::move(predicates), reorder_interval), py::tuple(children), std::make_shared<std::mutex>()};
+    }
+
+    // The negation shares the lock of a native child, which the search
+    // holds throughout, so the child is called directly.
+    NativePredicate py_negate(const py::object& child)
+    {
+        if (py::isinstance<NativePredicate>(child))
+        {
+            const auto& native = child.cast<const NativePredicate&>();
+            return {negate(native.predicate), py::make_tuple(child), native.lock};
+        }
+        return {negate(as_predicate(child)), py::make_tuple(child)};
+    }
+} // namespace
+
+
+void pysegments::init_predicate_combinators(py::module_& m)
+{
+    m.def("all_of", &combine<&segments::all_of>, "reorder_interval"_a = 256, R"pbdoc(
+    A NativePredicate that is true when every one of the given predicates is.
+
+    The predicates are evaluated in an order that is learned during the
+    search: the combinator records how long each predicate takes and how
+    often it is false, and every reorder_interval calls moves the cheap,
+    selective ones to the front. The predicates may be NativePredicates,
+    which are called without the GIL, or Python callables.
+    )pbdoc");
+
+    m.def("any_of", &combine<&segments::any_of>, "reorder_interval"_a = 256, R"pbdoc(
+    A NativePredicate that is true when any of the given predicates is,
+    evaluated in an adaptive order as for all_of.
+    )pbdoc");
+
+    m.def("negate", &py_negate, "predicate"_a, "A NativePredicate that is true when predicate is false.");
+}
@@ -0,0 +1,116 @@
+#include "pysegments.h"
+
+#include <optional>
+#include <vector>
+
+#include <pybind11/numpy.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    using bool_array = py::array_t<bool, py::array::c_style | py::array::forcecast>;
+
+    /// The found rectangles as an (N, 4) array of x_inf, x_sup, y_inf, y_sup.
+    py::array_t<double> rectangle_array(const std::vector<rectangle>& found)
+    {
+        py::array_t<double> result({static_cast<py::ssize_t>(found.size()), py::ssize_t(4)});
+        auto out = result.mutable_unchecked<2>();
+        for (py::ssize_t i = 0; i < static_cast<py::ssize_t>(found.size()); ++i)
+        {
+            out(i, 0) = found[i].x.inf();
+            out(i, 1) = found[i].x.sup();
+            out(i, 2) = found[i].y.inf();
+            out(i, 3) = found[i].y.sup();
+        }
+        return result;
+    }
+
+    /*
+     * A vectorised predicate is called once for each level of the quadtree
+     * with four arrays holding the bounds of every square in the level, and
+     * returns a boolean array of the same length.
+     */
+    batch_predicate2d_t vectorised_predicate(const py::function& predicate)
+    {
+        return [predicate](const rectangle* cells, std::size_t count, bool* results)
+        {
+            const auto size = static_cast<py::ssize_t>(count);
+            py::array_t<double> x_inf(size), x_sup(size), y_inf(size), y_sup(size);
+            auto* pxi = x_inf.mutable_data();
+            auto* pxs = x_sup.mutable_data();
+            auto* pyi = y_inf.mutable_data();
+            auto* pys = y_sup.mutable_data();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                pxi[i] = cells[i].x.inf();
+                pxs[i] = cells[i].x.sup();
+                pyi[i] = cells[i].y.inf();
+                pys[i] = cells[i].y.sup();
+            }
+
+            auto answer = bool_array::ensure(predicate(x_inf, x_sup, y_inf, y_sup));
+            if (!answer || answer.size() != size)
+            {
+                throw py::value_error("vectorised predicate must return one boolean for each square");
+            }
+            std::copy(answer.data(), answer.data() + size, results);
+        };
+    }
+
+    py::array_t<double> py_segment2d(interval x,
+                                     interval y,
+                                     const py::object& predicate,
+                                     py::object pytol,
+                                     py::object pysignal_tol,
+                                     py::object pystart,
+                                     bool vectorised)
+    {
+        const rectangle base{x, y};
+        const auto& shorter = (x.sup() - x.inf() <= y.sup() - y.inf()) ? x : y;
+        auto tol = pysegments::get_tolerance(shorter, pytol, pysignal_tol);
+
+        QuadtreeSearcher searcher(std::max(tol.trim, tol.signal), tol.signal, pysegments::get_start_depth(pystart));
+        if (py::isinstance<pysegments::NativePredicate2D>(predicate))
+        {
+            const auto& native = predicate.cast<const pysegments::NativePredicate2D&>();
+            py::gil_scoped_release release;
+            searcher.search(base, native.predicate);
+        }
+        else if (vectorised)
+        {
+            searcher.search_batched(base, vectorised_predicate(predicate.cast<py::function>()));
+        }
+        else
+        {
+            auto function = predicate.cast<py::function>();
+            searcher.search(base, [&function](const rectangle& rect)
+            {
+                return function(rect.x.inf(), rect.x.sup(), rect.y.inf(), rect.y.sup()).cast<bool>();
+            });
+        }
+
+        return rectangle_array(searcher.result());
+    }
+} // namespace
+
+
+void pysegments::init_quadtree(py::module_& m)
+{
+    m.def("segment2d", &py_segment2d, "x"_a, "y"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "vectorised"_a = false,
+          R"pbdoc(
+    Segment the rectangle x * y into dyadic squares on which predicate holds.
+
+    The predicate is called with the bounds x_inf, x_sup, y_inf, y_sup of
+    each square. With vectorised=True it is instead called once for each
+    level of the quadtree with four arrays of bounds and must return a
+    boolean array. A NativePredicate2D runs without the GIL. Returns an
+    (N, 4) array of x_inf, x_sup, y_inf, y_sup for the squares found,
+    clipped to the rectangle.
+    )pbdoc");
+}
@@ -0,0 +1,62 @@
+#include "pysegments.h"
+
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <run_segmentation.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    using run_array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+    std::vector<interval> py_segment_runs(interval arg,
+                                          const run_array& starts,
+                                          const run_array& ends,
+                                          py::object pytol,
+                                          py::object pysignal_tol,
+                                          py::object pystart,
+                                          unsigned threads)
+    {
+        if (starts.ndim() != 1 || ends.ndim() != 1 || starts.size() != ends.size())
+        {
+            throw py::value_error("starts and ends must be one-dimensional arrays of the same length");
+        }
+
+        auto tol = pysegments::get_tolerance(arg, pytol, pysignal_tol);
+        auto start_depth = pysegments::get_start_depth(pystart);
+
+        py::gil_scoped_release release;
+        RunSet runs(starts.data(), ends.data(), static_cast<std::size_t>(starts.size()));
+        if (threads == 1)
+        {
+            return segment_runs(arg, runs, tol.signal, tol.trim, start_depth);
+        }
+        return segment_runs_parallel(arg, runs, tol.signal, tol.trim, start_depth, threads);
+    }
+} // namespace
+
+
+void pysegments::init_run_segmentation(py::module_& m)
+{
+    m.def("segment_runs", &py_segment_runs, "interval"_a, "starts"_a, "ends"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "threads"_a = 1,
+          R"pbdoc(
+    Segment interval for a predicate that is known to hold exactly on the
+    runs [starts[i], ends[i]), which must be sorted by start.
+
+    The result is the same as segment with a predicate that tests whether
+    an interval lies inside the runs, but is computed from the run endpoints
+    without scanning the interval, so is much faster for long intervals and
+    fine tolerances. With threads other than 1 the interval is split into
+    shards searched in parallel (0 uses every hardware thread), and the
+    segments are returned sorted by position.
+    )pbdoc");
+}
@@ -0,0 +1,156 @@
+#include "pysegments.h"
+
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <segment_index.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    /*
+     * Query arrays are taken without forcecast, so C-contiguous float64
+     * arrays are read in place and only other inputs are converted.
+     */
+    using point_array = py::array_t<double, py::array::c_style>;
+
+    std::vector<py::ssize_t> shape_of(const py::array& arr)
+    {
+        return {arr.shape(), arr.shape() + arr.ndim()};
+    }
+
+    py::array_t<std::ptrdiff_t> locate_points(const SegmentIndex& index,
+                                              const point_array& points,
+                                              const py::object& is_sorted,
+                                              unsigned threads)
+    {
+        py::array_t<std::ptrdiff_t> result(shape_of(points));
+        auto* out = result.mutable_data();
+        const auto* data = points.data();
+        const auto count = static_cast<std::size_t>(points.size());
+
+        py::gil_scoped_release release;
+        if (is_sorted.is_none())
+        {
+            index.locate(data, count, out, threads);
+        }
+        else if (is_sorted.cast<bool>())
+        {
+            index.locate_sorted(data, count, out, threads);
+        }
+        else
+        {
+            index.locate_unsorted(data, count, out, threads);
+        }
+        return result;
+    }
+
+    py::array_t<bool> contains_points(const SegmentIndex& index,
+                                      const point_array& points,
+                                      const py::object& is_sorted,
+                                      unsigned threads)
+    {
+        auto located = locate_points(index, points, is_sorted, threads);
+        py::array_t<bool> result(shape_of(points));
+        auto* out = result.mutable_data();
+        const auto* idx = located.data();
+        const auto size = located.size();
+
+        py::gil_scoped_release release;
+        for (py::ssize_t i = 0; i < size; ++i)
+        {
+            out[i] = idx[i] != SegmentIndex::npos;
+        }
+        return result;
+    }
+
+    py::tuple overlapping_ranges(const SegmentIndex& index,
+                                 const point_array& infs,
+                                 const point_array& sups,
+                                 unsigned threads)
+    {
+        if (infs.size() != sups.size())
+        {
+            throw py::value_error("infs and sups must have the same size");
+        }
+
+        py::array_t<std::size_t> first(shape_of(infs));
+        py::array_t<std::size_t> last(shape_of(infs));
+        auto* pfirst = first.mutable_data();
+        auto* plast = last.mutable_data();
+        const auto* pinfs = infs.data();
+        const auto* psups = sups.data();
+        const auto count = static_cast<std::size_t>(infs.size());
+
+        {
+            py::gil_scoped_release release;
+            index.overlapping(pinfs, psups, count, pfirst, plast, threads);
+        }
+        return py::make_tuple(std::move(first), std::move(last));
+    }
+
+} // namespace
+
+
+void pysegments::init_segment_index(py::module_& m)
+{
+    py::class_<SegmentIndex> py_index(m, "SegmentIndex");
+
+    py_index.def(py::init<std::vector<interval>>(), "segments"_a);
+
+    py_index.def("__len__", &SegmentIndex::size);
+    py_index.def("__getitem__", [](const SegmentIndex& self, py::ssize_t idx)
+    {
+        const auto size = static_cast<py::ssize_t>(self.size());
+        if (idx < 0)
+        {
+            idx += size;
+        }
+        if (idx < 0 || idx >= size)
+        {
+            throw py::index_error("segment index out of range");
+        }
+        return self[static_cast<std::size_t>(idx)];
+    }, "idx"_a);
+    py_index.def_property_readonly("segments", [](const SegmentIndex& self)
+    {
+        std::vector<interval> result;
+        result.reserve(self.size());
+        for (std::size_t i = 0; i < self.size(); ++i)
+        {
+            result.push_back(self[i]);
+        }
+        return result;
+    });
+
+    py_index.def("locate", [](const SegmentIndex& self, double point)
+    {
+        return self.locate(point);
+    }, py::arg("point").noconvert());
+    py_index.def("locate", &locate_points, "points"_a, "sorted"_a = py::none(), "threads"_a = 0);
+
+    py_index.def("contains", [](const SegmentIndex& self, double point)
+    {
+        return self.locate(point) != SegmentIndex::npos;
+    }, py::arg("point").noconvert());
+    py_index.def("contains", &contains_points, "points"_a, "sorted"_a = py::none(), "threads"_a = 0);
+
+    py_index.def("overlapping", [](const SegmentIndex& self, const interval& arg)
+    {
+        return self.overlapping(arg);
+    }, "interval"_a);
+    py_index.def("overlapping", &overlapping_ranges, "infs"_a, "sups"_a, "threads"_a = 0);
+
+    py_index.def("__repr__", [](const SegmentIndex& self)
+    {
+        return "SegmentIndex(" + std::to_string(self.size()) + " segments)";
+    });
+}
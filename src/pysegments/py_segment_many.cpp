@@ -0,0 +1,149 @@
+#include "pysegments.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pybind11/stl.h>
+
+#include <expanding_searcher.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+using pysegments::NativePredicate;
+
+namespace
+{
+    struct search_job
+    {
+        interval arg;
+        pysegments::Tolerance tol;
+    };
+
+    /*
+     * The workers run without the GIL. A Python predicate is wrapped once,
+     * on the calling thread, in pybind11's function wrapper, which takes the
+     * GIL for each call and only for the duration of the call. With a GIL
+     * the calls are serialised, but the searches themselves still overlap;
+     * on a free-threaded interpreter the calls run in parallel as well.
+     */
+    std::vector<std::vector<interval>> segment_many(const std::vector<interval>& intervals,
+                                                    const py::object& predicate,
+                                                    py::object pytol,
+                                                    py::object pysignal_tol,
+                                                    py::object pystart,
+                                                    unsigned threads)
+    {
+        std::vector<search_job> jobs;
+        jobs.reserve(intervals.size());
+        for (const auto& arg : intervals)
+        {
+            jobs.push_back({arg, pysegments::get_tolerance(arg, pytol, pysignal_tol)});
+        }
+        const auto start_depth = pysegments::get_start_depth(pystart);
+
+        predicate_t search_predicate;
+        std::shared_ptr<std::mutex> lock;
+        if (py::isinstance<NativePredicate>(predicate))
+        {
+            const auto& native = predicate.cast<const NativePredicate&>();
+            search_predicate = native.predicate;
+            lock = native.lock;
+        }
+        else if (PyCallable_Check(predicate.ptr()))
+        {
+            search_predicate = pysegments::make_scalar_predicate(predicate.cast<py::function>(), false);
+        }
+        else
+        {
+            throw py::type_error("predicate must be a callable or a NativePredicate");
+        }
+
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, jobs.size()));
+
+        std::vector<std::vector<interval>> results(jobs.size());
+        std::atomic<std::size_t> next(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr error;
+        std::mutex error_lock;
+
+        auto worker = [&]()
+        {
+            for (auto i = next++; i < jobs.size() && !failed; i = next++)
+            {
+                try
+                {
+                    const auto& job = jobs[i];
+                    ExpandingSearcher searcher(std::max(job.tol.trim, job.tol.signal), job.tol.signal, start_depth);
+
+                    std::unique_lock<std::mutex> guard;
+                    if (lock)
+                    {
+                        guard = std::unique_lock<std::mutex>(*lock);
+                    }
+                    searcher.search_interval(job.arg, search_predicate);
+                    results[i] = std::move(searcher).result();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(error_lock);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+
+        {
+            py::gil_scoped_release release;
+            std::vector<std::thread> pool;
+            pool.reserve(threads);
+            for (unsigned t = 1; t < threads; ++t)
+            {
+                pool.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : pool)
+            {
+                thread.join();
+            }
+        }
+
+        // Python exceptions raised by the predicate are restored here, with
+        // the GIL held again.
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        return results;
+    }
+} // namespace
+
+
+void pysegments::init_segment_many(py::module_& m)
+{
+    m.def("segment_many", &segment_many, "intervals"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "threads"_a = 0, R"pbdoc(
+    Segment each of a list of intervals with the same predicate, searching
+    several intervals at once on a pool of threads, and return the list of
+    segments for each.
+
+    The predicate is either a NativePredicate, which runs without the GIL, or
+    a Python callable taking an Interval, which is called from several
+    threads at once. On a free-threaded build of Python these calls run in
+    parallel; otherwise they take turns holding the GIL. threads=0 uses one
+    thread per core. The searches are not recorded by trace().
+    )pbdoc");
+}
@@ -0,0 +1,111 @@
+#include "pysegments.h"
+
+#include <memory>
+#include <mutex>
+
+#include <pybind11/functional.h>
+
+#include <segment_stream.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    /*
+     * A stream over a native predicate releases the GIL while it searches
+     * for the next segment, holding the lock of the predicate if it has
+     * one. The predicate object is held so that the function it wraps stays
+     * alive for as long as the stream does. Calls to next from several
+     * threads are serialised by the lock of the stream, which is taken with
+     * the GIL released so that a thread waiting for it does not block the
+     * one searching.
+     */
+    struct PySegmentStream
+    {
+        SegmentStream stream;
+        bool native;
+        py::object keep_alive;
+        std::shared_ptr<std::mutex> predicate_lock;
+        std::mutex lock;
+
+        interval next()
+        {
+            interval segment(0.0, 0.0);
+            bool more;
+            if (native)
+            {
+                py::gil_scoped_release release;
+                std::lock_guard<std::mutex> guard(lock);
+                std::unique_lock<std::mutex> predicate_guard;
+                if (predicate_lock)
+                {
+                    predicate_guard = std::unique_lock<std::mutex>(*predicate_lock);
+                }
+                more = stream.next(segment);
+            }
+            else
+            {
+                std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+                if (!guard)
+                {
+                    py::gil_scoped_release release;
+                    guard.lock();
+                }
+                more = stream.next(segment);
+            }
+            if (!more)
+            {
+                throw py::stop_iteration();
+            }
+            return segment;
+        }
+    };
+
+    std::unique_ptr<PySegmentStream> make_stream(interval arg,
+                                                 predicate_t predicate,
+                                                 const py::object& pytol,
+                                                 const py::object& pysignal_tol,
+                                                 const py::object& pystart,
+                                                 bool native,
+                                                 py::object keep_alive,
+                                                 std::shared_ptr<std::mutex> predicate_lock)
+    {
+        auto tol = pysegments::get_tolerance(arg, pytol, pysignal_tol);
+        return std::unique_ptr<PySegmentStream>(new PySegmentStream{
+                SegmentStream(arg, std::move(predicate), tol.signal, tol.trim, pysegments::get_start_depth(pystart)),
+                native,
+                std::move(keep_alive),
+                std::move(predicate_lock)
+        });
+    }
+} // namespace
+
+
+void pysegments::init_segment_stream(py::module_& m)
+{
+    py::class_<PySegmentStream> klass(m, "SegmentStream", R"pbdoc(
+    An iterator over the segments of a base interval in increasing position,
+    created by segment_stream. Each segment is produced as soon as the search
+    has settled everything to its left.
+    )pbdoc");
+
+    klass.def("__iter__", [](PySegmentStream& self) -> PySegmentStream& { return self; });
+    klass.def("__next__", &PySegmentStream::next);
+
+    m.def("segment_stream", [](interval arg, const py::object& predicate, py::object pytol, py::object pysignal_tol,
+                               py::object pystart)
+    {
+        if (py::isinstance<NativePredicate>(predicate))
+        {
+            const auto& native = predicate.cast<const NativePredicate&>();
+            return make_stream(arg, native.predicate, pytol, pysignal_tol, pystart, true, predicate, native.lock);
+        }
+        return make_stream(arg, predicate.cast<predicate_t>(), pytol, pysignal_tol, pystart, false, py::none(), nullptr);
+    }, "interval"_a, "predicate"_a, "tolerance"_a = py::none(), "signal_tolerance"_a = py::none(),
+          "start_depth"_a = py::none(),
+          "Lazily segment interval, yielding segments in increasing position.");
+}
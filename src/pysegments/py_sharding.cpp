@@ -0,0 +1,76 @@
+#include "pysegments.h"
+
+#include <vector>
+
+#include <pybind11/functional.h>
+#include <pybind11/stl.h>
+
+#include <sharding.h>
+
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using namespace segments;
+
+namespace
+{
+    shard_plan py_plan_shards(interval arg,
+                              std::size_t count,
+                              const py::object& pytol,
+                              const py::object& pysignal_tol,
+                              const py::object& pystart)
+    {
+        auto tol = pysegments::get_tolerance(arg, pytol, pysignal_tol);
+        return plan_shards(arg, count, tol.signal, tol.trim, pysegments::get_start_depth(pystart));
+    }
+
+    py::tuple plan_state(const shard_plan& plan)
+    {
+        return py::make_tuple(plan.base, plan.shards, plan.signal_tolerance, plan.trim_tolerance, plan.start_depth);
+    }
+
+    shard_plan plan_from_state(const py::tuple& state)
+    {
+        return {
+                state[0].cast<interval>(),
+                state[1].cast<std::vector<interval>>(),
+                state[2].cast<depth_t>(),
+                state[3].cast<depth_t>(),
+                state[4].cast<depth_t>()
+        };
+    }
+} // namespace
+
+
+void pysegments::init_sharding(py::module_& m)
+{
+    py::class_<shard_plan> klass(m, "ShardPlan", R"pbdoc(
+    A split of a base interval into shards that can be segmented
+    independently, for instance in separate processes, and then stitched
+    back together with stitch_shards. Stitching reproduces segment on the
+    whole base interval for predicates that pick out a union of runs.
+
+    Plans can be pickled, so they can be sent to worker processes along with
+    the index of the shard to search.
+    )pbdoc");
+
+    klass.def_readonly("base", &shard_plan::base);
+    klass.def_readonly("shards", &shard_plan::shards);
+    klass.def_readonly("signal_tolerance", &shard_plan::signal_tolerance);
+    klass.def_readonly("trim_tolerance", &shard_plan::trim_tolerance);
+    klass.def_readonly("start_depth", &shard_plan::start_depth);
+    klass.def("__len__", [](const shard_plan& self) { return self.shards.size(); });
+    klass.def(py::pickle(&plan_state, &plan_from_state));
+
+    m.def("plan_shards", &py_plan_shards, "interval"_a, "count"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(),
+          "Split interval into at most count shards on dyadic-aligned boundaries.");
+    m.def("segment_shard", &segment_shard, "plan"_a, "shard"_a, "predicate"_a,
+          "Segment a single shard of plan.");
+    m.def("stitch_shards", &stitch_shards, "plan"_a, "results"_a, "predicate"_a,
+          "Join the segments found in each shard of plan into the segments of the base interval.\n\n"
+          "The result is that of segment on the base interval when the predicate is true on an interval\n"
+          "exactly when it lies inside one of a fixed set of disjoint runs. Other predicates can be split\n"
+          "differently near the cuts between shards.");
+}
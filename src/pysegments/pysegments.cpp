@@ -6,24 +6,29 @@
 
 #include <sstream>
 #include <cmath>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <expanding_searcher.h>
+#include <predicate_trace.h>
+#include <search_tracer.h>
+
 
 namespace py = pybind11;
 using namespace pybind11::literals;
 
 using namespace segments;
+using pysegments::Tolerance;
+using pysegments::get_tolerance;
+using pysegments::get_start_depth;
 
 namespace
 {
-    struct Tolerance
-    {
-        depth_t trim;
-        depth_t signal;
-    };
-
     depth_t from_length(const interval& arg) noexcept
     {
         auto length = arg.sup() - arg.inf();
@@ -32,62 +37,386 @@ namespace
         return -std::min(0, expo - 2);
     }
 
-    inline
-    Tolerance get_tolerance(const interval& arg, const py::object& pytol, const py::object& pysignal_tol)
+    /*
+     * Searches started from Python are written to the active trace while one
+     * is being recorded. A tracer is not safe to share between threads, so
+     * each traced search holds the lock of the trace, and keeps the trace
+     * alive until it finishes even if the trace is stopped meanwhile. Without
+     * a GIL, searches can start and traces can stop on several threads at
+     * once, so the active trace itself is guarded too. A search started by a
+     * predicate of a traced search, on the thread that holds the trace, is
+     * not recorded.
+     */
+    struct ActiveTrace
+    {
+        std::mutex lock;
+        SearchTracer tracer;
+
+        explicit ActiveTrace(const std::string& path) : tracer(path) {}
+    };
+
+    std::mutex active_trace_lock;
+    std::shared_ptr<ActiveTrace> active_trace;
+    thread_local const ActiveTrace* held_trace = nullptr;
+
+    struct TraceGuard
     {
-        Tolerance result{0, 0};
-        if (pytol.is_none() && pysignal_tol.is_none())
+        std::unique_lock<std::mutex> lock;
+
+        TraceGuard() = default;
+        TraceGuard(TraceGuard&&) = default;
+        TraceGuard& operator=(TraceGuard&&) = default;
+
+        ~TraceGuard()
         {
-            result.signal = from_length(arg);
-            result.trim = result.signal;
+            if (lock.owns_lock())
+            {
+                held_trace = nullptr;
+            }
         }
-        else if (pytol.is_none())
+    };
+
+    struct PySearcher
+    {
+        ExpandingSearcher searcher;
+        std::shared_ptr<ActiveTrace> trace;
+        TraceGuard trace_guard;
+    };
+
+    PySearcher make_searcher(const Tolerance& tol, const py::object& pystart)
+    {
+        PySearcher result{ExpandingSearcher(std::max(tol.trim, tol.signal), tol.signal, get_start_depth(pystart)), {}, {}};
         {
-            result.signal = pysignal_tol.cast<depth_t>();
-            result.trim = result.signal;
+            std::lock_guard<std::mutex> guard(active_trace_lock);
+            result.trace = active_trace;
         }
-        else if (pysignal_tol.is_none())
+        if (result.trace && result.trace.get() == held_trace)
         {
-            result.trim = pytol.cast<depth_t>();
-            result.signal = result.trim;
+            result.trace.reset();
         }
-        else
+        if (result.trace)
         {
-            result.signal = pysignal_tol.cast<depth_t>();
-            result.trim = pytol.cast<depth_t>();
+            // Wait for another traced search without blocking threads that
+            // need the GIL to let it finish.
+            auto& lock = result.trace_guard.lock;
+            lock = std::unique_lock<std::mutex>(result.trace->lock, std::try_to_lock);
+            if (!lock)
+            {
+                py::gil_scoped_release release;
+                lock.lock();
+            }
+            held_trace = result.trace.get();
+            result.searcher.m_tracer = &result.trace->tracer;
         }
+        return result;
+    }
 
+    void py_start_trace(const std::string& path)
+    {
+        std::lock_guard<std::mutex> guard(active_trace_lock);
+        if (active_trace)
+        {
+            throw std::runtime_error("a search trace is already being recorded");
+        }
+        active_trace = std::make_shared<ActiveTrace>(path);
+    }
 
-        return result;
+    void py_stop_trace()
+    {
+        std::shared_ptr<ActiveTrace> finished;
+        {
+            std::lock_guard<std::mutex> guard(active_trace_lock);
+            finished = std::move(active_trace);
+        }
     }
 
     std::vector<interval> py_segment(interval arg,
-                                     predicate_t&& predicate,
+                                     const py::function& predicate,
                                      py::object pytol,
-                                     py::object pysignal_tol
+                                     py::object pysignal_tol,
+                                     py::object pystart,
+                                     bool reuse_interval,
+                                     const py::object& cache
     )
     {
-        auto tol = get_tolerance(arg, pytol, pysignal_tol);
+        auto search = make_searcher(get_tolerance(arg, pytol, pysignal_tol), pystart);
+        search.searcher.search_interval(arg, pysegments::with_cache(cache, pysegments::make_scalar_predicate(predicate, reuse_interval)));
+        return std::move(search.searcher).result();
+    }
+
+    /*
+     * Native predicates never enter the interpreter, so the search runs with
+     * the GIL released. The lock of the predicate is taken only once the GIL
+     * is released, since the search holding it may be inside a combinator
+     * waiting for the GIL to call a Python child.
+     */
+    void search_native(ExpandingSearcher& searcher,
+                       const interval& arg,
+                       const pysegments::NativePredicate& predicate,
+                       const py::object& cache)
+    {
+        auto native = pysegments::with_cache(cache, predicate.predicate);
+
+        py::gil_scoped_release release;
+        std::unique_lock<std::mutex> guard;
+        if (predicate.lock)
+        {
+            guard = std::unique_lock<std::mutex>(*predicate.lock);
+        }
+        searcher.search_interval(arg, native);
+    }
 
-        return segment(arg, predicate, tol.signal, tol.trim);
+    std::vector<interval> py_segment_native(interval arg,
+                                            const pysegments::NativePredicate& predicate,
+                                            py::object pytol,
+                                            py::object pysignal_tol,
+                                            py::object pystart,
+                                            const py::object& cache)
+    {
+        auto search = make_searcher(get_tolerance(arg, pytol, pysignal_tol), pystart);
+        search_native(search.searcher, arg, predicate, cache);
+        return std::move(search.searcher).result();
+    }
+
+    /*
+     * The query functions answer a single question about the segments of a
+     * search, stopping as soon as it is answered, for either a Python
+     * callable or a native predicate.
+     */
+    ExpandingSearcher py_query(interval arg,
+                               const py::object& predicate,
+                               const py::object& pytol,
+                               const py::object& pysignal_tol,
+                               const py::object& pystart,
+                               bool reuse_interval,
+                               const py::object& cache,
+                               query_mode mode)
+    {
+        auto search = make_searcher(get_tolerance(arg, pytol, pysignal_tol), pystart);
+        search.searcher.m_mode = mode;
+        if (py::isinstance<pysegments::NativePredicate>(predicate))
+        {
+            search_native(search.searcher, arg, predicate.cast<const pysegments::NativePredicate&>(), cache);
+        }
+        else if (PyCallable_Check(predicate.ptr()))
+        {
+            auto scalar = pysegments::make_scalar_predicate(predicate.cast<py::function>(), reuse_interval);
+            search.searcher.search_interval(arg, pysegments::with_cache(cache, std::move(scalar)));
+        }
+        else
+        {
+            throw py::type_error("predicate must be a callable or a NativePredicate");
+        }
+        return std::move(search.searcher);
+    }
+
+    bool py_any_segment(interval arg, const py::object& predicate, const py::object& pytol,
+                        const py::object& pysignal_tol, const py::object& pystart, bool reuse_interval,
+                        const py::object& cache)
+    {
+        return py_query(arg, predicate, pytol, pysignal_tol, pystart, reuse_interval, cache, query_mode::any).m_count != 0;
+    }
+
+    std::optional<interval> py_first_segment(interval arg, const py::object& predicate, const py::object& pytol,
+                                             const py::object& pysignal_tol, const py::object& pystart,
+                                             bool reuse_interval, const py::object& cache)
+    {
+        auto searcher = py_query(arg, predicate, pytol, pysignal_tol, pystart, reuse_interval, cache, query_mode::first);
+        if (searcher.m_count == 0)
+        {
+            return std::nullopt;
+        }
+        return searcher.first_found();
+    }
+
+    std::size_t py_count_segments(interval arg, const py::object& predicate, const py::object& pytol,
+                                  const py::object& pysignal_tol, const py::object& pystart, bool reuse_interval,
+                                  const py::object& cache)
+    {
+        return py_query(arg, predicate, pytol, pysignal_tol, pystart, reuse_interval, cache, query_mode::count).m_count;
+    }
+
+    double py_segment_measure(interval arg, const py::object& predicate, const py::object& pytol,
+                              const py::object& pysignal_tol, const py::object& pystart, bool reuse_interval,
+                              const py::object& cache)
+    {
+        return py_query(arg, predicate, pytol, pysignal_tol, pystart, reuse_interval, cache, query_mode::measure).m_measure;
     }
 
     std::vector<interval> py_segment_two_floats(interval arg,
                                                 std::function<bool(double, double)> predicate,
-                                                py::object pytol, py::object pysignal_tol)
+                                                py::object pytol, py::object pysignal_tol,
+                                                py::object pystart)
     {
-        auto tol = get_tolerance(arg, pytol, pysignal_tol);
-
-        return segment(arg, [predicate](const interval& ivl)
+        auto search = make_searcher(get_tolerance(arg, pytol, pysignal_tol), pystart);
+        search.searcher.search_interval(arg, [predicate](const interval& ivl)
         {
             return predicate(ivl.inf(), ivl.sup());
-        }, tol.signal, tol.trim);
+        });
+        return std::move(search.searcher).result();
+    }
+
+    py::tuple dyadic_arrays(const std::vector<dyadic_segment>& found)
+    {
+        const auto size = static_cast<py::ssize_t>(found.size());
+        py::array_t<mult_t> inf_k(size);
+        py::array_t<depth_t> inf_n(size);
+        py::array_t<mult_t> sup_k(size);
+        py::array_t<depth_t> sup_n(size);
+
+        auto* pinf_k = inf_k.mutable_data();
+        auto* pinf_n = inf_n.mutable_data();
+        auto* psup_k = sup_k.mutable_data();
+        auto* psup_n = sup_n.mutable_data();
+        for (py::ssize_t i = 0; i < size; ++i)
+        {
+            pinf_k[i] = found[i].inf.k;
+            pinf_n[i] = found[i].inf.n;
+            psup_k[i] = found[i].sup.k;
+            psup_n[i] = found[i].sup.n;
+        }
+
+        return py::make_tuple(std::move(inf_k), std::move(inf_n), std::move(sup_k), std::move(sup_n));
+    }
+
+    py::tuple py_segment_dyadic(interval arg,
+                                const py::function& predicate,
+                                py::object pytol,
+                                py::object pysignal_tol,
+                                py::object pystart,
+                                bool reuse_interval,
+                                const py::object& cache)
+    {
+        auto search = make_searcher(get_tolerance(arg, pytol, pysignal_tol), pystart);
+        search.searcher.m_record_dyadic = true;
+        search.searcher.search_interval(arg, pysegments::with_cache(cache, pysegments::make_scalar_predicate(predicate, reuse_interval)));
+        return dyadic_arrays(std::move(search.searcher).dyadic_result());
+    }
+
+    py::tuple py_segment_dyadic_native(interval arg,
+                                       const pysegments::NativePredicate& predicate,
+                                       py::object pytol,
+                                       py::object pysignal_tol,
+                                       py::object pystart,
+                                       const py::object& cache)
+    {
+        auto search = make_searcher(get_tolerance(arg, pytol, pysignal_tol), pystart);
+        search.searcher.m_record_dyadic = true;
+        search_native(search.searcher, arg, predicate, cache);
+        return dyadic_arrays(std::move(search.searcher).dyadic_result());
+    }
+
+    py::dict py_segment_pyramid(interval arg,
+                                const py::object& predicate,
+                                const std::vector<depth_t>& signal_tolerances,
+                                const py::object& pytol,
+                                const py::object& pystart)
+    {
+        const auto trim = pytol.is_none() ? 0 : pytol.cast<depth_t>();
+        const auto start = get_start_depth(pystart);
+
+        std::vector<std::vector<interval>> levels;
+        if (py::isinstance<pysegments::NativePredicate>(predicate))
+        {
+            const auto& native = predicate.cast<const pysegments::NativePredicate&>();
+            py::gil_scoped_release release;
+            std::unique_lock<std::mutex> guard;
+            if (native.lock)
+            {
+                guard = std::unique_lock<std::mutex>(*native.lock);
+            }
+            levels = segment_pyramid(arg, native.predicate, signal_tolerances, trim, start);
+        }
+        else
+        {
+            auto wrapped = pysegments::make_scalar_predicate(predicate.cast<py::function>(), false);
+            levels = segment_pyramid(arg, wrapped, signal_tolerances, trim, start);
+        }
+
+        py::dict result;
+        for (std::size_t i = 0; i < levels.size(); ++i)
+        {
+            result[py::int_(signal_tolerances[i])] = py::cast(std::move(levels[i]));
+        }
+        return result;
+    }
+
+    std::vector<interval> py_record_trace(const std::string& path,
+                                          interval arg,
+                                          const predicate_t& predicate,
+                                          py::object pytol,
+                                          py::object pysignal_tol,
+                                          py::object pystart)
+    {
+        auto tol = get_tolerance(arg, pytol, pysignal_tol);
+
+        return record_segment(path, arg, predicate, tol.signal, tol.trim, get_start_depth(pystart));
+    }
+
+    std::vector<interval> py_replay_trace(const std::string& path)
+    {
+        TraceReplay replay(path);
+
+        py::gil_scoped_release release;
+        return replay_segment(replay);
     }
 } // namespace
 
 
+Tolerance pysegments::get_tolerance(const interval& arg, const py::object& pytol, const py::object& pysignal_tol)
+{
+    Tolerance result{0, 0};
+    if (pytol.is_none() && pysignal_tol.is_none())
+    {
+        result.signal = from_length(arg);
+        result.trim = result.signal;
+    }
+    else if (pytol.is_none())
+    {
+        result.signal = pysignal_tol.cast<depth_t>();
+        result.trim = result.signal;
+    }
+    else if (pysignal_tol.is_none())
+    {
+        result.trim = pytol.cast<depth_t>();
+        result.signal = result.trim;
+    }
+    else
+    {
+        result.signal = pysignal_tol.cast<depth_t>();
+        result.trim = pytol.cast<depth_t>();
+    }
+
+
+    return result;
+}
+
+depth_t pysegments::get_start_depth(const py::object& pystart)
+{
+    if (pystart.is_none())
+    {
+        return 0;
+    }
+    if (py::isinstance<py::str>(pystart))
+    {
+        if (pystart.cast<std::string>() != "auto")
+        {
+            throw py::value_error("start_depth must be an integer, None or \"auto\"");
+        }
+        return adaptive_start_depth;
+    }
+    return pystart.cast<depth_t>();
+}
+
+
 PYBIND11_MODULE(_segments, m)
 {
+#ifdef Py_GIL_DISABLED
+    // Shared state is guarded by its own locks, so the module can run on a
+    // free-threaded interpreter without re-enabling the GIL.
+    PyUnstable_Module_SetGIL(m.ptr(), Py_MOD_GIL_NOT_USED);
+#endif
+
     py::class_<interval> py_interval(m, "Interval");
 
     py_interval.def(py::init<double, double>(), "a"_a = 0.0, "b"_a = 1.0);
@@ -120,9 +449,79 @@ PYBIND11_MODULE(_segments, m)
     {
         return segments::interval(self);
     }, "memo"_a);
+    py_interval.def(py::pickle([](const interval& self)
+    {
+        return py::make_tuple(self.inf(), self.sup());
+    }, [](const py::tuple& state)
+    {
+        return interval(state[0].cast<double>(), state[1].cast<double>());
+    }));
 
+    pysegments::init_native_predicate(m);
+    pysegments::init_predicate_combinators(m);
+    pysegments::init_expression(m);
+    pysegments::init_aggregate_tree(m);
+    pysegments::init_interval_view(m);
+    pysegments::init_predicate_cache(m);
+
+    // Native predicates come first so they are not wrapped as Python callables.
+    m.def("segment", &py_segment_native, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "cache"_a = py::none());
     m.def("segment", &py_segment, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
-          "signal_tolerance"_a = py::none());
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "reuse_interval"_a = false,
+          "cache"_a = py::none());
     m.def("segment", &py_segment_two_floats, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
-          "signal_tolerance"_a = py::none());
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none());
+
+    m.def("segment_dyadic", &py_segment_dyadic_native, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "cache"_a = py::none());
+    m.def("segment_dyadic", &py_segment_dyadic, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "reuse_interval"_a = false,
+          "cache"_a = py::none());
+
+    m.def("any_segment", &py_any_segment, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "reuse_interval"_a = false,
+          "cache"_a = py::none(),
+          "Whether segment would find any segment, stopping at the first probe on which predicate holds.");
+    m.def("first_segment", &py_first_segment, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "reuse_interval"_a = false,
+          "cache"_a = py::none(), R"pbdoc(
+    The leftmost segment segment would find, or None if there are none. Once
+    a segment is found, only the part of interval to its left is searched
+    further.
+    )pbdoc");
+    m.def("count_segments", &py_count_segments, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "reuse_interval"_a = false,
+          "cache"_a = py::none(), "The number of segments segment would find, without building them.");
+    m.def("segment_measure", &py_segment_measure, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none(), "reuse_interval"_a = false,
+          "cache"_a = py::none(), "The total length of the segments segment would find, without building them.");
+
+    m.def("segment_pyramid", &py_segment_pyramid, "interval"_a, "predicate"_a, "signal_tolerances"_a,
+          "tolerance"_a = py::none(), "start_depth"_a = py::none(), R"pbdoc(
+    Segment interval at each of several signal tolerances from one search.
+
+    Returns a dict mapping each signal tolerance to the list of segments
+    segment would return for it. Every level is trimmed to the same
+    tolerance, which is at least the finest signal tolerance, so that each
+    level is a stage of the finest search and no probes are repeated.
+    )pbdoc");
+
+    m.def("record_trace", &py_record_trace, "path"_a, "interval"_a, "predicate"_a, "tolerance"_a = py::none(),
+          "signal_tolerance"_a = py::none(), "start_depth"_a = py::none());
+    m.def("replay_trace", &py_replay_trace, "path"_a);
+
+    m.def("start_trace", &py_start_trace, "path"_a,
+          "Write the timeline of subsequent searches to path as Chrome trace-event JSON.");
+    m.def("stop_trace", &py_stop_trace, "Finish the active search trace, if any.");
+    py::module_::import("atexit").attr("register")(py::cpp_function(&py_stop_trace));
+
+    pysegments::init_dyadic(m);
+    pysegments::init_segment_index(m);
+    pysegments::init_segment_stream(m);
+    pysegments::init_quadtree(m);
+    pysegments::init_run_segmentation(m);
+    pysegments::init_bottom_up(m);
+    pysegments::init_sharding(m);
+    pysegments::init_segment_many(m);
 }
@@ -5,10 +5,90 @@
 #ifndef SEGMENTS_PYSEGMENTS_H
 #define SEGMENTS_PYSEGMENTS_H
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
 #include <segments.h>
+#include <quadtree_searcher.h>
 #include <pybind11/pybind11.h>
 
 
+namespace pysegments {
+
+struct Tolerance
+{
+    segments::depth_t trim;
+    segments::depth_t signal;
+};
+
+/// Resolve the tolerance and signal_tolerance arguments of segment, either
+/// of which may be None.
+Tolerance get_tolerance(const segments::interval& arg,
+                        const pybind11::object& pytol,
+                        const pybind11::object& pysignal_tol);
+
+/// Wrap a Python predicate taking an interval. With reuse_interval, a single
+/// IntervalView is updated in place and passed to every call instead of a
+/// new Interval for each probe.
+segments::predicate_t make_scalar_predicate(const pybind11::function& predicate, bool reuse_interval);
+
+/// Wrap predicate with the PredicateCache cache, unless cache is None.
+segments::predicate_t with_cache(const pybind11::object& cache, segments::predicate_t predicate);
+
+/// A predicate implemented in native code, such as a numba cfunc or a ctypes
+/// or cffi function pointer, that can be evaluated without holding the GIL.
+///
+/// Native predicates are called from several threads at once by concurrent
+/// searches. A predicate that is not safe for that, such as a combinator
+/// that keeps statistics, carries a lock that each search holds throughout.
+struct NativePredicate
+{
+    using function_t = bool (*)(double, double, void*);
+
+    segments::predicate_t predicate;
+    pybind11::object keep_alive;
+    std::shared_ptr<std::mutex> lock = nullptr;
+};
+
+/// A two-dimensional predicate implemented in native code, called with the
+/// bounds of a rectangle as x_inf, x_sup, y_inf, y_sup.
+struct NativePredicate2D
+{
+    using function_t = bool (*)(double, double, double, double, void*);
+
+    segments::predicate2d_t predicate;
+    pybind11::object keep_alive;
+};
+
+/// The address of a native function given as an integer, a numba cfunc or
+/// a ctypes function pointer.
+std::uintptr_t function_address(const pybind11::object& function);
+
+/// The address of the user data passed to a native function, given as None,
+/// an integer, a NumPy array or a ctypes object.
+std::uintptr_t data_address(const pybind11::object& data);
+
+/// Resolve the start_depth argument of segment, which may be None, "auto"
+/// or an integer.
+segments::depth_t get_start_depth(const pybind11::object& pystart);
+
+void init_native_predicate(pybind11::module_& m);
+void init_aggregate_tree(pybind11::module_& m);
+void init_bottom_up(pybind11::module_& m);
+void init_interval_view(pybind11::module_& m);
+void init_predicate_cache(pybind11::module_& m);
+void init_predicate_combinators(pybind11::module_& m);
+void init_expression(pybind11::module_& m);
+void init_quadtree(pybind11::module_& m);
+void init_run_segmentation(pybind11::module_& m);
+void init_dyadic(pybind11::module_& m);
+void init_segment_index(pybind11::module_& m);
+void init_segment_stream(pybind11::module_& m);
+void init_sharding(pybind11::module_& m);
+void init_segment_many(pybind11::module_& m);
+
+} // namespace pysegments
 
 
 #endif //SEGMENTS_PYSEGMENTS_H
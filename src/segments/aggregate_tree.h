@@ -0,0 +1,242 @@
+#ifndef SEGMENTS_AGGREGATE_TREE_H
+#define SEGMENTS_AGGREGATE_TREE_H
+
+#include "segments.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace segments {
+
+/*
+ * An aggregate tree holds the combined value of a monoid over the samples
+ * in every dyadic block, from blocks of length 2^-resolution up to the
+ * blocks either side of zero, so that a predicate testing an associative
+ * summary of the samples in a probe reads one precomputed node instead of
+ * visiting every sample. Probes finer than the resolution combine the few
+ * samples they contain directly.
+ *
+ * A monoid provides
+ *
+ *     using value_type = ...;
+ *     value_type identity() const;
+ *     value_type combine(const value_type& left, const value_type& right) const;
+ *
+ * where combine is associative and identity is its unit. The left argument
+ * always covers the earlier samples, so order dependent summaries such as
+ * path increments can be used. Memory is proportional to the number of
+ * cells of length 2^-resolution spanned by the samples.
+ */
+template <typename Monoid>
+class AggregateTree {
+public:
+    using value_type = typename Monoid::value_type;
+
+private:
+    struct level {
+        std::int64_t first_block;
+        std::vector<value_type> nodes;
+    };
+
+    Monoid m_monoid;
+    depth_t m_resolution;
+    std::vector<double> m_positions;
+    std::vector<value_type> m_values;
+    std::vector<level> m_levels;
+
+    static std::int64_t floor_shift(std::int64_t value, std::int64_t shift) noexcept
+    {
+        if (shift >= 63) {
+            return value < 0 ? -1 : 0;
+        }
+        return value >> shift;
+    }
+
+    value_type node(const level& lvl, std::int64_t block) const
+    {
+        if (block < lvl.first_block || block - lvl.first_block >= static_cast<std::int64_t>(lvl.nodes.size())) {
+            return m_monoid.identity();
+        }
+        return lvl.nodes[static_cast<std::size_t>(block - lvl.first_block)];
+    }
+
+    value_type combine_samples(double inf, double sup) const
+    {
+        auto begin = std::lower_bound(m_positions.begin(), m_positions.end(), inf);
+        auto end = std::lower_bound(begin, m_positions.end(), sup);
+        auto result = m_monoid.identity();
+        for (auto it = begin; it != end; ++it) {
+            result = m_monoid.combine(result, m_values[static_cast<std::size_t>(it - m_positions.begin())]);
+        }
+        return result;
+    }
+
+public:
+    /// Build the tree over values at the sorted positions. Throws
+    /// std::invalid_argument if the positions are not sorted or the two
+    /// lengths differ.
+    AggregateTree(std::vector<double> positions,
+                  std::vector<value_type> values,
+                  depth_t resolution,
+                  Monoid monoid = Monoid())
+        : m_monoid(std::move(monoid)),
+          m_resolution(resolution),
+          m_positions(std::move(positions)),
+          m_values(std::move(values))
+    {
+        if (m_positions.size() != m_values.size()) {
+            throw std::invalid_argument("sample positions and values must have the same length");
+        }
+        if (!std::is_sorted(m_positions.begin(), m_positions.end())) {
+            throw std::invalid_argument("sample positions must be sorted");
+        }
+        if (m_positions.empty()) {
+            return;
+        }
+
+        auto cell = [resolution](double position) {
+            const auto scaled = std::floor(std::ldexp(position, resolution));
+            if (!(std::abs(scaled) < 0x1p62)) {
+                throw std::invalid_argument("sample position is out of range at this resolution");
+            }
+            return static_cast<std::int64_t>(scaled);
+        };
+
+        level leaves{cell(m_positions.front()), {}};
+        leaves.nodes.assign(static_cast<std::size_t>(cell(m_positions.back()) - leaves.first_block) + 1,
+                            m_monoid.identity());
+        for (std::size_t i = 0; i < m_positions.size(); ++i) {
+            auto& leaf = leaves.nodes[static_cast<std::size_t>(cell(m_positions[i]) - leaves.first_block)];
+            leaf = m_monoid.combine(leaf, m_values[i]);
+        }
+        m_levels.push_back(std::move(leaves));
+
+        // Each level combines pairs of blocks of the level below until only
+        // the blocks either side of zero remain.
+        for (;;) {
+            const auto& below = m_levels.back();
+            const auto last = below.first_block + static_cast<std::int64_t>(below.nodes.size()) - 1;
+            level next{floor_shift(below.first_block, 1), {}};
+            if (next.first_block == below.first_block && floor_shift(last, 1) == last) {
+                break;
+            }
+            next.nodes.reserve(static_cast<std::size_t>(floor_shift(last, 1) - next.first_block) + 1);
+            for (auto block = next.first_block; block <= floor_shift(last, 1); ++block) {
+                next.nodes.push_back(m_monoid.combine(node(below, 2 * block), node(below, 2 * block + 1)));
+            }
+            m_levels.push_back(std::move(next));
+        }
+    }
+
+    depth_t resolution() const noexcept { return m_resolution; }
+    std::size_t size() const noexcept { return m_positions.size(); }
+    const Monoid& monoid() const noexcept { return m_monoid; }
+
+    /// The combined value of the samples in block, which may be at any depth.
+    value_type query(const dyadic_interval& block) const
+    {
+        if (m_levels.empty()) {
+            return m_monoid.identity();
+        }
+
+        const auto shift = std::int64_t(m_resolution) - std::int64_t(block.n);
+        if (shift < 0) {
+            const interval ivl(block);
+            return combine_samples(ivl.inf(), ivl.sup());
+        }
+        // The top level only has the blocks -1 and 0, which hold the same
+        // samples as the blocks -1 and 0 at every coarser level.
+        const auto top = static_cast<std::int64_t>(m_levels.size()) - 1;
+        return node(m_levels[static_cast<std::size_t>(std::min(shift, top))], block.k);
+    }
+
+    /// The combined value of the samples in a probe passed to a predicate
+    /// during a search.
+    value_type query(const interval& probe) const
+    {
+        return query(probe_coordinates(probe));
+    }
+
+    /// A predicate testing the combined value of the samples in each probe.
+    /// The tree must outlive it.
+    template <typename Test>
+    predicate_t predicate(Test test) const
+    {
+        return [this, test = std::move(test)](const interval& probe) {
+            return static_cast<bool>(test(query(probe)));
+        };
+    }
+};
+
+
+/// The sum of the samples, such as the increment of a path over a block when
+/// the samples are its increments.
+template <typename T = double>
+struct sum_monoid {
+    using value_type = T;
+    value_type identity() const { return T(); }
+    value_type combine(const value_type& left, const value_type& right) const { return left + right; }
+};
+
+template <typename T = double>
+struct min_monoid {
+    using value_type = T;
+    value_type identity() const { return std::numeric_limits<T>::infinity(); }
+    value_type combine(const value_type& left, const value_type& right) const { return std::min(left, right); }
+};
+
+template <typename T = double>
+struct max_monoid {
+    using value_type = T;
+    value_type identity() const { return -std::numeric_limits<T>::infinity(); }
+    value_type combine(const value_type& left, const value_type& right) const { return std::max(left, right); }
+};
+
+/// The count, mean, sum of squared deviations from the mean, min and max of
+/// the samples, combined with the parallel update of Chan et al. so the
+/// variance does not suffer the cancellation of summing squares.
+struct moments {
+    double count = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    moments() = default;
+    explicit moments(double sample) : count(1.0), mean(sample), min(sample), max(sample) {}
+
+    double sum() const noexcept { return count * mean; }
+    double variance() const noexcept { return count > 0.0 ? m2 / count : std::numeric_limits<double>::quiet_NaN(); }
+};
+
+struct moments_monoid {
+    using value_type = moments;
+    value_type identity() const { return {}; }
+
+    value_type combine(const value_type& left, const value_type& right) const
+    {
+        if (left.count == 0.0) {
+            return right;
+        }
+        if (right.count == 0.0) {
+            return left;
+        }
+        value_type result;
+        result.count = left.count + right.count;
+        const auto delta = right.mean - left.mean;
+        result.mean = left.mean + delta * right.count / result.count;
+        result.m2 = left.m2 + right.m2 + delta * delta * left.count * right.count / result.count;
+        result.min = std::min(left.min, right.min);
+        result.max = std::max(left.max, right.max);
+        return result;
+    }
+};
+
+} // namespace segments
+
+#endif //SEGMENTS_AGGREGATE_TREE_H
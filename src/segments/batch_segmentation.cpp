@@ -0,0 +1,475 @@
+#include "batch_segmentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "expanding_searcher.h"
+#include "run_segmentation.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SEGMENTS_BATCH_MMAP 1
+#endif
+
+
+using namespace segments;
+
+
+namespace
+{
+    constexpr char input_magic[8] = {'S', 'E', 'G', 'B', 'A', 'T', 'C', 'H'};
+    constexpr char output_magic[8] = {'S', 'E', 'G', 'B', 'T', 'O', 'U', 'T'};
+    constexpr std::uint32_t batch_version = 1;
+    constexpr std::size_t input_header_size = 32;
+    constexpr std::size_t table_entry_size = 32;
+
+    template <typename T>
+    void put(std::vector<char>& buffer, const T& value)
+    {
+        const auto* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    T get(const unsigned char* data, std::size_t pos)
+    {
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    T get(std::istream& in)
+    {
+        T value;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        {
+            throw std::runtime_error("unexpected end of batch output");
+        }
+        return value;
+    }
+
+    std::vector<char> file_header(const char (&magic)[8], std::uint64_t window_count)
+    {
+        std::vector<char> header(std::begin(magic), std::end(magic));
+        put(header, batch_version);
+        put(header, std::uint32_t(0));
+        put(header, window_count);
+        return header;
+    }
+
+    /// The index of the first value at or after position x in window.
+    std::size_t value_index(const batch_window& window, double x) noexcept
+    {
+        const auto scaled = std::ceil((x - window.base.inf()) * static_cast<double>(window.count)
+                                      / (window.base.sup() - window.base.inf()));
+        if (!(scaled > 0.0))
+        {
+            return 0;
+        }
+        if (scaled >= static_cast<double>(window.count))
+        {
+            return window.count;
+        }
+        return static_cast<std::size_t>(scaled);
+    }
+}
+
+
+BatchInputWriter::BatchInputWriter(const std::string& path)
+    : m_out(path, std::ios::binary | std::ios::trunc)
+{
+    if (!m_out)
+    {
+        throw std::runtime_error("could not open batch input " + path + " for writing");
+    }
+
+    // The header is completed by finish, once the table offset is known.
+    auto header = file_header(input_magic, 0);
+    put(header, std::uint64_t(0));
+    m_out.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+void BatchInputWriter::add(const interval& base, const double* values, std::size_t count)
+{
+    if (m_finished)
+    {
+        throw std::logic_error("cannot add windows to a finished batch input");
+    }
+    if (!(base.inf() < base.sup()))
+    {
+        throw std::invalid_argument("batch windows must not be empty");
+    }
+
+    m_out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(double)));
+    m_table.push_back({base.inf(), base.sup(), m_value_count, count});
+    m_value_count += count;
+}
+
+void BatchInputWriter::finish()
+{
+    if (m_finished)
+    {
+        return;
+    }
+
+    const std::uint64_t table_offset = input_header_size + m_value_count * sizeof(double);
+    static_assert(sizeof(table_entry) == table_entry_size, "window table entries must be 32 bytes");
+    m_out.write(reinterpret_cast<const char*>(m_table.data()),
+                static_cast<std::streamsize>(m_table.size() * table_entry_size));
+
+    auto header = file_header(input_magic, m_table.size());
+    put(header, table_offset);
+    m_out.seekp(0);
+    m_out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    if (!m_out.flush())
+    {
+        throw std::runtime_error("failed to write batch input");
+    }
+    m_finished = true;
+}
+
+
+BatchInput::BatchInput(const std::string& path)
+{
+#ifdef SEGMENTS_BATCH_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("could not open batch input " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("could not read the size of batch input " + path);
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (m_size != 0)
+    {
+        void* mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("could not map batch input " + path);
+        }
+        m_data = static_cast<const unsigned char*>(mapped);
+    }
+    else
+    {
+        ::close(fd);
+    }
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("could not open batch input " + path);
+    }
+    m_storage.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    m_data = m_storage.data();
+    m_size = m_storage.size();
+#endif
+
+    try
+    {
+        if (m_size < input_header_size || std::memcmp(m_data, input_magic, sizeof(input_magic)) != 0)
+        {
+            throw std::runtime_error(path + " is not a batch input");
+        }
+        if (get<std::uint32_t>(m_data, 8) != batch_version)
+        {
+            throw std::runtime_error("unsupported batch input version in " + path);
+        }
+        m_window_count = get<std::uint64_t>(m_data, 16);
+        m_table_offset = get<std::uint64_t>(m_data, 24);
+
+        if (m_table_offset < input_header_size || m_table_offset > m_size
+            || m_window_count > (m_size - m_table_offset) / table_entry_size)
+        {
+            throw std::runtime_error("truncated window table in batch input " + path);
+        }
+        const auto value_count = (m_table_offset - input_header_size) / sizeof(double);
+        for (std::uint64_t i = 0; i < m_window_count; ++i)
+        {
+            const auto pos = m_table_offset + table_entry_size * i;
+            const auto first = get<std::uint64_t>(m_data, pos + 16);
+            const auto count = get<std::uint64_t>(m_data, pos + 24);
+            if (first > value_count || count > value_count - first)
+            {
+                throw std::runtime_error("window " + std::to_string(i) + " of batch input " + path
+                                         + " refers to values past the end of the file");
+            }
+        }
+    }
+    catch (...)
+    {
+#ifdef SEGMENTS_BATCH_MMAP
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<unsigned char*>(m_data), m_size);
+        }
+#endif
+        throw;
+    }
+}
+
+BatchInput::~BatchInput()
+{
+#ifdef SEGMENTS_BATCH_MMAP
+    if (m_data != nullptr)
+    {
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+}
+
+batch_window BatchInput::operator[](std::size_t index) const noexcept
+{
+    const auto pos = m_table_offset + table_entry_size * index;
+    const auto first = get<std::uint64_t>(m_data, pos + 16);
+
+    // The values start on an 8 byte boundary of the mapping, which is page
+    // aligned, so they can be read in place.
+    return {interval(get<double>(m_data, pos), get<double>(m_data, pos + 8)),
+            reinterpret_cast<const double*>(m_data + input_header_size) + first,
+            static_cast<std::size_t>(get<std::uint64_t>(m_data, pos + 24))};
+}
+
+
+BatchOutputWriter::BatchOutputWriter(const std::string& path, std::uint64_t window_count)
+    : m_out(path, std::ios::binary | std::ios::trunc)
+{
+    if (!m_out)
+    {
+        throw std::runtime_error("could not open batch output " + path + " for writing");
+    }
+    write(file_header(output_magic, window_count));
+}
+
+void BatchOutputWriter::write(const std::vector<char>& records)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (!m_out.write(records.data(), static_cast<std::streamsize>(records.size())))
+    {
+        throw std::runtime_error("failed to write batch output");
+    }
+}
+
+void BatchOutputWriter::flush()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (!m_out.flush())
+    {
+        throw std::runtime_error("failed to write batch output");
+    }
+}
+
+void segments::encode_batch_record(std::vector<char>& buffer, std::uint64_t index, const std::vector<interval>& segments)
+{
+    put(buffer, index);
+    put(buffer, static_cast<std::uint32_t>(segments.size()));
+    for (const auto& segment : segments)
+    {
+        put(buffer, segment.inf());
+        put(buffer, segment.sup());
+    }
+}
+
+std::vector<std::vector<interval>> segments::read_batch_output(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("could not open batch output " + path);
+    }
+
+    char magic[sizeof(output_magic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, output_magic, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error(path + " is not a batch output");
+    }
+    if (get<std::uint32_t>(in) != batch_version)
+    {
+        throw std::runtime_error("unsupported batch output version in " + path);
+    }
+    get<std::uint32_t>(in);
+    const auto window_count = get<std::uint64_t>(in);
+
+    std::vector<std::vector<interval>> result(window_count);
+    std::vector<bool> seen(window_count, false);
+    for (std::uint64_t i = 0; i < window_count; ++i)
+    {
+        const auto index = get<std::uint64_t>(in);
+        const auto count = get<std::uint32_t>(in);
+        if (index >= window_count || seen[index])
+        {
+            throw std::runtime_error("invalid window index in batch output " + path);
+        }
+        seen[index] = true;
+
+        auto& segments = result[index];
+        segments.reserve(count);
+        for (std::uint32_t j = 0; j < count; ++j)
+        {
+            const auto inf = get<double>(in);
+            const auto sup = get<double>(in);
+            segments.emplace_back(inf, sup);
+        }
+    }
+    return result;
+}
+
+
+window_predicate_t segments::threshold_predicate(double lower, double upper)
+{
+    return [lower, upper](const batch_window& window) -> predicate_t
+    {
+        return [window, lower, upper](const interval& probe)
+        {
+            const auto begin = value_index(window, probe.inf());
+            const auto end = value_index(window, probe.sup());
+            if (begin == end)
+            {
+                return false;
+            }
+            return std::all_of(window.values + begin, window.values + end, [lower, upper](double value)
+            {
+                return lower <= value && value <= upper;
+            });
+        };
+    };
+}
+
+window_predicate_t segments::run_predicate()
+{
+    return [](const batch_window& window) -> predicate_t
+    {
+        if (window.count % 2 != 0)
+        {
+            throw std::invalid_argument("run windows must hold an even number of values");
+        }
+        const auto runs = window.count / 2;
+        return RunSet(window.values, window.values + runs, runs);
+    };
+}
+
+
+batch_progress segments::segment_batch(const BatchInput& input,
+                                       const window_predicate_t& predicate,
+                                       const batch_options& options,
+                                       BatchOutputWriter& output,
+                                       const std::function<void(const batch_progress&)>& progress,
+                                       std::chrono::duration<double> progress_interval)
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto total = input.size();
+    const auto chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+    const auto chunks = (total + chunk_size - 1) / chunk_size;
+    const auto trim_tolerance = std::max(options.trim_tolerance, options.signal_tolerance);
+
+    auto threads = options.threads;
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::max<std::size_t>(std::min<std::size_t>(threads, chunks), 1));
+
+    const auto start = clock::now();
+    std::atomic<std::size_t> next_chunk(0);
+    std::atomic<std::size_t> windows_done(0);
+    std::atomic<std::size_t> segments_found(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    std::mutex progress_lock;
+    auto last_report = start;
+
+    auto worker = [&]()
+    {
+        std::vector<char> buffer;
+        try
+        {
+            for (auto chunk = next_chunk++; chunk < chunks && !failed; chunk = next_chunk++)
+            {
+                const auto begin = chunk * chunk_size;
+                const auto end = std::min(begin + chunk_size, total);
+                std::size_t found = 0;
+
+                buffer.clear();
+                for (auto i = begin; i < end; ++i)
+                {
+                    const auto window = input[i];
+                    const auto window_predicate = predicate(window);
+
+                    ExpandingSearcher searcher(trim_tolerance, options.signal_tolerance, options.start_depth);
+                    searcher.search_interval(window.base, window_predicate);
+                    auto segments = std::move(searcher).result();
+
+                    found += segments.size();
+                    encode_batch_record(buffer, i, segments);
+                }
+                output.write(buffer);
+
+                windows_done += end - begin;
+                segments_found += found;
+                if (progress)
+                {
+                    // A thread that finds another reporting skips its report.
+                    std::unique_lock<std::mutex> guard(progress_lock, std::try_to_lock);
+                    const auto now = clock::now();
+                    if (guard && now - last_report >= progress_interval && windows_done < total)
+                    {
+                        last_report = now;
+                        progress({windows_done, total, segments_found, now - start});
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    output.flush();
+
+    batch_progress result{windows_done, total, segments_found, clock::now() - start};
+    if (progress)
+    {
+        progress(result);
+    }
+    return result;
+}
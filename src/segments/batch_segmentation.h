@@ -0,0 +1,168 @@
+#ifndef SEGMENTS_BATCH_SEGMENTATION_H
+#define SEGMENTS_BATCH_SEGMENTATION_H
+
+#include "segments.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace segments {
+
+/*
+ * Batch segmentation segments many base windows, each with its own array of
+ * values, read from one memory-mapped input file, and streams the segments
+ * of every window to one output file.
+ *
+ * The input file starts with a 32 byte header: the 8 byte magic "SEGBATCH",
+ * a uint32 format version, four zero bytes, the window count as a uint64 and
+ * the file offset of the window table as a uint64. The values of all windows
+ * follow as doubles, and then the window table, with the inf and sup of the
+ * window as doubles and the index of its first value and its value count as
+ * uint64s for each window.
+ *
+ * The output file starts with a 24 byte header: the 8 byte magic
+ * "SEGBTOUT", a uint32 format version, four zero bytes and the window count
+ * as a uint64. One record follows for each window, in the order the windows
+ * finish rather than the order of the input: the window index as a uint64,
+ * the segment count as a uint32 and the inf and sup of each segment as
+ * doubles. All values are stored in the byte order of the machine that
+ * wrote the file.
+ */
+
+/// A base window of a batch input and its values.
+struct batch_window {
+    interval base;
+    const double* values;
+    std::size_t count;
+};
+
+
+/// Writes a batch input file from windows added in order. The values are
+/// written as they are added; only the window table is held in memory.
+class BatchInputWriter {
+    struct table_entry {
+        double inf;
+        double sup;
+        std::uint64_t first;
+        std::uint64_t count;
+    };
+
+    std::ofstream m_out;
+    std::vector<table_entry> m_table;
+    std::uint64_t m_value_count = 0;
+    bool m_finished = false;
+
+public:
+    explicit BatchInputWriter(const std::string& path);
+
+    BatchInputWriter(const BatchInputWriter&) = delete;
+    BatchInputWriter& operator=(const BatchInputWriter&) = delete;
+
+    void add(const interval& base, const double* values, std::size_t count);
+
+    /// Write the window table and complete the header.
+    void finish();
+};
+
+
+/// A read-only, memory-mapped batch input file.
+class BatchInput {
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::vector<unsigned char> m_storage;
+    std::uint64_t m_window_count = 0;
+    std::uint64_t m_table_offset = 0;
+
+public:
+    explicit BatchInput(const std::string& path);
+    ~BatchInput();
+
+    BatchInput(const BatchInput&) = delete;
+    BatchInput& operator=(const BatchInput&) = delete;
+
+    std::size_t size() const noexcept { return static_cast<std::size_t>(m_window_count); }
+
+    /// The window at index, which must be less than size().
+    batch_window operator[](std::size_t index) const noexcept;
+};
+
+
+/// Writes the output of a batch segmentation. Records may be written from
+/// several threads at once.
+class BatchOutputWriter {
+    std::ofstream m_out;
+    std::mutex m_lock;
+
+public:
+    BatchOutputWriter(const std::string& path, std::uint64_t window_count);
+
+    BatchOutputWriter(const BatchOutputWriter&) = delete;
+    BatchOutputWriter& operator=(const BatchOutputWriter&) = delete;
+
+    /// Append encoded records, as produced by encode_batch_record.
+    void write(const std::vector<char>& records);
+
+    void flush();
+};
+
+/// Append the output record of the window at index to buffer.
+void encode_batch_record(std::vector<char>& buffer, std::uint64_t index, const std::vector<interval>& segments);
+
+/// Read a batch output file, returning the segments of each window in the
+/// order of the input.
+std::vector<std::vector<interval>> read_batch_output(const std::string& path);
+
+
+/// Makes the predicate searched for a window. The values remain valid for
+/// as long as the predicate is used.
+using window_predicate_t = std::function<predicate_t(const batch_window&)>;
+
+/// True on probes containing at least one value, all of which lie in
+/// [lower, upper]. Value i of a window of length L with count values is
+/// placed at inf + i * L / count.
+window_predicate_t threshold_predicate(double lower, double upper);
+
+/// True on probes inside one of the runs of the window. A window with 2m
+/// values holds m runs, with the sorted starts of the runs as the first m
+/// values and their ends as the last m values.
+window_predicate_t run_predicate();
+
+
+struct batch_options {
+    depth_t signal_tolerance;
+    depth_t trim_tolerance = 0;
+    depth_t start_depth = 0;
+    /// If 0 the number of hardware threads is used.
+    unsigned threads = 0;
+    /// The number of windows handed to a thread at a time.
+    std::size_t chunk_size = 256;
+};
+
+struct batch_progress {
+    std::size_t windows;
+    std::size_t total_windows;
+    std::size_t segments;
+    std::chrono::duration<double> elapsed;
+};
+
+/// Segment every window of input on a pool of threads, writing the segments
+/// to output. progress, if set, is called from one thread at a time at most
+/// once per progress_interval, and once more when the batch is complete.
+/// The first exception raised while segmenting a window stops the batch and
+/// is rethrown.
+batch_progress segment_batch(const BatchInput& input,
+                             const window_predicate_t& predicate,
+                             const batch_options& options,
+                             BatchOutputWriter& output,
+                             const std::function<void(const batch_progress&)>& progress = nullptr,
+                             std::chrono::duration<double> progress_interval = std::chrono::seconds(1));
+
+} // namespace segments
+
+#endif //SEGMENTS_BATCH_SEGMENTATION_H
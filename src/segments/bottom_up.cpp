@@ -0,0 +1,200 @@
+#include "bottom_up.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "expanding_searcher.h"
+#include "run_segmentation.h"
+
+
+using namespace segments;
+
+
+namespace
+{
+    struct cell_range
+    {
+        std::int64_t first;
+        std::int64_t end;
+    };
+
+    /// The multipliers of the dyadic intervals at depth that meet arg.
+    cell_range cells_meeting(const interval& arg, depth_t depth)
+    {
+        const auto first = std::floor(std::ldexp(arg.inf(), depth));
+        const auto end = std::ceil(std::ldexp(arg.sup(), depth));
+        if (!(std::abs(first) < 0x1p53 && std::abs(end) < 0x1p53))
+        {
+            throw std::invalid_argument("the intervals at the trim tolerance cannot be represented exactly");
+        }
+        return {static_cast<std::int64_t>(first), std::max(static_cast<std::int64_t>(end), static_cast<std::int64_t>(first))};
+    }
+
+    /// The multipliers at depth of the dyadic intervals inside the probes of
+    /// the search at first_depth that meet arg, which may overhang its ends.
+    cell_range cells_probed(const interval& arg, depth_t first_depth, depth_t depth)
+    {
+        const auto probes = cells_meeting(arg, first_depth);
+        return cells_meeting(interval(std::ldexp(static_cast<double>(probes.first), -first_depth),
+                                      std::ldexp(static_cast<double>(probes.end), -first_depth)), depth);
+    }
+}
+
+
+std::vector<interval> segments::segment_bottom_up(interval arg, const batch_predicate_t& predicate,
+                                                  depth_t signal_tolerance, depth_t trim_tolerance,
+                                                  depth_t start_depth, std::size_t batch_size)
+{
+    if (trim_tolerance < signal_tolerance)
+    {
+        trim_tolerance = signal_tolerance;
+    }
+    if (batch_size == 0)
+    {
+        throw std::invalid_argument("batch size must be positive");
+    }
+
+    const auto cells = cells_meeting(arg, trim_tolerance);
+    const auto total = static_cast<std::size_t>(cells.end - cells.first);
+    const auto size = std::min(batch_size, total);
+
+    std::vector<double> infs(size), sups(size);
+    std::unique_ptr<bool[]> results(new bool[size]);
+
+    const auto evaluate = [&](std::int64_t first, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto k = static_cast<double>(first + static_cast<std::int64_t>(i));
+            infs[i] = std::ldexp(k, -trim_tolerance);
+            sups[i] = std::ldexp(k + 1.0, -trim_tolerance);
+        }
+        predicate(infs.data(), sups.data(), count, results.get());
+    };
+
+    // Adjacent true cells, including those of adjacent batches, are merged
+    // into one run as they are found.
+    std::vector<double> starts, ends;
+    bool in_run = false;
+    for (auto batch = cells.first; batch < cells.end; batch += static_cast<std::int64_t>(size))
+    {
+        const auto count = static_cast<std::size_t>(std::min<std::int64_t>(cells.end - batch, size));
+        evaluate(batch, count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (results[i] && !in_run)
+            {
+                starts.push_back(infs[i]);
+                ends.push_back(sups[i]);
+            }
+            else if (results[i])
+            {
+                ends.back() = sups[i];
+            }
+            in_run = results[i];
+        }
+    }
+
+    /*
+     * The coarse probes at either end of arg overhang it, and the search
+     * finds a segment there when the run it lies in covers the whole probe.
+     * A run that reaches an end of arg is therefore followed past it, up to
+     * the extent of the probes at the start depth.
+     */
+    const ExpandingSearcher searcher(trim_tolerance, signal_tolerance, start_depth);
+    const auto probed = cells_probed(arg, searcher.start_depth(arg), trim_tolerance);
+
+    if (!starts.empty() && starts.front() == std::ldexp(static_cast<double>(cells.first), -trim_tolerance))
+    {
+        for (auto end = cells.first; end > probed.first;)
+        {
+            const auto count = static_cast<std::size_t>(std::min<std::int64_t>(end - probed.first, size));
+            end -= static_cast<std::int64_t>(count);
+            evaluate(end, count);
+
+            auto i = count;
+            while (i > 0 && results[i - 1])
+            {
+                --i;
+            }
+            starts.front() = (i == count) ? starts.front() : infs[i];
+            if (i > 0)
+            {
+                break;
+            }
+        }
+    }
+
+    if (!ends.empty() && ends.back() == std::ldexp(static_cast<double>(cells.end), -trim_tolerance))
+    {
+        for (auto first = cells.end; first < probed.end;)
+        {
+            const auto count = static_cast<std::size_t>(std::min<std::int64_t>(probed.end - first, size));
+            evaluate(first, count);
+            first += static_cast<std::int64_t>(count);
+
+            std::size_t i = 0;
+            while (i < count && results[i])
+            {
+                ++i;
+            }
+            ends.back() = (i == 0) ? ends.back() : sups[i - 1];
+            if (i < count)
+            {
+                break;
+            }
+        }
+    }
+
+    RunSet runs(starts.data(), ends.data(), starts.size());
+    return segment_runs(arg, runs, signal_tolerance, trim_tolerance, start_depth);
+}
+
+double segments::bottom_up_evaluations(interval arg, depth_t signal_tolerance, depth_t trim_tolerance)
+{
+    const auto depth = std::max(signal_tolerance, trim_tolerance);
+    return std::ceil(std::ldexp(arg.sup(), depth)) - std::floor(std::ldexp(arg.inf(), depth));
+}
+
+double segments::top_down_probes(interval arg, depth_t signal_tolerance, depth_t trim_tolerance)
+{
+    // Each depth has half the intervals of the next, so the scans to the
+    // signal tolerance probe at most twice the intervals of the finest scan.
+    // The expansion of each segment end adds one probe per depth down to the
+    // trim tolerance; with at most one segment in every other interval of
+    // the finest scan, that adds (trim - signal) probes per interval.
+    const auto finest = std::ldexp(arg.sup() - arg.inf(), signal_tolerance);
+    const auto expansion = std::max(trim_tolerance - signal_tolerance, 0);
+    return std::max(1.0, finest) * (2.0 + expansion);
+}
+
+search_engine segments::choose_engine(interval arg, depth_t signal_tolerance, depth_t trim_tolerance,
+                                      double batch_advantage)
+{
+    const auto batched = bottom_up_evaluations(arg, signal_tolerance, trim_tolerance) / batch_advantage;
+    return batched <= top_down_probes(arg, signal_tolerance, trim_tolerance)
+           ? search_engine::bottom_up
+           : search_engine::top_down;
+}
+
+std::vector<interval> segments::segment_auto(interval arg, const batch_predicate_t& predicate,
+                                             depth_t signal_tolerance, depth_t trim_tolerance,
+                                             depth_t start_depth, double batch_advantage)
+{
+    if (choose_engine(arg, signal_tolerance, trim_tolerance, batch_advantage) == search_engine::bottom_up)
+    {
+        return segment_bottom_up(arg, predicate, signal_tolerance, trim_tolerance, start_depth);
+    }
+
+    return segment(arg, [&predicate](const interval& probe) {
+        const double inf = probe.inf();
+        const double sup = probe.sup();
+        bool result = false;
+        predicate(&inf, &sup, 1, &result);
+        return result;
+    }, signal_tolerance, trim_tolerance, start_depth);
+}
@@ -0,0 +1,63 @@
+#ifndef SEGMENTS_BOTTOM_UP_H
+#define SEGMENTS_BOTTOM_UP_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace segments {
+
+/// A predicate evaluated on many intervals in one call, setting results[i]
+/// to its value on [infs[i], sups[i]).
+using batch_predicate_t = std::function<void(const double* infs, const double* sups, std::size_t count, bool* results)>;
+
+/// The engine used by segment_auto.
+enum class search_engine {
+    top_down,   ///< ExpandingSearcher, probing one interval at a time
+    bottom_up   ///< segment_bottom_up, evaluating every finest interval in batches
+};
+
+/*
+ * The bottom-up engine evaluates the predicate once on every dyadic interval
+ * at the trim tolerance that meets arg, in batches of consecutive intervals,
+ * merges the adjacent true intervals into runs and then computes the
+ * segmentation of those runs with segment_runs. A run reaching an end of arg
+ * is followed past it for as far as the coarsest probes of the search
+ * overhang arg, since the search finds a segment there only when the run
+ * covers the whole probe. For a predicate that holds
+ * on an interval exactly when it holds on each of the finest intervals
+ * making it up, such as a bound on the values a signal takes, the result is
+ * the same as segment, including the trimming of segment ends, but the
+ * predicate is evaluated in a single linear pass rather than by scattered
+ * probes.
+ */
+std::vector<interval> segment_bottom_up(interval arg, const batch_predicate_t& predicate, depth_t signal_tolerance,
+                                        depth_t trim_tolerance=0, depth_t start_depth=0,
+                                        std::size_t batch_size=65536);
+
+/// The number of dyadic intervals at the trim tolerance meeting arg, which
+/// is the number of evaluations made by segment_bottom_up apart from those
+/// following a run past the ends of arg.
+double bottom_up_evaluations(interval arg, depth_t signal_tolerance, depth_t trim_tolerance=0);
+
+/// An estimate of the number of probes made by segment, dominated by the
+/// scan of the dyadic intervals of each depth down to the signal tolerance
+/// that are not already inside a segment.
+double top_down_probes(interval arg, depth_t signal_tolerance, depth_t trim_tolerance=0);
+
+/// Choose the engine expected to be cheaper, given how many times cheaper
+/// an evaluation in a batch is than a single probe.
+search_engine choose_engine(interval arg, depth_t signal_tolerance, depth_t trim_tolerance=0,
+                            double batch_advantage=8.0);
+
+/// Segment arg with the engine chosen by choose_engine. The top-down engine
+/// calls predicate with batches of one interval. As the bottom-up engine may
+/// be chosen, the result matches segment only for predicates that hold on
+/// an interval exactly when they hold on each of its finest intervals.
+std::vector<interval> segment_auto(interval arg, const batch_predicate_t& predicate, depth_t signal_tolerance,
+                                   depth_t trim_tolerance=0, depth_t start_depth=0, double batch_advantage=8.0);
+
+} // namespace segments
+
+#endif //SEGMENTS_BOTTOM_UP_H
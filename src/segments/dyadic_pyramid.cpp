@@ -0,0 +1,386 @@
+#include "dyadic_pyramid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SEGMENTS_PYRAMID_MMAP 1
+#endif
+
+
+using namespace segments;
+
+
+namespace
+{
+    constexpr char pyramid_magic[8] = {'S', 'E', 'G', 'P', 'Y', 'R', 'M', 'D'};
+    constexpr std::uint32_t pyramid_version = 1;
+    constexpr std::size_t header_size = 64;
+    constexpr std::size_t level_entry_size = 24;
+    constexpr std::size_t record_size = sizeof(block_summary);
+    constexpr std::size_t buffer_records = 4096;
+
+    static_assert(record_size == 32, "block summaries must be stored as 32 byte records");
+
+    constexpr block_summary empty_summary{
+            std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity(),
+            0.0,
+            0
+    };
+
+    /// floor(value / 2^shift) for any non-negative shift.
+    inline std::int64_t floor_shift(std::int64_t value, std::int64_t shift) noexcept
+    {
+        if (shift >= 63)
+        {
+            return value < 0 ? -1 : 0;
+        }
+        return value >> shift;
+    }
+
+    /*
+     * The search addresses probes by a mult_t multiplier at each depth, and
+     * the end of the last cell must be addressable too, so every cell from
+     * first_cell to one past the last sample has to fit in a mult_t.
+     */
+    inline bool cells_fit_search(std::int64_t first_cell, std::uint64_t sample_count) noexcept
+    {
+        constexpr std::int64_t lowest = std::numeric_limits<mult_t>::min();
+        constexpr std::int64_t highest = std::numeric_limits<mult_t>::max();
+        return sample_count != 0 && lowest <= first_cell && first_cell < highest
+               && sample_count - 1 < static_cast<std::uint64_t>(highest - first_cell);
+    }
+
+    template <typename T>
+    void put(char* buffer, std::size_t& pos, const T& value)
+    {
+        std::memcpy(buffer + pos, &value, sizeof(T));
+        pos += sizeof(T);
+    }
+
+    template <typename T>
+    T get(const unsigned char* data, std::size_t pos)
+    {
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        return value;
+    }
+}
+
+
+PyramidBuilder::PyramidBuilder(const std::string& path,
+                               depth_t resolution,
+                               std::int64_t first_cell,
+                               std::uint64_t sample_count)
+    : m_out(path, std::ios::binary | std::ios::trunc),
+      m_resolution(resolution),
+      m_first_cell(first_cell),
+      m_sample_count(sample_count)
+{
+    if (sample_count == 0)
+    {
+        throw std::invalid_argument("a dyadic pyramid needs at least one sample");
+    }
+    if (!cells_fit_search(first_cell, sample_count))
+    {
+        throw std::invalid_argument("the cells of the samples do not fit the multipliers of the search");
+    }
+    if (!m_out)
+    {
+        throw std::runtime_error("could not open dyadic pyramid " + path + " for writing");
+    }
+
+    // Each level halves the number of blocks until they are the blocks on
+    // either side of zero, which are the same at every coarser level.
+    const auto last_cell = first_cell + static_cast<std::int64_t>(sample_count - 1);
+    for (std::int64_t shift = 0;; ++shift)
+    {
+        const auto last_block = floor_shift(last_cell, shift);
+        level lvl{};
+        lvl.first_block = floor_shift(first_cell, shift);
+        lvl.block_count = static_cast<std::uint64_t>(last_block - lvl.first_block) + 1;
+        lvl.pending_block = lvl.first_block;
+        lvl.pending = empty_summary;
+        m_levels.push_back(std::move(lvl));
+        if (floor_shift(first_cell, shift + 1) == m_levels.back().first_block
+            && floor_shift(last_cell, shift + 1) == last_block)
+        {
+            break;
+        }
+    }
+
+    std::uint64_t offset = header_size + level_entry_size * m_levels.size();
+    for (auto& lvl : m_levels)
+    {
+        lvl.offset = offset;
+        offset += lvl.block_count * record_size;
+        lvl.buffer.reserve(std::min<std::uint64_t>(lvl.block_count, buffer_records));
+    }
+
+    std::vector<char> header(header_size + level_entry_size * m_levels.size(), 0);
+    std::size_t pos = 0;
+    std::memcpy(header.data(), pyramid_magic, sizeof(pyramid_magic));
+    pos += sizeof(pyramid_magic);
+    put(header.data(), pos, pyramid_version);
+    put(header.data(), pos, static_cast<std::int32_t>(m_resolution));
+    put(header.data(), pos, m_first_cell);
+    put(header.data(), pos, m_sample_count);
+    put(header.data(), pos, static_cast<std::uint32_t>(m_levels.size()));
+
+    pos = header_size;
+    for (const auto& lvl : m_levels)
+    {
+        put(header.data(), pos, lvl.first_block);
+        put(header.data(), pos, lvl.block_count);
+        put(header.data(), pos, lvl.offset);
+    }
+    m_out.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+void PyramidBuilder::add(std::size_t lvl, std::int64_t block, const block_summary& summary)
+{
+    auto& current = m_levels[lvl];
+    if (!current.pending.empty() && current.pending_block != block)
+    {
+        emit(lvl);
+    }
+
+    auto& pending = current.pending;
+    current.pending_block = block;
+    pending.min = std::min(pending.min, summary.min);
+    pending.max = std::max(pending.max, summary.max);
+    pending.sum += summary.sum;
+    pending.count += summary.count;
+}
+
+void PyramidBuilder::emit(std::size_t lvl)
+{
+    auto& current = m_levels[lvl];
+    current.buffer.push_back(current.pending);
+    if (lvl + 1 < m_levels.size())
+    {
+        add(lvl + 1, floor_shift(current.pending_block, 1), current.pending);
+    }
+    current.pending = empty_summary;
+
+    if (current.buffer.size() == buffer_records)
+    {
+        flush(current);
+    }
+}
+
+void PyramidBuilder::flush(level& lvl)
+{
+    if (lvl.buffer.empty())
+    {
+        return;
+    }
+    m_out.seekp(static_cast<std::streamoff>(lvl.offset + lvl.written * record_size));
+    m_out.write(reinterpret_cast<const char*>(lvl.buffer.data()),
+                static_cast<std::streamsize>(lvl.buffer.size() * record_size));
+    if (!m_out)
+    {
+        throw std::runtime_error("failed to write dyadic pyramid");
+    }
+    lvl.written += lvl.buffer.size();
+    lvl.buffer.clear();
+}
+
+void PyramidBuilder::append(double value)
+{
+    if (m_appended == m_sample_count)
+    {
+        throw std::logic_error("more samples appended than declared for the dyadic pyramid");
+    }
+    add(0, m_first_cell + static_cast<std::int64_t>(m_appended++), {value, value, value, 1});
+}
+
+void PyramidBuilder::append(const double* values, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        append(values[i]);
+    }
+}
+
+void PyramidBuilder::finish()
+{
+    if (m_finished)
+    {
+        return;
+    }
+    if (m_appended != m_sample_count)
+    {
+        throw std::logic_error("fewer samples appended than declared for the dyadic pyramid");
+    }
+
+    // Emitting a level completes the pending block of the level above.
+    for (std::size_t lvl = 0; lvl < m_levels.size(); ++lvl)
+    {
+        if (!m_levels[lvl].pending.empty())
+        {
+            emit(lvl);
+        }
+        flush(m_levels[lvl]);
+    }
+    if (!m_out.flush())
+    {
+        throw std::runtime_error("failed to write dyadic pyramid");
+    }
+    m_finished = true;
+}
+
+
+DyadicPyramid::DyadicPyramid(const std::string& path)
+{
+#ifdef SEGMENTS_PYRAMID_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("could not open dyadic pyramid " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("could not read the size of dyadic pyramid " + path);
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (m_size != 0)
+    {
+        void* mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("could not map dyadic pyramid " + path);
+        }
+        m_data = static_cast<const unsigned char*>(mapped);
+    }
+    else
+    {
+        ::close(fd);
+    }
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("could not open dyadic pyramid " + path);
+    }
+    m_storage.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    m_data = m_storage.data();
+    m_size = m_storage.size();
+#endif
+
+    try
+    {
+        if (m_size < header_size || std::memcmp(m_data, pyramid_magic, sizeof(pyramid_magic)) != 0)
+        {
+            throw std::runtime_error(path + " is not a dyadic pyramid");
+        }
+        if (get<std::uint32_t>(m_data, 8) != pyramid_version)
+        {
+            throw std::runtime_error("unsupported dyadic pyramid version in " + path);
+        }
+        m_resolution = get<std::int32_t>(m_data, 12);
+        m_first_cell = get<std::int64_t>(m_data, 16);
+        m_sample_count = get<std::uint64_t>(m_data, 24);
+        const auto level_count = get<std::uint32_t>(m_data, 32);
+        if (!cells_fit_search(m_first_cell, m_sample_count))
+        {
+            throw std::runtime_error("the cells of dyadic pyramid " + path
+                                     + " do not fit the multipliers of the search");
+        }
+
+        if (level_count == 0 || m_size < header_size + level_entry_size * std::size_t(level_count))
+        {
+            throw std::runtime_error("truncated level table in dyadic pyramid " + path);
+        }
+        for (std::size_t i = 0; i < level_count; ++i)
+        {
+            const auto pos = header_size + level_entry_size * i;
+            level lvl{get<std::int64_t>(m_data, pos),
+                      get<std::uint64_t>(m_data, pos + 8),
+                      get<std::uint64_t>(m_data, pos + 16)};
+            if (lvl.offset > m_size || lvl.block_count > (m_size - lvl.offset) / record_size)
+            {
+                throw std::runtime_error("truncated level in dyadic pyramid " + path);
+            }
+            m_levels.push_back(lvl);
+        }
+    }
+    catch (...)
+    {
+#ifdef SEGMENTS_PYRAMID_MMAP
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<unsigned char*>(m_data), m_size);
+        }
+#endif
+        throw;
+    }
+}
+
+DyadicPyramid::~DyadicPyramid()
+{
+#ifdef SEGMENTS_PYRAMID_MMAP
+    if (m_data != nullptr)
+    {
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+}
+
+block_summary DyadicPyramid::read(const level& lvl, std::int64_t block) const noexcept
+{
+    if (block < lvl.first_block || static_cast<std::uint64_t>(block - lvl.first_block) >= lvl.block_count)
+    {
+        return empty_summary;
+    }
+    block_summary result;
+    std::memcpy(&result, m_data + lvl.offset + static_cast<std::uint64_t>(block - lvl.first_block) * record_size,
+                record_size);
+    return result;
+}
+
+block_summary DyadicPyramid::summary(const dyadic_interval& block) const noexcept
+{
+    const std::int64_t k = block.k;
+    const std::int64_t shift = std::int64_t(m_resolution) - std::int64_t(block.n);
+
+    if (shift < 0)
+    {
+        // A block finer than the sampling holds the sample at its left end,
+        // if it has one.
+        const auto finer = -shift;
+        if (finer >= 63 ? k != 0 : (k & ((std::int64_t(1) << finer) - 1)) != 0)
+        {
+            return empty_summary;
+        }
+        return read(m_levels.front(), finer >= 63 ? 0 : k >> finer);
+    }
+
+    if (static_cast<std::uint64_t>(shift) < m_levels.size())
+    {
+        return read(m_levels[static_cast<std::size_t>(shift)], k);
+    }
+
+    // The top level only has the blocks -1 and 0, which hold the same
+    // samples as the blocks -1 and 0 at every coarser level.
+    return read(m_levels.back(), k);
+}
+
+predicate_t DyadicPyramid::within(double lower, double upper) const
+{
+    return [this, lower, upper](const interval& probe) {
+        const auto found = summary(probe);
+        return !found.empty() && lower <= found.min && found.max <= upper;
+    };
+}
@@ -0,0 +1,141 @@
+#ifndef SEGMENTS_DYADIC_PYRAMID_H
+#define SEGMENTS_DYADIC_PYRAMID_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace segments {
+
+/*
+ * A dyadic pyramid stores the min, max, sum and count of a sampled signal
+ * over every dyadic block containing samples, at every level from the
+ * sampling resolution up to the level where the signal lies in the blocks
+ * [-1, 0) and [0, 1) scaled to that level, which no coarser block merges. Any
+ * probe of a search is then answered by reading one block summary, however
+ * many samples it covers, so searches over signals far larger than memory
+ * cost one small read of a memory-mapped file per probe.
+ *
+ * Samples are taken at consecutive points of the dyadic grid at depth
+ * resolution: sample i is at position (first_cell + i) / 2^resolution and
+ * is counted in every dyadic interval containing that position. A signal
+ * sampled at other positions must be rescaled onto the grid, as the search
+ * itself would be. The search addresses dyadic intervals with int
+ * multipliers, so the cells from first_cell up to one past the last sample
+ * must lie in the range of int; the builder and the reader reject pyramids
+ * outside it.
+ *
+ * The file starts with a 64 byte header: the 8 byte magic "SEGPYRMD", a
+ * uint32 format version, the resolution as an int32, the first cell as an
+ * int64, the sample count as a uint64 and the level count as a uint32,
+ * followed by zeros. Next is the level table, with the first block index
+ * as an int64 and the block count and file offset of the level as uint64s
+ * for each level from the finest. The block summaries follow as 32 byte
+ * records of min, max and sum as doubles and count as a uint64. All values
+ * are stored in the byte order of the machine that wrote the file.
+ */
+
+struct block_summary {
+    double min;
+    double max;
+    double sum;
+    std::uint64_t count;
+
+    bool empty() const noexcept { return count == 0; }
+    double mean() const noexcept { return sum / static_cast<double>(count); }
+};
+
+
+/// Writes a dyadic pyramid from samples appended in order. The number of
+/// samples must be given up front so that the levels can be laid out, after
+/// which only a few thousand block summaries per level are held in memory.
+class PyramidBuilder {
+    struct level {
+        std::int64_t first_block = 0;
+        std::uint64_t block_count = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t written = 0;
+        std::int64_t pending_block = 0;
+        block_summary pending;
+        std::vector<block_summary> buffer;
+    };
+
+    std::ofstream m_out;
+    depth_t m_resolution;
+    std::int64_t m_first_cell;
+    std::uint64_t m_sample_count;
+    std::uint64_t m_appended = 0;
+    std::vector<level> m_levels;
+    bool m_finished = false;
+
+    void add(std::size_t lvl, std::int64_t block, const block_summary& summary);
+    void emit(std::size_t lvl);
+    void flush(level& lvl);
+
+public:
+    PyramidBuilder(const std::string& path, depth_t resolution, std::int64_t first_cell, std::uint64_t sample_count);
+
+    PyramidBuilder(const PyramidBuilder&) = delete;
+    PyramidBuilder& operator=(const PyramidBuilder&) = delete;
+
+    void append(double value);
+    void append(const double* values, std::size_t count);
+
+    /// Write the remaining block summaries. Throws std::logic_error if fewer
+    /// samples than the declared count have been appended.
+    void finish();
+};
+
+
+/// A read-only, memory-mapped dyadic pyramid.
+class DyadicPyramid {
+    struct level {
+        std::int64_t first_block;
+        std::uint64_t block_count;
+        std::uint64_t offset;
+    };
+
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::vector<unsigned char> m_storage;
+    depth_t m_resolution;
+    std::int64_t m_first_cell;
+    std::uint64_t m_sample_count;
+    std::vector<level> m_levels;
+
+    block_summary read(const level& lvl, std::int64_t block) const noexcept;
+
+public:
+    explicit DyadicPyramid(const std::string& path);
+    ~DyadicPyramid();
+
+    DyadicPyramid(const DyadicPyramid&) = delete;
+    DyadicPyramid& operator=(const DyadicPyramid&) = delete;
+
+    depth_t resolution() const noexcept { return m_resolution; }
+    std::int64_t first_cell() const noexcept { return m_first_cell; }
+    std::uint64_t sample_count() const noexcept { return m_sample_count; }
+    std::size_t levels() const noexcept { return m_levels.size(); }
+
+    /// The summary of the samples in block, which may be at any depth.
+    block_summary summary(const dyadic_interval& block) const noexcept;
+
+    /// The summary of the samples in a probe passed to a predicate during a
+    /// search.
+    block_summary summary(const interval& probe) const noexcept
+    {
+        return summary(probe_coordinates(probe));
+    }
+
+    /// A predicate that is true on probes containing at least one sample,
+    /// all of which lie in [lower, upper]. The pyramid must outlive it.
+    predicate_t within(double lower, double upper) const;
+};
+
+} // namespace segments
+
+#endif //SEGMENTS_DYADIC_PYRAMID_H
@@ -3,6 +3,10 @@
 //
 
 #include "expanding_searcher.h"
+#include "search_tracer.h"
+
+#include <algorithm>
+#include <cmath>
 
 
 using namespace segments;
@@ -11,7 +15,7 @@ using namespace segments;
 namespace
 {
     inline void expand_left_discrete(std::vector<dyadic_interval>& result, const dyadic_interval& base,
-                                     const predicate_t& predicate, double lower_bound, depth_t trim_tol)
+                                     const probe_predicate& predicate, double lower_bound, depth_t trim_tol)
     {
         auto di = base;
         --di;
@@ -36,7 +40,7 @@ namespace
     }
 
 
-    inline void expand_right_discrete(std::vector<dyadic_interval>& result, const predicate_t& predicate,
+    inline void expand_right_discrete(std::vector<dyadic_interval>& result, const probe_predicate& predicate,
                                       double upper_bound, depth_t trim_tol)
     {
         auto di = result.back();
@@ -62,117 +66,357 @@ namespace
             }
         }
     }
+
+    inline dyadic lowest_terms(dyadic value) noexcept
+    {
+        if (value.k == 0)
+        {
+            return {0, 0};
+        }
+        while (value.k % 2 == 0)
+        {
+            value.k /= 2;
+            --value.n;
+        }
+        return value;
+    }
+
+    /*
+     * The end of a found segment is the end of a dyadic piece unless it was
+     * clipped to the bound of the component being searched. Component bounds
+     * are either the ends of earlier segments, which lie on the grid at the
+     * trim tolerance, or the ends of the base interval, which need not. A
+     * clipped end is rounded outwards to that grid, which leaves ends on it
+     * unchanged and keeps the others inside the piece.
+     */
+    inline dyadic segment_end(const dyadic& piece, double value, depth_t trim_depth, bool upper) noexcept
+    {
+        if (static_cast<double>(piece) == value)
+        {
+            return lowest_terms(piece);
+        }
+
+        const auto scaled = std::ldexp(value, trim_depth);
+        const auto k = upper ? std::ceil(scaled) : std::floor(scaled);
+        return lowest_terms({static_cast<mult_t>(k), trim_depth});
+    }
+
+    // Closes the trace events a search left open when the predicate throws.
+    struct trace_unwinder
+    {
+        SearchTracer* tracer;
+        std::size_t depth;
+
+        explicit trace_unwinder(SearchTracer* t) : tracer(t), depth(t ? t->open_events() : 0) {}
+        ~trace_unwinder()
+        {
+            if (tracer)
+            {
+                tracer->unwind(depth);
+            }
+        }
+    };
 }
 
-bool ExpandingSearcher::expand(component_iterator component, const predicate_t& predicate)
+bool ExpandingSearcher::expand(component_iterator component, const probe_predicate& predicate)
 {
+    trace_unwinder unwinder(m_tracer);
     const auto old_inf = component->inf();
     const auto old_sup = component->sup();
+    if (m_tracer)
+    {
+        m_tracer->begin("expand", {{"inf", old_inf}, {"sup", old_sup}});
+    }
+
     const auto& low_base = m_forward_expansion.front();
     if (old_inf < low_base.inf())
     {
+        if (m_tracer)
+        {
+            m_tracer->begin("expand_left");
+        }
         expand_left_discrete(m_backward_expansion, low_base, predicate, component->inf(), m_trim_tol);
+        if (m_tracer)
+        {
+            m_tracer->end("expand_left", {{"pieces", double(m_backward_expansion.size())}});
+        }
     }
     const auto& high_base = m_forward_expansion.back();
     if (high_base.sup() < old_sup)
     {
+        if (m_tracer)
+        {
+            m_tracer->begin("expand_right");
+        }
+        const auto base_pieces = m_forward_expansion.size();
         expand_right_discrete(m_forward_expansion, predicate, component->sup(), m_trim_tol);
+        if (m_tracer)
+        {
+            m_tracer->end("expand_right", {{"pieces", double(m_forward_expansion.size() - base_pieces)}});
+        }
     }
 
-    const auto new_inf = std::max(static_cast<double>(
-                                      (m_backward_expansion.empty()
-                                           ? m_forward_expansion.front().inf()
-                                           : m_backward_expansion.back().inf())), old_inf);
-    const auto new_sup = std::min(static_cast<double>(m_forward_expansion.back().sup()), old_sup);
+    const auto inf_piece = m_backward_expansion.empty()
+                               ? m_forward_expansion.front().inf()
+                               : m_backward_expansion.back().inf();
+    const auto sup_piece = m_forward_expansion.back().sup();
+    const auto new_inf = std::max(static_cast<double>(inf_piece), old_inf);
+    const auto new_sup = std::min(static_cast<double>(sup_piece), old_sup);
 
     m_forward_expansion.clear();
     m_backward_expansion.clear();
     // m_search_components.emplace_back(old_inf, new_inf);
     // m_search_components.emplace_back(new_sup, old_sup);
 
-    m_found.emplace_back(new_inf, new_sup);
-
-    if (new_sup != old_sup)
+    ++m_count;
+    m_measure += new_sup - new_inf;
+    if (m_mode == query_mode::segments || m_mode == query_mode::first)
     {
-        *component = {new_sup, old_sup};
+        m_found.emplace_back(new_inf, new_sup);
+        if (m_record_dyadic)
+        {
+            m_found_dyadic.push_back({segment_end(inf_piece, new_inf, m_trim_tol, false),
+                                      segment_end(sup_piece, new_sup, m_trim_tol, true)});
+        }
     }
-    else
+
+    if (m_tracer)
     {
-        return false;
+        m_tracer->end("expand", {{"found_inf", new_inf}, {"found_sup", new_sup}});
     }
 
+    /*
+     * The part of the component to the left of the new segment still has to
+     * be searched at finer depths, even if the segment runs to the end of the
+     * component and the component itself is exhausted.
+     */
     if (new_inf != old_inf)
     {
         m_search_components.insert(component, {old_inf, new_inf});
     }
 
+    if (new_sup == old_sup)
+    {
+        return false;
+    }
+
+    *component = {new_sup, old_sup};
     return true;
 }
 
 
-void ExpandingSearcher::search_interval(const interval& ivl, const predicate_t& predicate)
+ExpandingSearcher::scan_outcome
+ExpandingSearcher::scan_first_layer(component_iterator component, dyadic_interval from, depth_t depth,
+                                    const probe_predicate& predicate)
+{
+    m_forward_expansion.clear();
+    m_backward_expansion.clear();
+
+    dyadic_interval end(component->sup(), depth);
+    for (auto di = from; di < end; ++di)
+    {
+        if (predicate(di))
+        {
+            if (m_mode == query_mode::any)
+            {
+                m_count = 1;
+                return scan_outcome::stopped;
+            }
+            m_forward_expansion.push_back(di);
+        }
+        else if (!m_forward_expansion.empty())
+        {
+            return expand(component, predicate) ? scan_outcome::found : scan_outcome::exhausted;
+        }
+    }
+    if (!m_forward_expansion.empty())
+    {
+        return expand(component, predicate) ? scan_outcome::found : scan_outcome::exhausted;
+    }
+    return scan_outcome::finished;
+}
+
+ExpandingSearcher::scan_outcome
+ExpandingSearcher::scan_layer(component_iterator component, dyadic_interval from, depth_t depth,
+                              const probe_predicate& predicate)
+{
+    dyadic_interval end(component->sup(), depth);
+    for (auto di = from; di < end; ++di)
+    {
+        if (predicate(di))
+        {
+            if (m_mode == query_mode::any)
+            {
+                m_count = 1;
+                return scan_outcome::stopped;
+            }
+            m_forward_expansion.push_back(di);
+            return expand(component, predicate) ? scan_outcome::found : scan_outcome::exhausted;
+        }
+    }
+    return scan_outcome::finished;
+}
+
+dyadic_interval ExpandingSearcher::resume_point(const interval& component, depth_t depth) noexcept
+{
+    dyadic_interval di(component.inf(), depth);
+    return ++di;
+}
+
+depth_t ExpandingSearcher::coarsest_fitting_depth(const interval& ivl) noexcept
+{
+    depth_t expo;
+    std::frexp(ivl.sup() - ivl.inf(), &expo);
+    return 1 - expo;
+}
+
+depth_t ExpandingSearcher::start_depth(const interval& ivl) const noexcept
+{
+    auto depth = (m_start_depth == adaptive_start_depth) ? coarsest_fitting_depth(ivl) : m_start_depth;
+    return std::min(depth, m_signal_tol);
+}
+
+void ExpandingSearcher::search_interval(const interval& ivl, const predicate_t& user_predicate)
 {
+    if (m_tracer)
+    {
+        const auto traced_predicate = m_tracer->trace_predicate(user_predicate);
+        search(ivl, traced_predicate);
+    }
+    else
+    {
+        search(ivl, user_predicate);
+    }
+}
+
+void ExpandingSearcher::search_interval(const interval& ivl, const dyadic_predicate_t& user_predicate)
+{
+    if (m_tracer)
+    {
+        // The tracer records intervals, so a traced search converts probes.
+        const predicate_t as_interval = [&user_predicate](const interval& probe) {
+            const auto di = probe_coordinates(probe);
+            return user_predicate(di.k, di.n);
+        };
+        const auto traced_predicate = m_tracer->trace_predicate(as_interval);
+        search(ivl, traced_predicate);
+    }
+    else
+    {
+        search(ivl, user_predicate);
+    }
+}
+
+void ExpandingSearcher::search(const interval& ivl, const probe_predicate& predicate)
+{
+    trace_unwinder unwinder(m_tracer);
+    if (m_tracer)
+    {
+        m_tracer->begin("search", {
+                {"inf", ivl.inf()},
+                {"sup", ivl.sup()},
+                {"signal_tolerance", double(m_signal_tol)},
+                {"trim_tolerance", double(m_trim_tol)}
+        });
+    }
+
     m_found.clear();
+    m_found_dyadic.clear();
+    m_found_by_depth.clear();
+    m_count = 0;
+    m_measure = 0.0;
     m_search_components.clear();
     m_search_components.push_back(ivl);
 
-    dyadic_interval di_it(ivl.inf(), 0);
-    dyadic_interval di_end(ivl.sup(), 0);
+    const auto first_depth = start_depth(ivl);
 
     {
         /*
          * The first layer needs special attention since it is possible for there
          * to be multiple adjacent dyadic intervals for which the predicate is true.
          */
-        m_forward_expansion.clear();
-        m_backward_expansion.clear();
+        if (m_tracer)
+        {
+            m_tracer->begin("depth", {{"depth", double(first_depth)}, {"components", 1.0}});
+        }
         auto component = m_search_components.begin();
-        for (; di_it < di_end; ++di_it)
+        dyadic_interval from(ivl.inf(), first_depth);
+        for (;;)
         {
-            if (predicate(di_it))
+            auto outcome = scan_first_layer(component, from, first_depth, predicate);
+            if (outcome == scan_outcome::stopped)
             {
-                m_forward_expansion.push_back(di_it);
+                m_search_components.clear();
+                break;
             }
-            else if (!m_forward_expansion.empty())
+            if (outcome == scan_outcome::exhausted
+                || (outcome == scan_outcome::found && m_mode == query_mode::first))
             {
-                if (!expand(component, predicate))
-                {
-                    component = m_search_components.erase(component);
-                    break;
-                }
-                di_it = dyadic_interval(component->inf(), 0);
+                // Only the part left of the first segment matters to a first
+                // search.
+                m_search_components.erase(component);
             }
-        }
-        if (!m_forward_expansion.empty())
-        {
-            if (!expand(component, predicate))
+            if (outcome != scan_outcome::found || m_mode == query_mode::first)
             {
-                component = m_search_components.erase(component);
+                break;
             }
+            from = resume_point(*component, first_depth);
+        }
+        m_found_by_depth.push_back(m_count);
+        if (m_tracer)
+        {
+            m_tracer->end("depth", {{"found", double(m_count)}});
         }
     }
 
-    for (depth_t current_depth = 1; current_depth <= m_signal_tol && !m_search_components.empty(); ++current_depth)
+    for (depth_t current_depth = first_depth + 1; current_depth <= m_signal_tol && !m_search_components.empty(); ++current_depth)
     {
-        for (auto component = m_search_components.begin(); component != m_search_components.end(); ++component)
+        if (m_tracer)
+        {
+            m_tracer->begin("depth", {
+                    {"depth", double(current_depth)},
+                    {"components", double(m_search_components.size())}
+            });
+        }
+        for (auto component = m_search_components.begin(); component != m_search_components.end();)
         {
-            di_it = dyadic_interval(component->inf(), current_depth);
-            di_end = dyadic_interval(component->sup(), current_depth);
+            dyadic_interval from(component->inf(), current_depth);
+            auto outcome = scan_layer(component, from, current_depth, predicate);
+            if (outcome == scan_outcome::stopped)
+            {
+                m_search_components.clear();
+                break;
+            }
+            if (outcome != scan_outcome::finished && m_mode == query_mode::first)
+            {
+                // The segment is left of any found before, and the components
+                // to the right of it no longer matter.
+                m_search_components.erase(component, m_search_components.end());
+                break;
+            }
+            while (outcome == scan_outcome::found)
+            {
+                outcome = scan_layer(component, resume_point(*component, current_depth), current_depth, predicate);
+            }
 
-            for (; di_it < di_end; ++di_it)
+            if (outcome == scan_outcome::exhausted)
+            {
+                component = m_search_components.erase(component);
+            }
+            else
             {
-                if (predicate(di_it))
-                {
-                    m_forward_expansion.push_back(di_it);
-                    if (!expand(component, predicate))
-                    {
-                        component = m_search_components.erase(component);
-                        break;
-                    }
-
-                    di_it = dyadic_interval(component->inf(), current_depth)--;
-                }
+                ++component;
             }
         }
+        m_found_by_depth.push_back(m_count);
+        if (m_tracer)
+        {
+            m_tracer->end("depth", {{"found", double(m_count)}});
+        }
+    }
+
+    if (m_tracer)
+    {
+        m_tracer->end("search", {{"found", double(m_count)}});
     }
 }
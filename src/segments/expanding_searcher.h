@@ -12,34 +12,130 @@
 
 namespace segments {
 
+class SearchTracer;
+
+/// The predicate of a search, called with each probe as a dyadic interval.
+/// This is a view of a predicate_t or dyadic_predicate_t owned by the
+/// caller; a dyadic predicate is called with the coordinates of the probe,
+/// which is never converted to an interval.
+class probe_predicate {
+    const predicate_t* m_interval = nullptr;
+    const dyadic_predicate_t* m_dyadic = nullptr;
+
+public:
+    probe_predicate(const predicate_t& predicate) noexcept : m_interval(&predicate) {}
+    probe_predicate(const dyadic_predicate_t& predicate) noexcept : m_dyadic(&predicate) {}
+
+    bool operator()(const dyadic_interval& probe) const
+    {
+        return m_dyadic != nullptr ? (*m_dyadic)(probe.k, probe.n) : (*m_interval)(interval(probe));
+    }
+};
+
+/// What a search computes. A segments search finds every segment. The
+/// other modes answer a single question and stop searching as soon as the
+/// answer is known: an any search stops at the first probe that starts a
+/// segment, without expanding it, and a first search only searches further
+/// to the left of the leftmost segment found so far. Count and measure
+/// searches find every segment but keep only the totals.
+enum class query_mode {
+    segments,
+    any,
+    first,
+    count,
+    measure
+};
+
 class ExpandingSearcher {
 public:
     std::list<interval> m_search_components;
     std::vector<interval> m_found;
+    std::vector<dyadic_segment> m_found_dyadic;
+    /// The number of segments found by the end of each depth pass, starting
+    /// with the first depth of the search.
+    std::vector<std::size_t> m_found_by_depth;
+    /// The number of segments found and their total length, kept in every
+    /// mode. An any search that finds a segment stops with a count of 1 and
+    /// no length.
+    std::size_t m_count = 0;
+    double m_measure = 0.0;
     std::vector<dyadic_interval> m_forward_expansion;
     std::vector<dyadic_interval> m_backward_expansion;
     depth_t m_trim_tol;
     depth_t m_signal_tol;
+    depth_t m_start_depth;
+    SearchTracer* m_tracer = nullptr;
+    query_mode m_mode = query_mode::segments;
+    /// Whether to record the exact dyadic endpoints of each segment found
+    /// in m_found_dyadic, as segment_dyadic does.
+    bool m_record_dyadic = false;
 
     using component_iterator = typename std::list<interval>::iterator;
 
-    ExpandingSearcher(depth_t trim_tol, depth_t signal_tol)
+    /// How a scan of a component at a single depth ended: either it reached
+    /// the end of the component, or it found a segment and the component now
+    /// holds the part to the right of it, or it found a segment that runs to
+    /// the end of the component and the component should be removed, or it
+    /// found the start of a segment in an any search, which is then over.
+    enum class scan_outcome {
+        finished,
+        found,
+        exhausted,
+        stopped
+    };
+
+    ExpandingSearcher(depth_t trim_tol, depth_t signal_tol, depth_t start_depth = 0)
         : m_trim_tol(trim_tol),
-          m_signal_tol(signal_tol)
+          m_signal_tol(signal_tol),
+          m_start_depth(start_depth)
     {
         m_forward_expansion.reserve(10);
         m_backward_expansion.reserve(10);
     }
 
+    /// The coarsest depth at which a dyadic interval is no longer than ivl.
+    static depth_t coarsest_fitting_depth(const interval& ivl) noexcept;
+
+    /// The depth at which the search of ivl begins, never finer than the
+    /// signal tolerance.
+    depth_t start_depth(const interval& ivl) const noexcept;
+
+
+
+    bool expand(component_iterator component, const probe_predicate& predicate);
 
+    /// Scan component at the first depth of the search, starting from the
+    /// dyadic interval from, until a run of adjacent intervals on which the
+    /// predicate holds has been expanded into a segment.
+    scan_outcome scan_first_layer(component_iterator component, dyadic_interval from, depth_t depth,
+                                  const probe_predicate& predicate);
 
-    bool expand(component_iterator component, const predicate_t& predicate);
+    /// Scan component at a later depth, starting from the dyadic interval
+    /// from, until the first segment is found.
+    scan_outcome scan_layer(component_iterator component, dyadic_interval from, depth_t depth,
+                            const probe_predicate& predicate);
 
+    /// The dyadic interval from which the scan of component continues after
+    /// a segment has been found.
+    static dyadic_interval resume_point(const interval& component, depth_t depth) noexcept;
 
-    void search_interval(const interval& ivl, const predicate_t& predicate);
+
+    void search_interval(const interval& ivl, const predicate_t& user_predicate);
+    void search_interval(const interval& ivl, const dyadic_predicate_t& user_predicate);
+
+private:
+    void search(const interval& ivl, const probe_predicate& predicate);
+
+public:
 
 
     std::vector<interval> result() && noexcept { return std::move(m_found); }
+    std::vector<dyadic_segment> dyadic_result() && noexcept { return std::move(m_found_dyadic); }
+
+    /// The answer of a first search that found a segment. Each segment found
+    /// by a first search lies to the left of those found before it, so this
+    /// is the last one found.
+    const interval& first_found() const noexcept { return m_found.back(); }
 };
 
 } // segments
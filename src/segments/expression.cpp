@@ -0,0 +1,761 @@
+#include "expression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+
+using namespace segments;
+
+
+namespace
+{
+    constexpr std::size_t max_stack_depth = 64;
+    constexpr std::size_t max_nesting_depth = 256;
+    constexpr double not_a_number = std::numeric_limits<double>::quiet_NaN();
+
+    /*
+     * The values of a sample array with prefix sums for sum and mean and
+     * sparse tables for min and max, so every aggregate over a range of
+     * samples takes constant time after a binary search for the range.
+     */
+    struct sample_array
+    {
+        std::vector<double> positions;
+        std::vector<double> prefix;
+        std::vector<std::vector<double>> min_table;
+        std::vector<std::vector<double>> max_table;
+
+        sample_array(std::vector<double> pos, const std::vector<double>& values)
+            : positions(std::move(pos))
+        {
+            if (positions.size() != values.size())
+            {
+                throw std::invalid_argument("sample positions and values must have the same length");
+            }
+            if (!std::is_sorted(positions.begin(), positions.end()))
+            {
+                throw std::invalid_argument("sample positions must be sorted");
+            }
+
+            prefix.resize(values.size() + 1, 0.0);
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                prefix[i + 1] = prefix[i] + values[i];
+            }
+
+            min_table.push_back(values);
+            max_table.push_back(values);
+            for (std::size_t width = 1; 2 * width <= values.size(); width *= 2)
+            {
+                const auto& lower_min = min_table.back();
+                const auto& lower_max = max_table.back();
+                std::vector<double> next_min(lower_min.size() - width), next_max(lower_max.size() - width);
+                for (std::size_t i = 0; i < next_min.size(); ++i)
+                {
+                    next_min[i] = std::min(lower_min[i], lower_min[i + width]);
+                    next_max[i] = std::max(lower_max[i], lower_max[i + width]);
+                }
+                min_table.push_back(std::move(next_min));
+                max_table.push_back(std::move(next_max));
+            }
+        }
+
+        std::pair<std::size_t, std::size_t> range(double inf, double sup) const noexcept
+        {
+            auto lo = std::lower_bound(positions.begin(), positions.end(), inf);
+            auto hi = std::lower_bound(lo, positions.end(), sup);
+            return {static_cast<std::size_t>(lo - positions.begin()), static_cast<std::size_t>(hi - positions.begin())};
+        }
+
+        template <typename Table, typename Combine>
+        static double query(const Table& table, std::size_t lo, std::size_t hi, Combine combine) noexcept
+        {
+            if (lo >= hi)
+            {
+                return not_a_number;
+            }
+            std::size_t level = 0;
+            while ((std::size_t(2) << level) <= hi - lo)
+            {
+                ++level;
+            }
+            return combine(table[level][lo], table[level][hi - (std::size_t(1) << level)]);
+        }
+    };
+
+    enum class opcode : std::uint8_t
+    {
+        constant, slot, inf, sup, length,
+        neg, abs, add, sub, mul, div,
+        lt, le, gt, ge, eq, ne, logical_not,
+        agg_min, agg_max, agg_mean, agg_sum, agg_count,
+        jump_if_false, jump_if_true
+    };
+
+    struct instruction
+    {
+        opcode op;
+        std::uint32_t arg;
+        double value;
+    };
+
+    enum class slot_use : std::uint8_t
+    {
+        none = 0,
+        value = 1,
+        array = 2
+    };
+}
+
+
+struct Expression::program
+{
+    std::vector<instruction> code;
+    std::vector<std::string> names;
+    std::vector<std::uint8_t> uses;
+    std::vector<double> constants;
+    std::vector<std::shared_ptr<const sample_array>> arrays;
+    std::vector<bool> bound;
+
+    std::uint32_t slot(const std::string& name)
+    {
+        auto found = std::find(names.begin(), names.end(), name);
+        if (found != names.end())
+        {
+            return static_cast<std::uint32_t>(found - names.begin());
+        }
+        names.push_back(name);
+        uses.push_back(0);
+        constants.push_back(not_a_number);
+        arrays.emplace_back();
+        bound.push_back(false);
+        return static_cast<std::uint32_t>(names.size() - 1);
+    }
+
+    void check() const
+    {
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            if (!bound[i])
+            {
+                throw std::logic_error("name '" + names[i] + "' in expression is not bound");
+            }
+            if ((uses[i] & static_cast<std::uint8_t>(slot_use::value)) && arrays[i])
+            {
+                throw std::logic_error("sample array '" + names[i] + "' can only be used in an aggregate");
+            }
+            if ((uses[i] & static_cast<std::uint8_t>(slot_use::array)) && !arrays[i])
+            {
+                throw std::logic_error("aggregate of '" + names[i] + "', which is not a sample array");
+            }
+        }
+    }
+
+    bool run(double inf, double sup) const
+    {
+        double stack[max_stack_depth];
+        std::size_t top = 0;
+
+        const auto size = code.size();
+        for (std::size_t pc = 0; pc < size; ++pc)
+        {
+            const auto& ins = code[pc];
+            switch (ins.op)
+            {
+                case opcode::constant: stack[top++] = ins.value; break;
+                case opcode::slot: stack[top++] = constants[ins.arg]; break;
+                case opcode::inf: stack[top++] = inf; break;
+                case opcode::sup: stack[top++] = sup; break;
+                case opcode::length: stack[top++] = sup - inf; break;
+                case opcode::neg: stack[top - 1] = -stack[top - 1]; break;
+                case opcode::abs: stack[top - 1] = std::abs(stack[top - 1]); break;
+                case opcode::logical_not: stack[top - 1] = stack[top - 1] == 0.0 ? 1.0 : 0.0; break;
+                case opcode::add: --top; stack[top - 1] += stack[top]; break;
+                case opcode::sub: --top; stack[top - 1] -= stack[top]; break;
+                case opcode::mul: --top; stack[top - 1] *= stack[top]; break;
+                case opcode::div: --top; stack[top - 1] /= stack[top]; break;
+                case opcode::lt: --top; stack[top - 1] = stack[top - 1] < stack[top]; break;
+                case opcode::le: --top; stack[top - 1] = stack[top - 1] <= stack[top]; break;
+                case opcode::gt: --top; stack[top - 1] = stack[top - 1] > stack[top]; break;
+                case opcode::ge: --top; stack[top - 1] = stack[top - 1] >= stack[top]; break;
+                case opcode::eq: --top; stack[top - 1] = stack[top - 1] == stack[top]; break;
+                case opcode::ne: --top; stack[top - 1] = stack[top - 1] != stack[top]; break;
+                case opcode::agg_min:
+                case opcode::agg_max:
+                case opcode::agg_mean:
+                case opcode::agg_sum:
+                case opcode::agg_count:
+                {
+                    const auto& samples = *arrays[ins.arg];
+                    const auto range = samples.range(inf, sup);
+                    const auto count = static_cast<double>(range.second - range.first);
+                    const auto sum = samples.prefix[range.second] - samples.prefix[range.first];
+                    double value;
+                    switch (ins.op)
+                    {
+                        case opcode::agg_min:
+                            value = sample_array::query(samples.min_table, range.first, range.second,
+                                                        [](double a, double b) { return std::min(a, b); });
+                            break;
+                        case opcode::agg_max:
+                            value = sample_array::query(samples.max_table, range.first, range.second,
+                                                        [](double a, double b) { return std::max(a, b); });
+                            break;
+                        case opcode::agg_mean: value = count == 0.0 ? not_a_number : sum / count; break;
+                        case opcode::agg_sum: value = sum; break;
+                        default: value = count; break;
+                    }
+                    stack[top++] = value;
+                    break;
+                }
+                case opcode::jump_if_false:
+                    if (stack[top - 1] == 0.0)
+                    {
+                        pc = ins.arg - 1;
+                    }
+                    else
+                    {
+                        --top;
+                    }
+                    break;
+                case opcode::jump_if_true:
+                    if (stack[top - 1] != 0.0)
+                    {
+                        pc = ins.arg - 1;
+                    }
+                    else
+                    {
+                        --top;
+                    }
+                    break;
+            }
+        }
+        return stack[0] != 0.0;
+    }
+};
+
+
+namespace
+{
+    struct node
+    {
+        opcode op;
+        double value = 0.0;
+        std::uint32_t slot = 0;
+        std::vector<opcode> comparisons;
+        std::vector<std::unique_ptr<node>> children;
+        enum { leaf, unary, binary, chain, conjunction, disjunction } shape = leaf;
+        std::size_t height = 1;
+    };
+    using node_ptr = std::unique_ptr<node>;
+
+    node_ptr make_leaf(opcode op, double value = 0.0, std::uint32_t slot = 0)
+    {
+        auto result = std::make_unique<node>();
+        result->op = op;
+        result->value = value;
+        result->slot = slot;
+        return result;
+    }
+
+    /*
+     * A recursive descent parser producing a tree, which is then compiled to
+     * the flat instruction list. Names are assigned slots as they are met.
+     * Both the parser and the compiler recurse, so the depth of the parser's
+     * recursion and the height of the tree are limited to keep the stack
+     * from overflowing on deeply nested input.
+     */
+    class Parser
+    {
+        const std::string& m_source;
+        Expression::program& m_program;
+        std::size_t m_pos = 0;
+        std::size_t m_nesting = 0;
+
+        class nesting_guard
+        {
+            Parser& m_parser;
+
+        public:
+            explicit nesting_guard(Parser& parser) : m_parser(parser)
+            {
+                if (++m_parser.m_nesting > max_nesting_depth)
+                {
+                    m_parser.fail("expression is too deeply nested");
+                }
+            }
+
+            ~nesting_guard() { --m_parser.m_nesting; }
+
+            nesting_guard(const nesting_guard&) = delete;
+            nesting_guard& operator=(const nesting_guard&) = delete;
+        };
+
+        [[noreturn]] void fail(const std::string& message) const
+        {
+            throw std::invalid_argument(message + " at position " + std::to_string(m_pos) + " in expression '"
+                                        + m_source + "'");
+        }
+
+        void skip_space() noexcept
+        {
+            while (m_pos < m_source.size() && std::isspace(static_cast<unsigned char>(m_source[m_pos])))
+            {
+                ++m_pos;
+            }
+        }
+
+        bool at_end() noexcept
+        {
+            skip_space();
+            return m_pos == m_source.size();
+        }
+
+        bool accept(const char* token)
+        {
+            skip_space();
+            const auto length = std::char_traits<char>::length(token);
+            if (m_source.compare(m_pos, length, token) != 0)
+            {
+                return false;
+            }
+            // Keywords must not run into a following name.
+            if (std::isalpha(static_cast<unsigned char>(token[0])) && m_pos + length < m_source.size())
+            {
+                const auto next = static_cast<unsigned char>(m_source[m_pos + length]);
+                if (std::isalnum(next) || next == '_')
+                {
+                    return false;
+                }
+            }
+            m_pos += length;
+            return true;
+        }
+
+        void expect(const char* token)
+        {
+            if (!accept(token))
+            {
+                fail(std::string("expected '") + token + "'");
+            }
+        }
+
+        std::string name()
+        {
+            skip_space();
+            const auto start = m_pos;
+            if (m_pos < m_source.size()
+                && (std::isalpha(static_cast<unsigned char>(m_source[m_pos])) || m_source[m_pos] == '_'))
+            {
+                while (m_pos < m_source.size()
+                       && (std::isalnum(static_cast<unsigned char>(m_source[m_pos])) || m_source[m_pos] == '_'))
+                {
+                    ++m_pos;
+                }
+            }
+            return m_source.substr(start, m_pos - start);
+        }
+
+        void attach(node& parent, node_ptr child)
+        {
+            parent.height = std::max(parent.height, child->height + 1);
+            if (parent.height > max_nesting_depth)
+            {
+                fail("expression is too deeply nested");
+            }
+            parent.children.push_back(std::move(child));
+        }
+
+        node_ptr primary()
+        {
+            skip_space();
+            if (m_pos == m_source.size())
+            {
+                fail("unexpected end of expression");
+            }
+
+            if (accept("("))
+            {
+                auto inner = expression();
+                expect(")");
+                return inner;
+            }
+
+            const char c = m_source[m_pos];
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+            {
+                const char* begin = m_source.c_str() + m_pos;
+                char* end = nullptr;
+                const double value = std::strtod(begin, &end);
+                if (end == begin)
+                {
+                    fail("malformed number");
+                }
+                m_pos += static_cast<std::size_t>(end - begin);
+                return make_leaf(opcode::constant, value);
+            }
+
+            const auto start = m_pos;
+            const auto word = name();
+            if (word.empty())
+            {
+                fail(std::string("unexpected '") + c + "'");
+            }
+            if (word == "and" || word == "or" || word == "not")
+            {
+                m_pos = start;
+                fail("unexpected '" + word + "'");
+            }
+
+            static const std::pair<const char*, opcode> aggregates[] = {
+                    {"min", opcode::agg_min}, {"max", opcode::agg_max}, {"mean", opcode::agg_mean},
+                    {"sum", opcode::agg_sum}, {"count", opcode::agg_count}
+            };
+            for (const auto& aggregate : aggregates)
+            {
+                if (word == aggregate.first && accept("("))
+                {
+                    const auto array = name();
+                    if (array.empty())
+                    {
+                        fail(std::string("expected the name of a sample array in ") + aggregate.first);
+                    }
+                    expect(")");
+                    const auto slot = m_program.slot(array);
+                    m_program.uses[slot] |= static_cast<std::uint8_t>(slot_use::array);
+                    return make_leaf(aggregate.second, 0.0, slot);
+                }
+            }
+            if (word == "abs" && accept("("))
+            {
+                auto result = make_leaf(opcode::abs);
+                result->shape = node::unary;
+                attach(*result, expression());
+                expect(")");
+                return result;
+            }
+
+            if (word == "inf")
+            {
+                return make_leaf(opcode::inf);
+            }
+            if (word == "sup")
+            {
+                return make_leaf(opcode::sup);
+            }
+            if (word == "length")
+            {
+                return make_leaf(opcode::length);
+            }
+
+            const auto slot = m_program.slot(word);
+            m_program.uses[slot] |= static_cast<std::uint8_t>(slot_use::value);
+            return make_leaf(opcode::slot, 0.0, slot);
+        }
+
+        node_ptr factor()
+        {
+            nesting_guard guard(*this);
+            if (accept("-"))
+            {
+                auto result = make_leaf(opcode::neg);
+                result->shape = node::unary;
+                attach(*result, factor());
+                return result;
+            }
+            return primary();
+        }
+
+        template <typename Next>
+        node_ptr binary(Next next, std::initializer_list<std::pair<const char*, opcode>> operators)
+        {
+            auto lhs = (this->*next)();
+            for (;;)
+            {
+                const std::pair<const char*, opcode>* matched = nullptr;
+                for (const auto& op : operators)
+                {
+                    if (accept(op.first))
+                    {
+                        matched = &op;
+                        break;
+                    }
+                }
+                if (matched == nullptr)
+                {
+                    return lhs;
+                }
+
+                auto result = make_leaf(matched->second);
+                result->shape = node::binary;
+                attach(*result, std::move(lhs));
+                attach(*result, (this->*next)());
+                lhs = std::move(result);
+            }
+        }
+
+        node_ptr term()
+        {
+            return binary(&Parser::factor, {{"*", opcode::mul}, {"/", opcode::div}});
+        }
+
+        node_ptr sum()
+        {
+            return binary(&Parser::term, {{"+", opcode::add}, {"-", opcode::sub}});
+        }
+
+        node_ptr comparison()
+        {
+            // Two character operators are tried before their prefixes.
+            static const std::pair<const char*, opcode> operators[] = {
+                    {"<=", opcode::le}, {">=", opcode::ge}, {"==", opcode::eq}, {"!=", opcode::ne},
+                    {"<", opcode::lt}, {">", opcode::gt}
+            };
+
+            auto first = sum();
+            node_ptr result;
+            for (;;)
+            {
+                const std::pair<const char*, opcode>* matched = nullptr;
+                for (const auto& op : operators)
+                {
+                    if (accept(op.first))
+                    {
+                        matched = &op;
+                        break;
+                    }
+                }
+                if (matched == nullptr)
+                {
+                    break;
+                }
+                if (!result)
+                {
+                    result = make_leaf(matched->second);
+                    result->shape = node::chain;
+                    attach(*result, std::move(first));
+                }
+                result->comparisons.push_back(matched->second);
+                attach(*result, sum());
+            }
+            return result ? std::move(result) : std::move(first);
+        }
+
+        node_ptr negation()
+        {
+            nesting_guard guard(*this);
+            if (accept("not"))
+            {
+                auto result = make_leaf(opcode::logical_not);
+                result->shape = node::unary;
+                attach(*result, negation());
+                return result;
+            }
+            return comparison();
+        }
+
+        template <typename Next>
+        node_ptr logical(Next next, const char* keyword, decltype(node::shape) shape)
+        {
+            auto first = (this->*next)();
+            if (!accept(keyword))
+            {
+                return first;
+            }
+            auto result = make_leaf(opcode::constant);
+            result->shape = shape;
+            attach(*result, std::move(first));
+            do
+            {
+                attach(*result, (this->*next)());
+            } while (accept(keyword));
+            return result;
+        }
+
+        node_ptr conjunction()
+        {
+            return logical(&Parser::negation, "and", node::conjunction);
+        }
+
+        node_ptr expression()
+        {
+            return logical(&Parser::conjunction, "or", node::disjunction);
+        }
+
+    public:
+        Parser(const std::string& source, Expression::program& program)
+            : m_source(source), m_program(program)
+        {}
+
+        node_ptr parse()
+        {
+            auto result = expression();
+            if (!at_end())
+            {
+                fail("unexpected '" + std::string(1, m_source[m_pos]) + "'");
+            }
+            return result;
+        }
+    };
+
+
+    class Compiler
+    {
+        std::vector<instruction>& m_code;
+        std::size_t m_depth = 0;
+
+        void emit(opcode op, std::int32_t stack_change, std::uint32_t arg = 0, double value = 0.0)
+        {
+            m_code.push_back({op, arg, value});
+            m_depth = static_cast<std::size_t>(static_cast<std::int64_t>(m_depth) + stack_change);
+            if (m_depth > max_stack_depth)
+            {
+                throw std::invalid_argument("expression is too deeply nested");
+            }
+        }
+
+        void patch(std::size_t jump) noexcept
+        {
+            m_code[jump].arg = static_cast<std::uint32_t>(m_code.size());
+        }
+
+        /*
+         * A chain of several operands and jumps evaluates each operand in
+         * turn, leaving the deciding value on the stack. The jump pops the
+         * value when it does not jump, so only one value remains either way.
+         */
+        template <typename Operand>
+        void short_circuit(std::size_t count, opcode jump, Operand operand)
+        {
+            std::vector<std::size_t> jumps;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                operand(i);
+                if (i + 1 < count)
+                {
+                    jumps.push_back(m_code.size());
+                    emit(jump, -1);
+                }
+            }
+            for (auto pos : jumps)
+            {
+                patch(pos);
+            }
+        }
+
+    public:
+        explicit Compiler(std::vector<instruction>& code) : m_code(code) {}
+
+        void compile(const node& n)
+        {
+            switch (n.shape)
+            {
+                case node::leaf:
+                    emit(n.op, 1, n.slot, n.value);
+                    break;
+                case node::unary:
+                    compile(*n.children[0]);
+                    emit(n.op, 0);
+                    break;
+                case node::binary:
+                    compile(*n.children[0]);
+                    compile(*n.children[1]);
+                    emit(n.op, -1);
+                    break;
+                case node::chain:
+                    // a < b < c is compiled as (a < b) and (b < c).
+                    short_circuit(n.comparisons.size(), opcode::jump_if_false, [&](std::size_t i) {
+                        compile(*n.children[i]);
+                        compile(*n.children[i + 1]);
+                        emit(n.comparisons[i], -1);
+                    });
+                    break;
+                case node::conjunction:
+                    short_circuit(n.children.size(), opcode::jump_if_false, [&](std::size_t i) {
+                        compile(*n.children[i]);
+                    });
+                    break;
+                case node::disjunction:
+                    short_circuit(n.children.size(), opcode::jump_if_true, [&](std::size_t i) {
+                        compile(*n.children[i]);
+                    });
+                    break;
+            }
+        }
+    };
+}
+
+
+Expression::Expression(std::string source)
+    : m_source(std::move(source)), m_program(std::make_shared<program>())
+{
+    auto tree = Parser(m_source, *m_program).parse();
+    Compiler(m_program->code).compile(*tree);
+}
+
+Expression::~Expression() = default;
+
+Expression::Expression(const Expression& other)
+    : m_source(other.m_source), m_program(std::make_shared<program>(*other.m_program))
+{}
+
+Expression& Expression::operator=(const Expression& other)
+{
+    if (this != &other)
+    {
+        m_source = other.m_source;
+        m_program = std::make_shared<program>(*other.m_program);
+    }
+    return *this;
+}
+
+Expression::Expression(Expression&&) noexcept = default;
+Expression& Expression::operator=(Expression&&) noexcept = default;
+
+std::vector<std::string> Expression::names() const
+{
+    return m_program->names;
+}
+
+void Expression::bind(const std::string& name, double value)
+{
+    auto found = std::find(m_program->names.begin(), m_program->names.end(), name);
+    if (found == m_program->names.end())
+    {
+        throw std::invalid_argument("name '" + name + "' does not appear in expression '" + m_source + "'");
+    }
+    const auto slot = static_cast<std::size_t>(found - m_program->names.begin());
+    m_program->constants[slot] = value;
+    m_program->arrays[slot].reset();
+    m_program->bound[slot] = true;
+}
+
+void Expression::bind(const std::string& name, std::vector<double> positions, std::vector<double> values)
+{
+    auto found = std::find(m_program->names.begin(), m_program->names.end(), name);
+    if (found == m_program->names.end())
+    {
+        throw std::invalid_argument("name '" + name + "' does not appear in expression '" + m_source + "'");
+    }
+    const auto slot = static_cast<std::size_t>(found - m_program->names.begin());
+    m_program->arrays[slot] = std::make_shared<const sample_array>(std::move(positions), values);
+    m_program->bound[slot] = true;
+}
+
+bool Expression::operator()(const interval& arg) const
+{
+    m_program->check();
+    return m_program->run(arg.inf(), arg.sup());
+}
+
+predicate_t Expression::predicate() const
+{
+    m_program->check();
+    std::shared_ptr<const program> snapshot = std::make_shared<program>(*m_program);
+    return [snapshot](const interval& arg) { return snapshot->run(arg.inf(), arg.sup()); };
+}
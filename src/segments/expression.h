@@ -0,0 +1,76 @@
+#ifndef SEGMENTS_EXPRESSION_H
+#define SEGMENTS_EXPRESSION_H
+
+#include "segments.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace segments {
+
+/*
+ * A predicate written as a small expression over the probe [inf, sup),
+ * parsed once and evaluated by a stack machine without any callbacks.
+ *
+ * The grammar follows Python:
+ *
+ *     expr       := or_expr
+ *     or_expr    := and_expr ('or' and_expr)*
+ *     and_expr   := not_expr ('and' not_expr)*
+ *     not_expr   := 'not' not_expr | comparison
+ *     comparison := sum (('<' | '<=' | '>' | '>=' | '==' | '!=') sum)*
+ *     sum        := term (('+' | '-') term)*
+ *     term       := factor (('*' | '/') factor)*
+ *     factor     := '-' factor | primary
+ *     primary    := number | name | '(' expr ')'
+ *                 | 'abs' '(' expr ')'
+ *                 | ('min' | 'max' | 'mean' | 'sum' | 'count') '(' name ')'
+ *
+ * The names inf, sup and length refer to the probe. Other names must be
+ * bound before the expression is evaluated, either to a constant or to a
+ * sample array of values at sorted positions. An aggregate over a sample
+ * array covers the samples whose positions lie in [inf, sup); the min, max
+ * and mean of an empty range are NaN, so comparisons with them are false.
+ * Comparisons chain as in Python, and and/or short-circuit.
+ */
+class Expression {
+public:
+    struct program;
+
+private:
+    std::string m_source;
+    std::shared_ptr<program> m_program;
+
+public:
+    /// Parse source, throwing std::invalid_argument on a syntax error.
+    explicit Expression(std::string source);
+    ~Expression();
+
+    Expression(const Expression&);
+    Expression& operator=(const Expression&);
+    Expression(Expression&&) noexcept;
+    Expression& operator=(Expression&&) noexcept;
+
+    const std::string& source() const noexcept { return m_source; }
+
+    /// The names, other than inf, sup and length, used by the expression.
+    std::vector<std::string> names() const;
+
+    void bind(const std::string& name, double value);
+    void bind(const std::string& name, std::vector<double> positions, std::vector<double> values);
+
+    /// Evaluate the expression on arg. Throws std::logic_error if a name
+    /// has not been bound.
+    bool operator()(const interval& arg) const;
+
+    /// A predicate evaluating a snapshot of this expression, which is
+    /// unaffected by later calls to bind. Throws std::logic_error if a name
+    /// has not been bound.
+    predicate_t predicate() const;
+};
+
+} // namespace segments
+
+#endif //SEGMENTS_EXPRESSION_H
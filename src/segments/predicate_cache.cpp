@@ -0,0 +1,135 @@
+#include "predicate_cache.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+
+using namespace segments;
+
+
+namespace
+{
+    inline std::uint64_t probe_key(mult_t k, depth_t n) noexcept
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(k)) << 32)
+               | static_cast<std::uint32_t>(n);
+    }
+}
+
+
+PredicateCache::PredicateCache(std::size_t capacity, eviction_policy policy)
+    : m_capacity(capacity), m_policy(policy)
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("predicate cache capacity must be positive");
+    }
+    m_index.reserve(capacity);
+}
+
+std::optional<bool> PredicateCache::lookup(const dyadic_interval& probe)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    auto found = m_index.find(probe_key(probe.k, probe.n));
+    if (found == m_index.end())
+    {
+        ++m_misses;
+        return {};
+    }
+
+    ++m_hits;
+    if (m_policy == eviction_policy::lru)
+    {
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+    }
+    return found->second->result;
+}
+
+void PredicateCache::insert(const dyadic_interval& probe, bool result)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    const auto key = probe_key(probe.k, probe.n);
+    auto found = m_index.find(key);
+    if (found != m_index.end())
+    {
+        found->second->result = result;
+        if (m_policy == eviction_policy::lru)
+        {
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+        }
+        return;
+    }
+
+    if (m_entries.size() == m_capacity)
+    {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+
+    m_entries.push_front({key, probe.k, probe.n, result});
+    m_index.emplace(key, m_entries.begin());
+}
+
+void PredicateCache::invalidate()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_entries.clear();
+    m_index.clear();
+}
+
+void PredicateCache::invalidate(const interval& region)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        const auto inf = std::ldexp(static_cast<double>(it->k), -it->n);
+        const auto sup = std::ldexp(static_cast<double>(it->k) + 1.0, -it->n);
+        if (inf < region.sup() && region.inf() < sup)
+        {
+            m_index.erase(it->key);
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+std::size_t PredicateCache::size() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_entries.size();
+}
+
+std::size_t PredicateCache::hits() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_hits;
+}
+
+std::size_t PredicateCache::misses() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_misses;
+}
+
+
+predicate_t segments::cached_predicate(PredicateCache& cache, predicate_t predicate)
+{
+    return [&cache, predicate=std::move(predicate)](const interval& probe) {
+        const auto coords = probe_coordinates(probe);
+        if (auto cached = cache.lookup(coords))
+        {
+            return *cached;
+        }
+
+        const bool result = predicate(probe);
+        cache.insert(coords, result);
+        return result;
+    };
+}
@@ -0,0 +1,80 @@
+#ifndef SEGMENTS_PREDICATE_CACHE_H
+#define SEGMENTS_PREDICATE_CACHE_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace segments {
+
+/// A bounded cache of predicate results keyed on the exact dyadic
+/// coordinates (k, n) of each probe.
+///
+/// The dyadic grid does not depend on the base interval, so searches over
+/// overlapping windows probe many of the same dyadic intervals. A cache can
+/// be shared by any number of searches, across threads, as long as they all
+/// use the same predicate. When the data behind the predicate changes, the
+/// affected entries must be removed with invalidate.
+class PredicateCache {
+public:
+    enum class eviction_policy {
+        lru,    ///< evict the entry that was least recently looked up or inserted
+        fifo    ///< evict the entry that was inserted first
+    };
+
+private:
+    struct entry {
+        std::uint64_t key;
+        mult_t k;
+        depth_t n;
+        bool result;
+    };
+    using entry_list = std::list<entry>;
+
+    mutable std::mutex m_lock;
+    entry_list m_entries;
+    std::unordered_map<std::uint64_t, entry_list::iterator> m_index;
+    std::size_t m_capacity;
+    eviction_policy m_policy;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+
+public:
+    explicit PredicateCache(std::size_t capacity, eviction_policy policy = eviction_policy::lru);
+
+    PredicateCache(const PredicateCache&) = delete;
+    PredicateCache& operator=(const PredicateCache&) = delete;
+
+    /// The cached result for probe, if there is one.
+    std::optional<bool> lookup(const dyadic_interval& probe);
+
+    /// Store the result for probe, evicting an entry if the cache is full.
+    void insert(const dyadic_interval& probe, bool result);
+
+    /// Remove every entry.
+    void invalidate();
+
+    /// Remove the entries whose dyadic interval overlaps region.
+    void invalidate(const interval& region);
+
+    std::size_t size() const;
+    std::size_t capacity() const noexcept { return m_capacity; }
+    eviction_policy policy() const noexcept { return m_policy; }
+    std::size_t hits() const;
+    std::size_t misses() const;
+};
+
+
+/// Wrap predicate so that results are served from, and stored in, cache.
+/// The predicate is called without the cache lock held, so concurrent
+/// searches may occasionally evaluate the same probe twice.
+predicate_t cached_predicate(PredicateCache& cache, predicate_t predicate);
+
+} // namespace segments
+
+#endif //SEGMENTS_PREDICATE_CACHE_H
@@ -0,0 +1,128 @@
+#include "predicate_combinators.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+
+using namespace segments;
+
+
+namespace
+{
+    // Timing every call would cost about as much as a cheap check, so only
+    // one call in timing_period is timed.
+    constexpr std::uint64_t timing_period = 16;
+
+    predicate_t share(AdaptivePredicate&& predicate)
+    {
+        auto shared = std::make_shared<AdaptivePredicate>(std::move(predicate));
+        return [shared](const interval& probe) { return (*shared)(probe); };
+    }
+}
+
+
+AdaptivePredicate::AdaptivePredicate(combine_mode mode, std::vector<predicate_t> children, std::uint64_t reorder_interval)
+    : m_order(children.size()), m_mode(mode), m_reorder_interval(std::max<std::uint64_t>(reorder_interval, 1))
+{
+    if (children.empty())
+    {
+        throw std::invalid_argument("a combined predicate needs at least one child");
+    }
+
+    m_children.reserve(children.size());
+    for (auto& predicate : children)
+    {
+        m_children.push_back({std::move(predicate)});
+    }
+    std::iota(m_order.begin(), m_order.end(), std::size_t(0));
+}
+
+bool AdaptivePredicate::operator()(const interval& probe)
+{
+    const bool decisive_value = m_mode == combine_mode::any_of;
+
+    bool result = !decisive_value;
+    for (auto idx : m_order)
+    {
+        auto& child = m_children[idx];
+
+        bool value;
+        if (child.calls % timing_period == 0)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            value = child.predicate(probe);
+            child.total_cost += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            ++child.timed;
+        }
+        else
+        {
+            value = child.predicate(probe);
+        }
+        ++child.calls;
+
+        if (value == decisive_value)
+        {
+            ++child.decisive;
+            result = decisive_value;
+            break;
+        }
+    }
+
+    if (++m_calls % m_reorder_interval == 0)
+    {
+        reorder();
+    }
+    return result;
+}
+
+/*
+ * For independent checks, evaluating in increasing order of cost divided
+ * by the probability of deciding the result minimises the expected cost.
+ * The probability is smoothed so that children which have rarely been
+ * reached are neither written off nor promoted on a handful of calls.
+ */
+void AdaptivePredicate::reorder()
+{
+    std::vector<double> rank(m_children.size());
+    for (std::size_t i = 0; i < m_children.size(); ++i)
+    {
+        const auto& child = m_children[i];
+        const double cost = child.timed == 0 ? 0.0 : child.total_cost / static_cast<double>(child.timed);
+        const double p_decisive = (static_cast<double>(child.decisive) + 1.0) / (static_cast<double>(child.calls) + 2.0);
+        rank[i] = cost / p_decisive;
+    }
+
+    std::stable_sort(m_order.begin(), m_order.end(), [&rank](std::size_t lhs, std::size_t rhs) {
+        return rank[lhs] < rank[rhs];
+    });
+}
+
+AdaptivePredicate::child_stats AdaptivePredicate::stats(std::size_t idx) const
+{
+    const auto& child = m_children.at(idx);
+    return {
+            child.calls,
+            child.decisive,
+            child.timed == 0 ? 0.0 : child.total_cost / static_cast<double>(child.timed)
+    };
+}
+
+
+predicate_t segments::all_of(std::vector<predicate_t> predicates, std::uint64_t reorder_interval)
+{
+    return share(AdaptivePredicate(AdaptivePredicate::combine_mode::all_of, std::move(predicates), reorder_interval));
+}
+
+predicate_t segments::any_of(std::vector<predicate_t> predicates, std::uint64_t reorder_interval)
+{
+    return share(AdaptivePredicate(AdaptivePredicate::combine_mode::any_of, std::move(predicates), reorder_interval));
+}
+
+predicate_t segments::negate(predicate_t predicate)
+{
+    return [predicate=std::move(predicate)](const interval& probe) { return !predicate(probe); };
+}
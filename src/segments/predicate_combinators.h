@@ -0,0 +1,79 @@
+#ifndef SEGMENTS_PREDICATE_COMBINATORS_H
+#define SEGMENTS_PREDICATE_COMBINATORS_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace segments {
+
+/// A conjunction or disjunction of predicates that learns, while it is
+/// being used, the order in which to evaluate its children.
+///
+/// Evaluation stops at the first child that decides the result (false for
+/// all_of, true for any_of). For each child the combinator records how
+/// often it decides the result and, on a sample of calls, how long it takes
+/// to evaluate. Every reorder_interval calls the children are sorted by
+/// expected cost per decision, so cheap and selective checks run first.
+///
+/// The statistics are not synchronised, so a combinator must not be used
+/// by concurrent searches.
+class AdaptivePredicate {
+public:
+    enum class combine_mode {
+        all_of,
+        any_of
+    };
+
+    struct child_stats {
+        std::uint64_t calls;
+        std::uint64_t decisive;
+        double mean_cost;       ///< in nanoseconds, over the timed calls
+    };
+
+private:
+    struct child {
+        predicate_t predicate;
+        std::uint64_t calls = 0;
+        std::uint64_t decisive = 0;
+        std::uint64_t timed = 0;
+        double total_cost = 0.0;
+    };
+
+    std::vector<child> m_children;
+    std::vector<std::size_t> m_order;
+    combine_mode m_mode;
+    std::uint64_t m_reorder_interval;
+    std::uint64_t m_calls = 0;
+
+    void reorder();
+
+public:
+    AdaptivePredicate(combine_mode mode, std::vector<predicate_t> children, std::uint64_t reorder_interval = 256);
+
+    bool operator()(const interval& probe);
+
+    combine_mode mode() const noexcept { return m_mode; }
+    std::size_t size() const noexcept { return m_children.size(); }
+
+    /// The current evaluation order, as indices of the children.
+    const std::vector<std::size_t>& order() const noexcept { return m_order; }
+
+    child_stats stats(std::size_t idx) const;
+};
+
+
+/// True when every predicate is true, evaluated in an adaptive order.
+predicate_t all_of(std::vector<predicate_t> predicates, std::uint64_t reorder_interval = 256);
+
+/// True when any predicate is true, evaluated in an adaptive order.
+predicate_t any_of(std::vector<predicate_t> predicates, std::uint64_t reorder_interval = 256);
+
+/// The negation of predicate.
+predicate_t negate(predicate_t predicate);
+
+} // namespace segments
+
+#endif //SEGMENTS_PREDICATE_COMBINATORS_H
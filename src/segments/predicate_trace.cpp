@@ -0,0 +1,192 @@
+#include "predicate_trace.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "expanding_searcher.h"
+
+
+using namespace segments;
+
+
+namespace
+{
+    constexpr char trace_magic[8] = {'S', 'E', 'G', 'T', 'R', 'A', 'C', 'E'};
+    constexpr std::uint32_t trace_version = 1;
+    constexpr std::size_t record_size = sizeof(mult_t) + sizeof(depth_t) + 1;
+    constexpr std::size_t buffer_records = 4096;
+
+    template <typename T>
+    void put(std::vector<char>& buffer, const T& value)
+    {
+        const auto* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    T get(std::istream& in)
+    {
+        T value;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        {
+            throw std::runtime_error("unexpected end of predicate trace");
+        }
+        return value;
+    }
+}
+
+
+TraceWriter::TraceWriter(const std::string& path, const trace_header& header)
+    : m_out(path, std::ios::binary | std::ios::trunc)
+{
+    if (!m_out)
+    {
+        throw std::runtime_error("could not open predicate trace " + path + " for writing");
+    }
+
+    m_buffer.reserve(buffer_records * record_size);
+    m_buffer.insert(m_buffer.end(), std::begin(trace_magic), std::end(trace_magic));
+    put(m_buffer, trace_version);
+    put(m_buffer, header.base.inf());
+    put(m_buffer, header.base.sup());
+    put(m_buffer, header.signal_tolerance);
+    put(m_buffer, header.trim_tolerance);
+    put(m_buffer, header.start_depth);
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (m_out)
+    {
+        m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    }
+}
+
+void TraceWriter::write(const dyadic_interval& probe, bool result)
+{
+    put(m_buffer, probe.k);
+    put(m_buffer, probe.n);
+    m_buffer.push_back(static_cast<char>(result));
+    ++m_count;
+
+    if (m_buffer.size() >= buffer_records * record_size)
+    {
+        flush();
+    }
+}
+
+void TraceWriter::flush()
+{
+    if (!m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size())).flush())
+    {
+        throw std::runtime_error("failed to write predicate trace");
+    }
+    m_buffer.clear();
+}
+
+
+TraceReplay::TraceReplay(const std::string& path)
+    : m_header{interval(0.0, 1.0), 0, 0, 0}
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("could not open predicate trace " + path);
+    }
+
+    char magic[sizeof(trace_magic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, trace_magic, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error(path + " is not a predicate trace");
+    }
+    if (get<std::uint32_t>(in) != trace_version)
+    {
+        throw std::runtime_error("unsupported predicate trace version in " + path);
+    }
+
+    auto inf = get<double>(in);
+    auto sup = get<double>(in);
+    m_header.base = interval(inf, sup);
+    m_header.signal_tolerance = get<depth_t>(in);
+    m_header.trim_tolerance = get<depth_t>(in);
+    m_header.start_depth = get<depth_t>(in);
+
+    char record[record_size];
+    while (in.read(record, record_size))
+    {
+        probe_record rec;
+        std::memcpy(&rec.k, record, sizeof(mult_t));
+        std::memcpy(&rec.n, record + sizeof(mult_t), sizeof(depth_t));
+        rec.result = record[record_size - 1] != 0;
+        m_records.push_back(rec);
+    }
+    if (in.gcount() != 0)
+    {
+        throw std::runtime_error("truncated record in predicate trace " + path);
+    }
+}
+
+
+predicate_t segments::record_predicate(TraceWriter& writer, predicate_t predicate)
+{
+    return [&writer, predicate=std::move(predicate)](const interval& probe) {
+        auto result = predicate(probe);
+        writer.write(probe_coordinates(probe), result);
+        return result;
+    };
+}
+
+std::vector<interval> segments::record_segment(const std::string& path,
+                                               interval arg,
+                                               const predicate_t& predicate,
+                                               depth_t signal_tolerance,
+                                               depth_t trim_tolerance,
+                                               depth_t start_depth)
+{
+    if (trim_tolerance < signal_tolerance)
+    {
+        trim_tolerance = signal_tolerance;
+    }
+
+    TraceWriter writer(path, {arg, signal_tolerance, trim_tolerance, start_depth});
+    auto result = segment(arg, record_predicate(writer, predicate), signal_tolerance, trim_tolerance, start_depth);
+    writer.flush();
+    return result;
+}
+
+/*
+ * The replayed search receives the coordinates of each probe directly, so
+ * serving an answer costs one comparison with the next record and the
+ * replay measures little but the searcher itself.
+ */
+std::vector<interval> segments::replay_segment(const TraceReplay& replay)
+{
+    const auto& header = replay.header();
+    const auto& records = replay.records();
+    std::size_t next = 0;
+
+    dyadic_predicate_t predicate = [&records, &next](mult_t k, depth_t n)
+    {
+        if (next == records.size())
+        {
+            throw std::runtime_error("the replayed search made more probes than the trace records");
+        }
+        const auto& rec = records[next];
+        if (rec.k != k || rec.n != n)
+        {
+            throw std::runtime_error("probe " + std::to_string(next) + " of the replayed search differs from the trace");
+        }
+        ++next;
+        return rec.result;
+    };
+
+    ExpandingSearcher searcher(header.trim_tolerance, header.signal_tolerance, header.start_depth);
+    searcher.search_interval(header.base, predicate);
+    if (next != records.size())
+    {
+        throw std::runtime_error("the replayed search made fewer probes than the trace records");
+    }
+    return std::move(searcher).result();
+}
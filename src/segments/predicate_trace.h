@@ -0,0 +1,88 @@
+#ifndef SEGMENTS_PREDICATE_TRACE_H
+#define SEGMENTS_PREDICATE_TRACE_H
+
+#include "segments.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace segments {
+
+/*
+ * A predicate trace records every probe made during a search so that the
+ * search can be replayed later without the original predicate or data.
+ *
+ * The file starts with the 8 byte magic "SEGTRACE", a uint32 format version,
+ * the base interval as two doubles and the signal tolerance, trim tolerance
+ * and start depth as three int32s. This is followed by one 9 byte record per
+ * probe: k and n as int32s and the predicate result as a single byte. All
+ * values are stored in the byte order of the machine that wrote the trace.
+ */
+
+struct trace_header {
+    interval base;
+    depth_t signal_tolerance;
+    depth_t trim_tolerance;
+    depth_t start_depth;
+};
+
+struct probe_record {
+    mult_t k;
+    depth_t n;
+    bool result;
+};
+
+
+class TraceWriter {
+    std::ofstream m_out;
+    std::vector<char> m_buffer;
+    std::size_t m_count = 0;
+
+public:
+    TraceWriter(const std::string& path, const trace_header& header);
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void write(const dyadic_interval& probe, bool result);
+    void flush();
+
+    std::size_t count() const noexcept { return m_count; }
+};
+
+
+class TraceReplay {
+    trace_header m_header;
+    std::vector<probe_record> m_records;
+
+public:
+    explicit TraceReplay(const std::string& path);
+
+    const trace_header& header() const noexcept { return m_header; }
+    const std::vector<probe_record>& records() const noexcept { return m_records; }
+};
+
+
+/// Wrap predicate so that every evaluation is logged to writer.
+predicate_t record_predicate(TraceWriter& writer, predicate_t predicate);
+
+/// Run segment with the given predicate, recording the probes to path.
+std::vector<interval> record_segment(const std::string& path,
+                                     interval arg,
+                                     const predicate_t& predicate,
+                                     depth_t signal_tolerance,
+                                     depth_t trim_tolerance = 0,
+                                     depth_t start_depth = 0);
+
+/// Rerun the search recorded in replay, serving the recorded answers in
+/// order. The search is deterministic, so it must make exactly the recorded
+/// probes in the recorded order; std::runtime_error is thrown if it does
+/// not.
+std::vector<interval> replay_segment(const TraceReplay& replay);
+
+} // namespace segments
+
+#endif //SEGMENTS_PREDICATE_TRACE_H
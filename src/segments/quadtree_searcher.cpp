@@ -0,0 +1,222 @@
+#include "quadtree_searcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+
+using namespace segments;
+
+
+namespace
+{
+    /// The dyadic intervals at depth that overlap ivl.
+    std::vector<dyadic_interval> covering(const interval& ivl, depth_t depth)
+    {
+        std::vector<dyadic_interval> result;
+        for (dyadic_interval di(ivl.inf(), depth); static_cast<double>(di.inf()) < ivl.sup(); ++di)
+        {
+            result.push_back(di);
+        }
+        return result;
+    }
+
+    bool overlaps(const dyadic_rectangle& cell, const rectangle& rect) noexcept
+    {
+        return static_cast<double>(cell.x.inf()) < rect.x.sup() && rect.x.inf() < static_cast<double>(cell.x.sup())
+               && static_cast<double>(cell.y.inf()) < rect.y.sup() && rect.y.inf() < static_cast<double>(cell.y.sup());
+    }
+}
+
+
+dyadic_rectangle dyadic_rectangle::parent() const
+{
+    return {dyadic_interval(x.inf(), x.n - 1), dyadic_interval(y.inf(), y.n - 1)};
+}
+
+std::array<dyadic_rectangle, 4> dyadic_rectangle::children() const
+{
+    const auto n = depth() + 1;
+    const auto kx = 2 * x.k;
+    const auto ky = 2 * y.k;
+    return {
+            dyadic_rectangle(kx, ky, n),
+            dyadic_rectangle(kx + 1, ky, n),
+            dyadic_rectangle(kx, ky + 1, n),
+            dyadic_rectangle(kx + 1, ky + 1, n)
+    };
+}
+
+
+std::size_t QuadtreeSearcher::cell_hash::operator()(const dyadic_rectangle& cell) const noexcept
+{
+    auto key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cell.x.k)) << 32)
+               | static_cast<std::uint32_t>(cell.y.k);
+    return std::hash<std::uint64_t>()(key ^ (static_cast<std::uint64_t>(cell.depth()) * 0x9e3779b97f4a7c15ULL));
+}
+
+/// Whether cell lies in an accepted square. Nothing coarser than the first
+/// depth of the search is ever accepted, so the lookup stops there.
+bool QuadtreeSearcher::is_accepted(dyadic_rectangle cell) const
+{
+    for (;;)
+    {
+        if (m_accepted.count(cell) != 0)
+        {
+            return true;
+        }
+        if (cell.depth() <= m_first_depth)
+        {
+            return false;
+        }
+        cell = cell.parent();
+    }
+}
+
+bool QuadtreeSearcher::touches_accepted(const dyadic_rectangle& cell) const
+{
+    const auto n = cell.depth();
+    return is_accepted(dyadic_rectangle(cell.x.k - 1, cell.y.k, n))
+           || is_accepted(dyadic_rectangle(cell.x.k + 1, cell.y.k, n))
+           || is_accepted(dyadic_rectangle(cell.x.k, cell.y.k - 1, n))
+           || is_accepted(dyadic_rectangle(cell.x.k, cell.y.k + 1, n));
+}
+
+depth_t QuadtreeSearcher::coarsest_fitting_depth(const rectangle& rect) noexcept
+{
+    depth_t expo;
+    std::frexp(std::min(rect.x.sup() - rect.x.inf(), rect.y.sup() - rect.y.inf()), &expo);
+    return 1 - expo;
+}
+
+depth_t QuadtreeSearcher::start_depth(const rectangle& rect) const noexcept
+{
+    auto depth = (m_start_depth == adaptive_start_depth) ? coarsest_fitting_depth(rect) : m_start_depth;
+    return std::min(depth, m_signal_tol);
+}
+
+void QuadtreeSearcher::search(const rectangle& base, const predicate2d_t& predicate)
+{
+    search_batched(base, [&predicate](const rectangle* cells, std::size_t count, bool* results) {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            results[i] = predicate(cells[i]);
+        }
+    });
+}
+
+void QuadtreeSearcher::search_batched(const rectangle& base, const batch_predicate2d_t& predicate)
+{
+    m_base = base;
+    m_found.clear();
+    m_accepted.clear();
+
+    const auto first_depth = start_depth(base);
+    m_first_depth = first_depth;
+
+    std::vector<dyadic_rectangle> level;
+    for (const auto& dx : covering(base.x, first_depth))
+    {
+        for (const auto& dy : covering(base.y, first_depth))
+        {
+            level.emplace_back(dx, dy);
+        }
+    }
+
+    std::vector<rectangle> cells;
+    std::unique_ptr<bool[]> results;
+    std::size_t capacity = 0;
+    std::vector<dyadic_rectangle> rejected;
+    std::vector<dyadic_rectangle> next;
+    for (auto depth = first_depth; !level.empty(); ++depth)
+    {
+        cells.assign(level.begin(), level.end());
+        if (capacity < level.size())
+        {
+            capacity = level.size();
+            results.reset(new bool[capacity]);
+        }
+        predicate(cells.data(), cells.size(), results.get());
+
+        rejected.clear();
+        for (std::size_t i = 0; i < level.size(); ++i)
+        {
+            if (results[i])
+            {
+                m_found.push_back(level[i]);
+                m_accepted.insert(level[i]);
+            }
+            else
+            {
+                rejected.push_back(level[i]);
+            }
+        }
+
+        if (depth >= m_trim_tol)
+        {
+            break;
+        }
+
+        next.clear();
+        for (const auto& cell : rejected)
+        {
+            if (depth >= m_signal_tol && !touches_accepted(cell))
+            {
+                continue;
+            }
+            for (const auto& child : cell.children())
+            {
+                if (overlaps(child, base))
+                {
+                    next.push_back(child);
+                }
+            }
+        }
+        level.swap(next);
+    }
+}
+
+std::vector<rectangle> QuadtreeSearcher::result() const
+{
+    std::vector<rectangle> clipped;
+    clipped.reserve(m_found.size());
+    for (const auto& cell : m_found)
+    {
+        clipped.push_back({
+                interval(std::max(static_cast<double>(cell.x.inf()), m_base.x.inf()),
+                         std::min(static_cast<double>(cell.x.sup()), m_base.x.sup())),
+                interval(std::max(static_cast<double>(cell.y.inf()), m_base.y.inf()),
+                         std::min(static_cast<double>(cell.y.sup()), m_base.y.sup()))
+        });
+    }
+    return clipped;
+}
+
+
+std::vector<rectangle> segments::segment2d(const rectangle& arg, const predicate2d_t& predicate,
+                                           depth_t signal_tolerance, depth_t trim_tolerance, depth_t start_depth)
+{
+    if (trim_tolerance < signal_tolerance)
+    {
+        trim_tolerance = signal_tolerance;
+    }
+
+    QuadtreeSearcher searcher(trim_tolerance, signal_tolerance, start_depth);
+    searcher.search(arg, predicate);
+    return searcher.result();
+}
+
+std::vector<rectangle> segments::segment2d_batched(const rectangle& arg, const batch_predicate2d_t& predicate,
+                                                   depth_t signal_tolerance, depth_t trim_tolerance,
+                                                   depth_t start_depth)
+{
+    if (trim_tolerance < signal_tolerance)
+    {
+        trim_tolerance = signal_tolerance;
+    }
+
+    QuadtreeSearcher searcher(trim_tolerance, signal_tolerance, start_depth);
+    searcher.search_batched(arg, predicate);
+    return searcher.result();
+}
@@ -0,0 +1,117 @@
+#ifndef SEGMENTS_QUADTREE_SEARCHER_H
+#define SEGMENTS_QUADTREE_SEARCHER_H
+
+#include "segments.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+namespace segments {
+
+/// An axis-aligned rectangle, the product of two intervals.
+struct rectangle {
+    interval x;
+    interval y;
+};
+
+/// A dyadic square, the product of two dyadic intervals of the same depth.
+struct dyadic_rectangle {
+    dyadic_interval x;
+    dyadic_interval y;
+
+    dyadic_rectangle(mult_t kx, mult_t ky, depth_t n) : x(kx, n), y(ky, n) {}
+    dyadic_rectangle(dyadic_interval dx, dyadic_interval dy) : x(dx), y(dy) {}
+
+    depth_t depth() const noexcept { return x.n; }
+
+    rectangle to_rectangle() const { return {interval(x), interval(y)}; }
+    operator rectangle() const { return to_rectangle(); }
+
+    /// The square one level coarser that contains this one.
+    dyadic_rectangle parent() const;
+
+    /// The four squares one level finer that partition this one.
+    std::array<dyadic_rectangle, 4> children() const;
+
+    friend bool operator==(const dyadic_rectangle& lhs, const dyadic_rectangle& rhs) noexcept
+    { return lhs.x.k == rhs.x.k && lhs.y.k == rhs.y.k && lhs.x.n == rhs.x.n; }
+};
+
+using predicate2d_t = std::function<bool(const rectangle&)>;
+
+/// A predicate evaluated on many rectangles at once, writing one result for
+/// each of the count rectangles in cells.
+using batch_predicate2d_t = std::function<void(const rectangle* cells, std::size_t count, bool* results)>;
+
+
+/// The two-dimensional counterpart of ExpandingSearcher, which segments a
+/// base rectangle into dyadic squares on which the predicate holds.
+///
+/// The base rectangle is covered by squares at the start depth, and each
+/// level of the quadtree is evaluated in turn, as a single batch when the
+/// predicate is batched. Squares on which the
+/// predicate holds are accepted, and the others are split into their four
+/// children until the signal tolerance is reached. Beyond the signal
+/// tolerance, down to the trim tolerance, only the squares that share an
+/// edge with an accepted square are split, which refines the boundary of
+/// each region found in the same way that expansion refines the ends of a
+/// segment in one dimension. Unlike the one-dimensional search, adjacent
+/// accepted squares are not merged, since a union of squares need not be a
+/// rectangle.
+class QuadtreeSearcher {
+    struct cell_hash {
+        std::size_t operator()(const dyadic_rectangle& cell) const noexcept;
+    };
+
+    rectangle m_base{interval(0.0, 1.0), interval(0.0, 1.0)};
+    depth_t m_first_depth = 0;
+    std::unordered_set<dyadic_rectangle, cell_hash> m_accepted;
+
+    bool touches_accepted(const dyadic_rectangle& cell) const;
+    bool is_accepted(dyadic_rectangle cell) const;
+
+public:
+    std::vector<dyadic_rectangle> m_found;
+    depth_t m_trim_tol;
+    depth_t m_signal_tol;
+    depth_t m_start_depth;
+
+    QuadtreeSearcher(depth_t trim_tol, depth_t signal_tol, depth_t start_depth = 0)
+        : m_trim_tol(trim_tol),
+          m_signal_tol(signal_tol),
+          m_start_depth(start_depth)
+    {}
+
+    /// The coarsest depth at which a dyadic square fits in both sides of rect.
+    static depth_t coarsest_fitting_depth(const rectangle& rect) noexcept;
+
+    /// The depth at which the search of rect begins, never finer than the
+    /// signal tolerance.
+    depth_t start_depth(const rectangle& rect) const noexcept;
+
+    void search(const rectangle& base, const predicate2d_t& predicate);
+    void search_batched(const rectangle& base, const batch_predicate2d_t& predicate);
+
+    /// The accepted squares clipped to the base rectangle.
+    std::vector<rectangle> result() const;
+
+    /// The accepted squares, which may overhang the base rectangle.
+    std::vector<dyadic_rectangle> cell_result() && noexcept { return std::move(m_found); }
+};
+
+
+/// Segment a rectangle into dyadic squares on which predicate holds, clipped
+/// to arg. Tolerances and start depth are as for segment.
+std::vector<rectangle> segment2d(const rectangle& arg, const predicate2d_t& predicate, depth_t signal_tolerance,
+                                 depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// As segment2d, evaluating each level of the quadtree as one batch.
+std::vector<rectangle> segment2d_batched(const rectangle& arg, const batch_predicate2d_t& predicate,
+                                         depth_t signal_tolerance, depth_t trim_tolerance=0, depth_t start_depth=0);
+
+} // namespace segments
+
+#endif //SEGMENTS_QUADTREE_SEARCHER_H
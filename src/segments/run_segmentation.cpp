@@ -0,0 +1,241 @@
+#include "run_segmentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "expanding_searcher.h"
+#include "sharding.h"
+
+
+using namespace segments;
+
+
+namespace
+{
+    // Below this many runs per thread the search is not worth splitting.
+    constexpr std::size_t min_runs_per_thread = 4096;
+
+    /*
+     * The searcher only reads the first and last pieces of the run of
+     * adjacent intervals found by a scan, so a block of any length is pushed
+     * as at most two pieces.
+     */
+    void push_block(ExpandingSearcher& searcher, mult_t first, mult_t last, depth_t depth)
+    {
+        searcher.m_forward_expansion.emplace_back(first, depth);
+        if (last - first > 1)
+        {
+            searcher.m_forward_expansion.emplace_back(last - 1, depth);
+        }
+    }
+
+    /*
+     * The scans below mirror ExpandingSearcher::scan_first_layer and
+     * scan_layer, but jump to the first dyadic interval inside a run instead
+     * of probing every interval in between. The expansion around a block is
+     * left to the searcher, with membership of the runs as the predicate.
+     */
+    using scan_outcome = ExpandingSearcher::scan_outcome;
+
+    scan_outcome scan_first_layer(ExpandingSearcher& searcher, ExpandingSearcher::component_iterator component,
+                                  dyadic_interval from, depth_t depth, const RunSet& runs,
+                                  const predicate_t& predicate)
+    {
+        searcher.m_forward_expansion.clear();
+        searcher.m_backward_expansion.clear();
+
+        dyadic_interval end(component->sup(), depth);
+        auto block = runs.first_block(from.k, end.k, depth);
+        if (block.first == block.second)
+        {
+            return scan_outcome::finished;
+        }
+
+        push_block(searcher, block.first, block.second, depth);
+        return searcher.expand(component, predicate) ? scan_outcome::found : scan_outcome::exhausted;
+    }
+
+    scan_outcome scan_layer(ExpandingSearcher& searcher, ExpandingSearcher::component_iterator component,
+                            dyadic_interval from, depth_t depth, const RunSet& runs,
+                            const predicate_t& predicate)
+    {
+        dyadic_interval end(component->sup(), depth);
+        auto block = runs.first_block(from.k, end.k, depth);
+        if (block.first == block.second)
+        {
+            return scan_outcome::finished;
+        }
+
+        searcher.m_forward_expansion.emplace_back(block.first, depth);
+        return searcher.expand(component, predicate) ? scan_outcome::found : scan_outcome::exhausted;
+    }
+}
+
+
+RunSet::RunSet(const double* starts, const double* ends, std::size_t count)
+{
+    m_starts.reserve(count);
+    m_ends.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i > 0 && starts[i] < starts[i - 1])
+        {
+            throw std::invalid_argument("runs must be sorted by start");
+        }
+        if (!(starts[i] < ends[i]))
+        {
+            continue;
+        }
+
+        if (!m_ends.empty() && starts[i] <= m_ends.back())
+        {
+            m_ends.back() = std::max(m_ends.back(), ends[i]);
+        }
+        else
+        {
+            m_starts.push_back(starts[i]);
+            m_ends.push_back(ends[i]);
+        }
+    }
+}
+
+RunSet::RunSet(const std::vector<interval>& runs)
+{
+    std::vector<double> starts, ends;
+    starts.reserve(runs.size());
+    ends.reserve(runs.size());
+    for (const auto& run : runs)
+    {
+        starts.push_back(run.inf());
+        ends.push_back(run.sup());
+    }
+    *this = RunSet(starts.data(), ends.data(), runs.size());
+}
+
+bool RunSet::contains(const interval& arg) const noexcept
+{
+    auto it = std::upper_bound(m_starts.begin(), m_starts.end(), arg.inf());
+    if (it == m_starts.begin())
+    {
+        return false;
+    }
+    return arg.sup() <= m_ends[static_cast<std::size_t>(it - m_starts.begin()) - 1];
+}
+
+std::pair<mult_t, mult_t> RunSet::first_block(mult_t from, mult_t end, depth_t depth) const noexcept
+{
+    const auto from_value = std::ldexp(static_cast<double>(from), -depth);
+    auto idx = static_cast<std::size_t>(std::upper_bound(m_ends.begin(), m_ends.end(), from_value) - m_ends.begin());
+
+    for (; idx < m_starts.size(); ++idx)
+    {
+        // The dyadic intervals (k, depth) inside the run are those with
+        // ceil(start 2^depth) <= k < floor(end 2^depth). These are kept as
+        // doubles until clipped to [from, end) so that they cannot overflow.
+        const auto first = std::max(static_cast<double>(from), std::ceil(std::ldexp(m_starts[idx], depth)));
+        if (first >= static_cast<double>(end))
+        {
+            break;
+        }
+
+        const auto last = std::min(static_cast<double>(end), std::floor(std::ldexp(m_ends[idx], depth)));
+        if (first < last)
+        {
+            return {static_cast<mult_t>(first), static_cast<mult_t>(last)};
+        }
+    }
+    return {end, end};
+}
+
+
+std::vector<interval> segments::segment_runs(interval arg, const RunSet& runs, depth_t signal_tolerance,
+                                             depth_t trim_tolerance, depth_t start_depth)
+{
+    if (trim_tolerance < signal_tolerance)
+    {
+        trim_tolerance = signal_tolerance;
+    }
+
+    ExpandingSearcher searcher(trim_tolerance, signal_tolerance, start_depth);
+    const predicate_t predicate = std::cref(runs);
+
+    auto& components = searcher.m_search_components;
+    components.push_back(arg);
+
+    const auto first_depth = searcher.start_depth(arg);
+    {
+        auto component = components.begin();
+        dyadic_interval from(arg.inf(), first_depth);
+        for (;;)
+        {
+            auto outcome = scan_first_layer(searcher, component, from, first_depth, runs, predicate);
+            if (outcome == scan_outcome::exhausted)
+            {
+                components.erase(component);
+            }
+            if (outcome != scan_outcome::found)
+            {
+                break;
+            }
+            from = ExpandingSearcher::resume_point(*component, first_depth);
+        }
+    }
+
+    for (depth_t depth = first_depth + 1; depth <= signal_tolerance && !components.empty(); ++depth)
+    {
+        for (auto component = components.begin(); component != components.end();)
+        {
+            dyadic_interval from(component->inf(), depth);
+            auto outcome = scan_layer(searcher, component, from, depth, runs, predicate);
+            while (outcome == scan_outcome::found)
+            {
+                outcome = scan_layer(searcher, component, ExpandingSearcher::resume_point(*component, depth),
+                                     depth, runs, predicate);
+            }
+
+            if (outcome == scan_outcome::exhausted)
+            {
+                component = components.erase(component);
+            }
+            else
+            {
+                ++component;
+            }
+        }
+    }
+
+    return std::move(searcher).result();
+}
+
+std::vector<interval> segments::segment_runs_parallel(interval arg, const RunSet& runs, depth_t signal_tolerance,
+                                                      depth_t trim_tolerance, depth_t start_depth, unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const auto count = std::min<std::size_t>(threads, (runs.size() + min_runs_per_thread - 1) / min_runs_per_thread);
+
+    auto plan = plan_shards(arg, std::max<std::size_t>(count, 1), signal_tolerance, trim_tolerance, start_depth);
+    std::vector<std::vector<interval>> results(plan.shards.size());
+
+    std::vector<std::thread> workers;
+    workers.reserve(plan.shards.size());
+    for (std::size_t i = 1; i < plan.shards.size(); ++i)
+    {
+        workers.emplace_back([&plan, &runs, &results, i] {
+            results[i] = segment_runs(plan.shards[i], runs, plan.signal_tolerance, plan.trim_tolerance,
+                                      plan.start_depth);
+        });
+    }
+    results[0] = segment_runs(plan.shards[0], runs, plan.signal_tolerance, plan.trim_tolerance, plan.start_depth);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    return stitch_shards(plan, results, std::cref(runs));
+}
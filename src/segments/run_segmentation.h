@@ -0,0 +1,57 @@
+#ifndef SEGMENTS_RUN_SEGMENTATION_H
+#define SEGMENTS_RUN_SEGMENTATION_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace segments {
+
+/// A sorted set of runs [starts[i], ends[i]) on which a predicate is known
+/// to hold, used as the membership predicate: true on an interval that lies
+/// inside the union of the runs.
+///
+/// Overlapping and touching runs are merged and empty runs are dropped, so
+/// the runs held are disjoint and separated by gaps.
+class RunSet {
+    std::vector<double> m_starts;
+    std::vector<double> m_ends;
+
+public:
+    /// The runs must be sorted by start.
+    RunSet(const double* starts, const double* ends, std::size_t count);
+    explicit RunSet(const std::vector<interval>& runs);
+
+    std::size_t size() const noexcept { return m_starts.size(); }
+
+    /// Whether arg lies inside one of the runs.
+    bool contains(const interval& arg) const noexcept;
+    bool operator()(const interval& arg) const noexcept { return contains(arg); }
+
+    /// The first block [first, last) of consecutive multipliers k in
+    /// [from, end) for which the dyadic interval (k, depth) lies inside a
+    /// run. The block is empty if there is none.
+    std::pair<mult_t, mult_t> first_block(mult_t from, mult_t end, depth_t depth) const noexcept;
+};
+
+
+/// Compute exactly the result of segment for the membership predicate of
+/// runs, without probing. Rather than scanning every dyadic interval at each
+/// depth, the search jumps straight to the dyadic intervals that lie inside
+/// a run, so the cost grows with the number of runs and the depth rather
+/// than with the length of arg.
+std::vector<interval> segment_runs(interval arg, const RunSet& runs, depth_t signal_tolerance,
+                                   depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// As segment_runs, splitting arg into shards searched on separate threads.
+/// If threads is 0 the number of hardware threads is used. The segments are
+/// returned sorted by position.
+std::vector<interval> segment_runs_parallel(interval arg, const RunSet& runs, depth_t signal_tolerance,
+                                            depth_t trim_tolerance=0, depth_t start_depth=0,
+                                            unsigned threads=0);
+
+} // namespace segments
+
+#endif //SEGMENTS_RUN_SEGMENTATION_H
@@ -0,0 +1,70 @@
+#include "sample_grid.h"
+
+#include <algorithm>
+#include <limits>
+
+
+using namespace segments;
+
+
+namespace
+{
+    constexpr std::int64_t int64_max = std::numeric_limits<std::int64_t>::max();
+    constexpr std::int64_t int64_min = std::numeric_limits<std::int64_t>::min();
+
+    /// ceil(value * 2^shift), saturating at the limits of int64.
+    inline std::int64_t scale_up(std::int64_t value, depth_t shift) noexcept
+    {
+        if (shift >= 0)
+        {
+            if (value == 0)
+            {
+                return 0;
+            }
+            if (shift >= 62 || value > (int64_max >> shift) || value < (int64_min >> shift))
+            {
+                return value > 0 ? int64_max : int64_min;
+            }
+            return value * (std::int64_t(1) << shift);
+        }
+
+        // ceil(value / 2^s) = -floor(-value / 2^s), with an arithmetic shift
+        // as the floor.
+        const auto s = -shift;
+        if (s >= 62)
+        {
+            return value > 0 ? 1 : 0;
+        }
+        return -((-value) >> s);
+    }
+
+    /// The index of the first sample at or after the grid point cell.
+    inline std::size_t index_of(std::int64_t cell, std::int64_t first_cell, std::size_t count) noexcept
+    {
+        if (cell <= first_cell)
+        {
+            return 0;
+        }
+        const auto offset = static_cast<std::uint64_t>(cell) - static_cast<std::uint64_t>(first_cell);
+        return static_cast<std::size_t>(std::min<std::uint64_t>(offset, count));
+    }
+}
+
+
+std::pair<std::size_t, std::size_t> sample_grid::samples(mult_t k, depth_t n) const noexcept
+{
+    // The samples in [k/2^n, (k+1)/2^n) are the cells c with
+    // k * 2^(r-n) <= c < (k+1) * 2^(r-n), rounded up when n is finer than r.
+    const auto shift = resolution - n;
+    const auto begin = index_of(scale_up(k, shift), first_cell, count);
+    const auto end = index_of(scale_up(std::int64_t(k) + 1, shift), first_cell, count);
+    return {begin, end};
+}
+
+dyadic_predicate_t segments::on_grid(const sample_grid& grid, sample_predicate_t predicate)
+{
+    return [grid, predicate = std::move(predicate)](mult_t k, depth_t n) {
+        const auto range = grid.samples(k, n);
+        return predicate(range.first, range.second);
+    };
+}
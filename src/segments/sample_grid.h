@@ -0,0 +1,34 @@
+#ifndef SEGMENTS_SAMPLE_GRID_H
+#define SEGMENTS_SAMPLE_GRID_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace segments {
+
+/// A uniform grid of count samples at the points (first_cell + i) / 2^resolution,
+/// on which the samples in any dyadic interval are found with integer
+/// arithmetic alone.
+struct sample_grid {
+    depth_t resolution;
+    std::int64_t first_cell;
+    std::size_t count;
+
+    /// The indices [begin, end) of the samples in the dyadic interval (k, n).
+    std::pair<std::size_t, std::size_t> samples(mult_t k, depth_t n) const noexcept;
+};
+
+/// A predicate over the samples [begin, end) of a sample_grid in a probe.
+using sample_predicate_t = std::function<bool(std::size_t begin, std::size_t end)>;
+
+/// A dyadic predicate calling predicate with the indices of the samples of
+/// grid in each probe.
+dyadic_predicate_t on_grid(const sample_grid& grid, sample_predicate_t predicate);
+
+} // namespace segments
+
+#endif //SEGMENTS_SAMPLE_GRID_H
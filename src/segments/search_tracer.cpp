@@ -0,0 +1,115 @@
+#include "search_tracer.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+using namespace segments;
+
+
+SearchTracer::SearchTracer(const std::string& path)
+    : m_out(path, std::ios::trunc),
+      m_origin(std::chrono::steady_clock::now())
+{
+    if (!m_out)
+    {
+        throw std::runtime_error("could not open trace file " + path + " for writing");
+    }
+
+    m_out.precision(std::numeric_limits<double>::max_digits10);
+    m_out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+          << R"({"name":"process_name","ph":"M","pid":1,"tid":1,"args":{"name":"segments"}})";
+    m_first_event = false;
+}
+
+SearchTracer::~SearchTracer()
+{
+    m_out << "\n]}\n";
+}
+
+double SearchTracer::now() const noexcept
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+void SearchTracer::event(const char* name, char phase, double timestamp, arg_list args, double duration)
+{
+    if (!m_first_event)
+    {
+        m_out << ",\n";
+    }
+    m_first_event = false;
+
+    m_out << R"({"name":")" << name << R"(","cat":"search","ph":")" << phase
+          << R"(","pid":1,"tid":1,"ts":)" << timestamp;
+    if (duration >= 0.0)
+    {
+        m_out << ",\"dur\":" << duration;
+    }
+    if (args.size() != 0)
+    {
+        m_out << ",\"args\":{";
+        bool first = true;
+        for (const auto& arg : args)
+        {
+            m_out << (first ? "\"" : ",\"") << arg.first << "\":";
+            if (std::isfinite(arg.second))
+            {
+                m_out << arg.second;
+            }
+            else
+            {
+                m_out << "null";
+            }
+            first = false;
+        }
+        m_out << '}';
+    }
+    m_out << '}';
+}
+
+void SearchTracer::begin(const char* name, arg_list args)
+{
+    event(name, 'B', now(), args);
+    m_open.push_back(name);
+}
+
+void SearchTracer::end(const char* name, arg_list args)
+{
+    event(name, 'E', now(), args);
+    if (!m_open.empty())
+    {
+        m_open.pop_back();
+    }
+}
+
+void SearchTracer::unwind(std::size_t depth)
+{
+    while (m_open.size() > depth)
+    {
+        end(m_open.back(), {{"unwound", 1.0}});
+    }
+}
+
+void SearchTracer::complete(const char* name, double start, double duration, arg_list args)
+{
+    event(name, 'X', start, args, duration);
+}
+
+predicate_t SearchTracer::trace_predicate(const predicate_t& predicate)
+{
+    return [this, &predicate](const interval& probe) {
+        const auto start = now();
+        const bool result = predicate(probe);
+        const auto duration = now() - start;
+
+        const auto di = probe_coordinates(probe);
+        complete("predicate", start, duration, {
+                {"k", double(di.k)},
+                {"n", double(di.n)},
+                {"result", double(result)}
+        });
+        return result;
+    };
+}
@@ -0,0 +1,62 @@
+#ifndef SEGMENTS_SEARCH_TRACER_H
+#define SEGMENTS_SEARCH_TRACER_H
+
+#include "segments.h"
+
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace segments {
+
+/// Writes the timeline of a search as a Chrome trace-event JSON file, which
+/// can be opened offline in Perfetto (ui.perfetto.dev) or chrome://tracing.
+///
+/// A searcher with a tracer attached records each search, each depth pass,
+/// each call to expand along with its left and right probe chains, and each
+/// predicate evaluation with its duration. Several searches can be written
+/// to the same tracer; the file is completed when the tracer is destroyed.
+/// Non-finite argument values are written as null.
+class SearchTracer {
+public:
+    using arg_list = std::initializer_list<std::pair<const char*, double>>;
+
+private:
+    std::ofstream m_out;
+    std::chrono::steady_clock::time_point m_origin;
+    bool m_first_event = true;
+    std::vector<const char*> m_open;
+
+    void event(const char* name, char phase, double timestamp, arg_list args, double duration = -1.0);
+
+public:
+    explicit SearchTracer(const std::string& path);
+    ~SearchTracer();
+
+    SearchTracer(const SearchTracer&) = delete;
+    SearchTracer& operator=(const SearchTracer&) = delete;
+
+    /// Microseconds since the tracer was created.
+    double now() const noexcept;
+
+    void begin(const char* name, arg_list args = {});
+    void end(const char* name, arg_list args = {});
+    void complete(const char* name, double start, double duration, arg_list args = {});
+
+    /// Number of begin events that have not yet been ended.
+    std::size_t open_events() const noexcept { return m_open.size(); }
+
+    /// End every event still open above depth, innermost first, so the
+    /// timeline stays balanced when a search is left by an exception.
+    void unwind(std::size_t depth);
+
+    /// Wrap predicate so that each evaluation is recorded with its duration.
+    predicate_t trace_predicate(const predicate_t& predicate);
+};
+
+} // namespace segments
+
+#endif //SEGMENTS_SEARCH_TRACER_H
@@ -2,7 +2,9 @@
 // Created by sam on 08/11/22.
 //
 
+#include <algorithm>
 #include <csignal>
+#include <cmath>
 
 #include "segments.h"
 
@@ -11,18 +13,166 @@
 using namespace segments;
 
 
+namespace
+{
+    template <typename Predicate>
+    ExpandingSearcher run_search(const interval& arg, const Predicate& predicate, depth_t signal_tolerance,
+                                 depth_t trim_tolerance, depth_t start_depth,
+                                 query_mode mode = query_mode::segments, bool record_dyadic = false)
+    {
+        if (trim_tolerance < signal_tolerance)
+        {
+            trim_tolerance = signal_tolerance;
+        }
+
+        ExpandingSearcher searcher(trim_tolerance, signal_tolerance, start_depth);
+        searcher.m_mode = mode;
+        searcher.m_record_dyadic = record_dyadic;
+        searcher.search_interval(arg, predicate);
+        return searcher;
+    }
+
+    template <typename Predicate>
+    std::optional<interval> run_first(const interval& arg, const Predicate& predicate, depth_t signal_tolerance,
+                                      depth_t trim_tolerance, depth_t start_depth)
+    {
+        auto searcher = run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::first);
+        if (searcher.m_count == 0)
+        {
+            return std::nullopt;
+        }
+        return searcher.first_found();
+    }
+}
 
 
 std::vector<interval>
-segments::segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance)
+segments::segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance,
+                  depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth).result();
+}
+
+std::vector<interval>
+segments::segment(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                  depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth).result();
+}
+
+std::vector<dyadic_segment>
+segments::segment_dyadic(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance,
+                         depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::segments, true)
+            .dyadic_result();
+}
+
+std::vector<dyadic_segment>
+segments::segment_dyadic(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                         depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::segments, true)
+            .dyadic_result();
+}
+
+bool segments::any_segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                           depth_t trim_tolerance, depth_t start_depth)
 {
-    if (trim_tolerance < signal_tolerance)
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::any).m_count != 0;
+}
+
+bool segments::any_segment(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                           depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::any).m_count != 0;
+}
+
+std::optional<interval>
+segments::first_segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance,
+                        depth_t start_depth)
+{
+    return run_first(arg, predicate, signal_tolerance, trim_tolerance, start_depth);
+}
+
+std::optional<interval>
+segments::first_segment(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                        depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_first(arg, predicate, signal_tolerance, trim_tolerance, start_depth);
+}
+
+std::size_t segments::count_segments(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                                     depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::count).m_count;
+}
+
+std::size_t segments::count_segments(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                                     depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::count).m_count;
+}
+
+double segments::segment_measure(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                                 depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::measure).m_measure;
+}
+
+double segments::segment_measure(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                                 depth_t trim_tolerance, depth_t start_depth)
+{
+    return run_search(arg, predicate, signal_tolerance, trim_tolerance, start_depth, query_mode::measure).m_measure;
+}
+
+std::vector<std::vector<interval>>
+segments::segment_pyramid(interval arg, const predicate_t& predicate, const std::vector<depth_t>& signal_tolerances,
+                          depth_t trim_tolerance, depth_t start_depth)
+{
+    std::vector<std::vector<interval>> result(signal_tolerances.size());
+    if (signal_tolerances.empty())
     {
-        trim_tolerance = signal_tolerance;
+        return result;
     }
 
-    ExpandingSearcher searcher(trim_tolerance, signal_tolerance);
+    const auto finest = *std::max_element(signal_tolerances.begin(), signal_tolerances.end());
+    if (trim_tolerance < finest)
+    {
+        trim_tolerance = finest;
+    }
+
+    ExpandingSearcher searcher(trim_tolerance, finest, start_depth);
     searcher.search_interval(arg, predicate);
 
-    return std::move(searcher).result();
+    /*
+     * A level coarser than the first depth of the search starts at its own
+     * signal tolerance instead, so is not a stage of the finest search and is
+     * searched separately. These searches are a single layer deep.
+     */
+    const auto first_depth = searcher.start_depth(arg);
+    const auto& found_by_depth = searcher.m_found_by_depth;
+    for (std::size_t i = 0; i < signal_tolerances.size(); ++i)
+    {
+        const auto level = signal_tolerances[i];
+        if (level < first_depth)
+        {
+            result[i] = segment(arg, predicate, level, trim_tolerance, start_depth);
+            continue;
+        }
+
+        const auto pass = static_cast<std::size_t>(level - first_depth);
+        const auto count = pass < found_by_depth.size() ? found_by_depth[pass] : searcher.m_found.size();
+        result[i].assign(searcher.m_found.begin(), searcher.m_found.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+
+    return result;
+}
+
+dyadic_interval segments::probe_coordinates(const interval& probe) noexcept
+{
+    depth_t expo;
+    std::frexp(probe.sup() - probe.inf(), &expo);
+    const depth_t depth = 1 - expo;
+    return {static_cast<mult_t>(std::ldexp(probe.inf(), depth)), depth};
 }
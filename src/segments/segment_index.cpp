@@ -0,0 +1,165 @@
+#include "segment_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+
+using namespace segments;
+
+
+namespace
+{
+    constexpr std::size_t min_chunk_size = std::size_t(1) << 16;
+
+    /*
+     * Run fn(begin, end) over contiguous chunks of [0, count), using up to
+     * threads threads. Small batches are processed on the calling thread.
+     */
+    template <typename Fn>
+    void parallel_chunks(std::size_t count, unsigned threads, Fn&& fn)
+    {
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        const auto chunks = std::min<std::size_t>(threads, (count + min_chunk_size - 1) / min_chunk_size);
+        if (chunks <= 1)
+        {
+            fn(std::size_t(0), count);
+            return;
+        }
+
+        const auto chunk = (count + chunks - 1) / chunks;
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for (std::size_t begin = chunk; begin < count; begin += chunk)
+        {
+            const auto end = std::min(count, begin + chunk);
+            workers.emplace_back([&fn, begin, end] { fn(begin, end); });
+        }
+        fn(std::size_t(0), chunk);
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    /*
+     * The index of the last element of data that is not greater than x, or
+     * -1 if there is no such element. The loop body compiles to a conditional
+     * move rather than a branch, so the cost does not depend on how
+     * predictable the queries are.
+     */
+    inline std::ptrdiff_t last_not_greater(const double* data, std::size_t size, double x) noexcept
+    {
+        if (size == 0)
+        {
+            return -1;
+        }
+
+        const double* base = data;
+        for (std::size_t n = size; n > 1;)
+        {
+            const auto half = n / 2;
+            base = (base[half] <= x) ? base + half : base;
+            n -= half;
+        }
+        return (base - data) + static_cast<std::ptrdiff_t>(*base <= x) - 1;
+    }
+}
+
+
+SegmentIndex::SegmentIndex(std::vector<interval> segments)
+{
+    std::sort(segments.begin(), segments.end(), [](const interval& lhs, const interval& rhs) {
+        return lhs.inf() < rhs.inf();
+    });
+
+    m_infs.reserve(segments.size());
+    m_sups.reserve(segments.size());
+    for (const auto& seg : segments)
+    {
+        if (!m_sups.empty() && seg.inf() < m_sups.back())
+        {
+            throw std::invalid_argument("segments in an index must not overlap");
+        }
+        m_infs.push_back(seg.inf());
+        m_sups.push_back(seg.sup());
+    }
+}
+
+std::ptrdiff_t SegmentIndex::locate(double point) const noexcept
+{
+    const auto idx = last_not_greater(m_infs.data(), m_infs.size(), point);
+    return (idx >= 0 && point < m_sups[idx]) ? idx : npos;
+}
+
+std::pair<std::size_t, std::size_t> SegmentIndex::overlapping(const interval& arg) const noexcept
+{
+    const auto first = std::upper_bound(m_sups.begin(), m_sups.end(), arg.inf()) - m_sups.begin();
+    const auto last = std::lower_bound(m_infs.begin(), m_infs.end(), arg.sup()) - m_infs.begin();
+    return {static_cast<std::size_t>(first), static_cast<std::size_t>(std::max(first, last))};
+}
+
+void SegmentIndex::locate(const double* points, std::size_t count, std::ptrdiff_t* out, unsigned threads) const
+{
+    if (std::is_sorted(points, points + count))
+    {
+        locate_sorted(points, count, out, threads);
+    }
+    else
+    {
+        locate_unsorted(points, count, out, threads);
+    }
+}
+
+void SegmentIndex::locate_sorted(const double* points, std::size_t count, std::ptrdiff_t* out, unsigned threads) const
+{
+    const auto* infs = m_infs.data();
+    const auto* sups = m_sups.data();
+    const auto size = static_cast<std::ptrdiff_t>(m_infs.size());
+
+    parallel_chunks(count, threads, [=](std::size_t begin, std::size_t end) {
+        if (begin == end)
+        {
+            return;
+        }
+
+        auto idx = last_not_greater(infs, size, points[begin]);
+        for (auto i = begin; i < end; ++i)
+        {
+            const auto point = points[i];
+            while (idx + 1 < size && infs[idx + 1] <= point)
+            {
+                ++idx;
+            }
+            out[i] = (idx >= 0 && point < sups[idx]) ? idx : npos;
+        }
+    });
+}
+
+void SegmentIndex::locate_unsorted(const double* points, std::size_t count, std::ptrdiff_t* out, unsigned threads) const
+{
+    parallel_chunks(count, threads, [=](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            out[i] = locate(points[i]);
+        }
+    });
+}
+
+void SegmentIndex::overlapping(const double* infs, const double* sups, std::size_t count,
+                               std::size_t* first, std::size_t* last, unsigned threads) const
+{
+    parallel_chunks(count, threads, [=](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            auto range = overlapping(interval(infs[i], sups[i]));
+            first[i] = range.first;
+            last[i] = range.second;
+        }
+    });
+}
@@ -0,0 +1,52 @@
+#ifndef SEGMENTS_SEGMENT_INDEX_H
+#define SEGMENTS_SEGMENT_INDEX_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace segments {
+
+/// An index over the (disjoint) intervals returned by segment that answers
+/// point-stabbing and range-overlap queries in batches.
+///
+/// The segments are stored sorted by position, and indices returned by the
+/// queries refer to this sorted order. Batched queries use a merge pass when
+/// the query points are sorted and a branch-free binary search otherwise,
+/// and are split across threads when the batch is large.
+class SegmentIndex {
+    std::vector<double> m_infs;
+    std::vector<double> m_sups;
+
+public:
+    static constexpr std::ptrdiff_t npos = -1;
+
+    explicit SegmentIndex(std::vector<interval> segments);
+
+    std::size_t size() const noexcept { return m_infs.size(); }
+    bool empty() const noexcept { return m_infs.empty(); }
+    interval operator[](std::size_t idx) const { return {m_infs[idx], m_sups[idx]}; }
+
+    /// The index of the segment containing point, or npos if there is none.
+    std::ptrdiff_t locate(double point) const noexcept;
+
+    /// The indices [first, last) of the segments that overlap the interval arg.
+    std::pair<std::size_t, std::size_t> overlapping(const interval& arg) const noexcept;
+
+    /// Locate every point in points, writing the results to out.
+    /// If threads is 0 the number of hardware threads is used.
+    void locate(const double* points, std::size_t count, std::ptrdiff_t* out, unsigned threads = 0) const;
+    void locate_sorted(const double* points, std::size_t count, std::ptrdiff_t* out, unsigned threads = 0) const;
+    void locate_unsorted(const double* points, std::size_t count, std::ptrdiff_t* out, unsigned threads = 0) const;
+
+    /// Find the overlapping range of segments for each of the intervals
+    /// [infs[i], sups[i]).
+    void overlapping(const double* infs, const double* sups, std::size_t count,
+                     std::size_t* first, std::size_t* last, unsigned threads = 0) const;
+};
+
+} // namespace segments
+
+#endif //SEGMENTS_SEGMENT_INDEX_H
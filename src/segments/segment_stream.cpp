@@ -0,0 +1,96 @@
+#include "segment_stream.h"
+
+#include <algorithm>
+#include <utility>
+
+
+using namespace segments;
+
+
+SegmentStream::SegmentStream(interval arg, predicate_t predicate, depth_t signal_tolerance, depth_t trim_tolerance,
+                             depth_t start_depth)
+    : m_searcher(std::max(trim_tolerance, signal_tolerance), signal_tolerance, start_depth),
+      m_predicate(std::move(predicate))
+{
+    m_pending.push_back({arg, m_searcher.start_depth(arg), false, true, false});
+}
+
+/*
+ * Each part of the base interval is searched exactly as the batch search
+ * would search it, one depth at a time and stopping at each segment found,
+ * so the results are the same; only the order in which the parts are
+ * visited differs.
+ */
+void SegmentStream::search_front()
+{
+    using scan_outcome = ExpandingSearcher::scan_outcome;
+
+    auto item = m_pending.begin();
+    const auto depth = item->depth;
+
+    // A predicate that threw out of an earlier call can leave pieces of an
+    // unfinished expansion behind; the item itself is only updated once its
+    // scan completes, so it is searched again from the start.
+    m_searcher.m_forward_expansion.clear();
+    m_searcher.m_backward_expansion.clear();
+    m_searcher.m_found.clear();
+    m_searcher.m_found_dyadic.clear();
+
+    auto& components = m_searcher.m_search_components;
+    components.assign(1, item->span);
+    auto component = components.begin();
+
+    auto from = item->resume ? ExpandingSearcher::resume_point(item->span, depth)
+                             : dyadic_interval(item->span.inf(), depth);
+    auto outcome = item->first_layer ? m_searcher.scan_first_layer(component, from, depth, m_predicate)
+                                     : m_searcher.scan_layer(component, from, depth, m_predicate);
+
+    if (outcome == scan_outcome::finished)
+    {
+        if (depth < m_searcher.m_signal_tol)
+        {
+            *item = {item->span, depth + 1, false, false, false};
+        }
+        else
+        {
+            m_pending.erase(item);
+        }
+        return;
+    }
+
+    // The scanned component is still in the list, preceded by the part to
+    // the left of the new segment if there is one.
+    if (components.size() == 2 && depth < m_searcher.m_signal_tol)
+    {
+        m_pending.insert(item, {components.front(), depth + 1, false, false, false});
+    }
+    m_pending.insert(item, {m_searcher.m_found.back(), depth, true, false, false});
+
+    if (outcome == scan_outcome::found)
+    {
+        *item = {components.back(), depth, false, item->first_layer, true};
+    }
+    else
+    {
+        m_pending.erase(item);
+    }
+
+    m_searcher.m_found.clear();
+    m_searcher.m_found_dyadic.clear();
+}
+
+bool SegmentStream::next(interval& segment)
+{
+    while (!m_pending.empty())
+    {
+        auto& front = m_pending.front();
+        if (front.is_segment)
+        {
+            segment = front.span;
+            m_pending.pop_front();
+            return true;
+        }
+        search_front();
+    }
+    return false;
+}
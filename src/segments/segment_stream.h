@@ -0,0 +1,85 @@
+#ifndef SEGMENTS_SEGMENT_STREAM_H
+#define SEGMENTS_SEGMENT_STREAM_H
+
+#include "segments.h"
+#include "expanding_searcher.h"
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+
+namespace segments {
+
+/// A lazy search that produces the segments of a base interval in order of
+/// position.
+///
+/// The segments are the same as those found by segment. Rather than
+/// searching all of the base interval one depth at a time, the stream always
+/// works on the leftmost part that is still to be searched, taking it
+/// through every depth before moving right. A segment is produced as soon as
+/// there is nothing left to search to its left, so the first results arrive
+/// early and only the segments that are waiting on the search to their left
+/// are held in memory.
+class SegmentStream {
+    struct pending {
+        interval span;
+        depth_t depth;
+        bool is_segment;
+        bool first_layer;
+        bool resume;
+    };
+
+    ExpandingSearcher m_searcher;
+    predicate_t m_predicate;
+    std::list<pending> m_pending;
+
+    void search_front();
+
+public:
+    SegmentStream(interval arg, predicate_t predicate, depth_t signal_tolerance, depth_t trim_tolerance=0,
+                  depth_t start_depth=0);
+
+    /// Search until the next segment is settled, writing it to segment.
+    /// Returns false once every segment has been produced. An exception
+    /// thrown by the predicate propagates, and a later call searches the
+    /// interrupted part again.
+    bool next(interval& segment);
+
+    class iterator {
+        SegmentStream* m_stream = nullptr;
+        interval m_current{0.0, 0.0};
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = interval;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const interval*;
+        using reference = const interval&;
+
+        iterator() = default;
+        explicit iterator(SegmentStream* stream) : m_stream(stream) { ++*this; }
+
+        reference operator*() const noexcept { return m_current; }
+        pointer operator->() const noexcept { return &m_current; }
+
+        iterator& operator++()
+        {
+            if (!m_stream->next(m_current)) {
+                m_stream = nullptr;
+            }
+            return *this;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) noexcept
+        { return lhs.m_stream == rhs.m_stream; }
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) noexcept
+        { return lhs.m_stream != rhs.m_stream; }
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() noexcept { return {}; }
+};
+
+} // namespace segments
+
+#endif //SEGMENTS_SEGMENT_STREAM_H
@@ -6,6 +6,9 @@
 #define SEGMENTS_SEGMENTS_H
 
 
+#include <cstddef>
+#include <limits>
+#include <optional>
 #include <vector>
 
 #include "dyadic.h"
@@ -21,8 +24,77 @@ using dyadic_interval = basic_dyadic_interval<clopen, dyadic>;
 
 using predicate_t = std::function<bool(const interval&)>;
 
+/// A predicate receiving each probe as the dyadic coordinates (k, n) of the
+/// interval [k/2^n, (k+1)/2^n), without conversion to floating point.
+using dyadic_predicate_t = std::function<bool(mult_t k, depth_t n)>;
 
-std::vector<interval> segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance=0);
+/// A segment described by its exact dyadic endpoints, each in lowest terms.
+struct dyadic_segment {
+    dyadic inf;
+    dyadic sup;
+};
+
+/// Passing this as the start depth begins the search at the coarsest
+/// dyadic level whose intervals are no longer than the base interval. They
+/// need not be aligned with it, so the first and last probes may overhang
+/// its ends.
+constexpr depth_t adaptive_start_depth = std::numeric_limits<depth_t>::min();
+
+
+std::vector<interval> segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance=0,
+                              depth_t start_depth=0);
+
+/// As segment, with a predicate taking the dyadic coordinates of each probe.
+std::vector<interval> segment(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                              depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// As segment, but returning the exact dyadic endpoints of each segment.
+/// Each endpoint is the endpoint of the segment rounded outwards to the
+/// dyadic grid at the trim tolerance. Only an endpoint clipped to a bound of
+/// arg that is off that grid moves, to the grid point just outside arg.
+std::vector<dyadic_segment> segment_dyadic(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                                           depth_t trim_tolerance=0, depth_t start_depth=0);
+std::vector<dyadic_segment> segment_dyadic(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                                           depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// Whether segment would find any segment. The search stops at the first
+/// probe on which the predicate holds.
+bool any_segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance, depth_t trim_tolerance=0,
+                 depth_t start_depth=0);
+bool any_segment(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                 depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// The leftmost of the segments segment would find, if there are any. Once a
+/// segment is found, only the part of arg to its left is searched further.
+std::optional<interval> first_segment(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                                      depth_t trim_tolerance=0, depth_t start_depth=0);
+std::optional<interval> first_segment(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                                      depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// The number of segments segment would find, without storing them.
+std::size_t count_segments(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                           depth_t trim_tolerance=0, depth_t start_depth=0);
+std::size_t count_segments(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                           depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// The total length of the segments segment would find, without storing them.
+double segment_measure(interval arg, const predicate_t& predicate, depth_t signal_tolerance,
+                       depth_t trim_tolerance=0, depth_t start_depth=0);
+double segment_measure(interval arg, const dyadic_predicate_t& predicate, depth_t signal_tolerance,
+                       depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// The results of segment for each of signal_tolerances, computed from a
+/// single search to the finest of them. Every level uses the same trim
+/// tolerance, which is at least the finest signal tolerance, so that each is
+/// a stage of the finest search. Results are in the order of
+/// signal_tolerances.
+std::vector<std::vector<interval>> segment_pyramid(interval arg, const predicate_t& predicate,
+                                                   const std::vector<depth_t>& signal_tolerances,
+                                                   depth_t trim_tolerance=0, depth_t start_depth=0);
+
+/// Recover the dyadic coordinates of an interval passed to a predicate
+/// during a search. Every probe is a dyadic interval, so this is exact.
+dyadic_interval probe_coordinates(const interval& probe) noexcept;
 
 
 } // namespace segments
@@ -0,0 +1,190 @@
+#include "sharding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "expanding_searcher.h"
+
+
+using namespace segments;
+
+
+namespace
+{
+    /*
+     * A part of a segment that lies past a cut and contains no dyadic
+     * interval at the signal tolerance is never detected by the search of
+     * that shard. The search of the whole base interval would have reached it
+     * by expanding the segment, which reaches the largest point on the trim
+     * grid that the segment covers; these walk to the same point one level
+     * at a time.
+     */
+    double extend_right(double from, double bound, const predicate_t& predicate,
+                        depth_t signal_tol, depth_t trim_tol)
+    {
+        for (depth_t depth = signal_tol + 1; depth <= trim_tol; ++depth)
+        {
+            dyadic_interval di(from, depth);
+            if (di.sup() <= bound && predicate(di))
+            {
+                from = di.sup();
+            }
+        }
+        return from;
+    }
+
+    double extend_left(double from, double bound, const predicate_t& predicate,
+                       depth_t signal_tol, depth_t trim_tol)
+    {
+        for (depth_t depth = signal_tol + 1; depth <= trim_tol; ++depth)
+        {
+            dyadic_interval di(from, depth);
+            --di;
+            if (di.inf() >= bound && predicate(di))
+            {
+                from = di.inf();
+            }
+        }
+        return from;
+    }
+
+    /// The first point at or after point on the grid at depth.
+    double grid_ceil(double point, depth_t depth)
+    {
+        dyadic_interval di(point, depth);
+        return (di.inf() < point) ? static_cast<double>(di.sup()) : static_cast<double>(di.inf());
+    }
+
+    /*
+     * How the search clips a segment running off the start of the base
+     * interval depends on the depth at which the segment is first detected,
+     * and when the segment spans several shards the first shard alone cannot
+     * tell what that depth is. Rather than model the clipping, the start of
+     * the base is searched again up to the end of the first dyadic interval
+     * at the start depth that lies inside the segment. The search of the
+     * whole base probes the same intervals to the left of that point, so
+     * this gives exactly its segments there.
+     */
+    void clip_to_base(const shard_plan& plan, std::vector<interval>& stitched, const predicate_t& predicate)
+    {
+        const auto inf = plan.base.inf();
+        const auto trim_inf = grid_ceil(inf, plan.trim_tolerance);
+        if (trim_inf == inf)
+        {
+            return;
+        }
+
+        const auto cut = plan.shards.front().sup();
+        auto first = std::find_if(stitched.begin(), stitched.end(), [cut](const interval& found) {
+            return found.sup() > cut;
+        });
+        if (first == stitched.end() || first->inf() > trim_inf)
+        {
+            return;
+        }
+
+        const auto sup = first->sup();
+        const auto head_sup = std::min(sup, grid_ceil(inf, plan.start_depth) + std::ldexp(1.0, -plan.start_depth));
+        auto head = segment(interval(inf, head_sup), predicate, plan.signal_tolerance, plan.trim_tolerance,
+                            plan.start_depth);
+        std::sort(head.begin(), head.end(), [](const interval& lhs, const interval& rhs) {
+            return lhs.inf() < rhs.inf();
+        });
+        if (head.empty() || head.back().sup() != head_sup)
+        {
+            return;
+        }
+
+        head.back() = interval(head.back().inf(), sup);
+        stitched.erase(stitched.begin(), first + 1);
+        stitched.insert(stitched.begin(), head.begin(), head.end());
+    }
+}
+
+
+shard_plan segments::plan_shards(interval arg, std::size_t count, depth_t signal_tolerance, depth_t trim_tolerance,
+                                 depth_t start_depth)
+{
+    if (count == 0)
+    {
+        throw std::invalid_argument("the number of shards must be positive");
+    }
+
+    ExpandingSearcher searcher(std::max(trim_tolerance, signal_tolerance), signal_tolerance, start_depth);
+    shard_plan plan{arg, {}, searcher.m_signal_tol, searcher.m_trim_tol, searcher.start_depth(arg)};
+
+    const auto first = std::floor(std::ldexp(arg.inf(), plan.start_depth));
+    const auto blocks = std::ceil(std::ldexp(arg.sup(), plan.start_depth)) - first;
+
+    auto inf = arg.inf();
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        auto cut = std::ldexp(first + std::floor(blocks * static_cast<double>(i) / static_cast<double>(count)),
+                              -plan.start_depth);
+        if (inf < cut && cut < arg.sup())
+        {
+            plan.shards.emplace_back(inf, cut);
+            inf = cut;
+        }
+    }
+    plan.shards.emplace_back(inf, arg.sup());
+
+    return plan;
+}
+
+std::vector<interval> segments::segment_shard(const shard_plan& plan, std::size_t shard, const predicate_t& predicate)
+{
+    return segment(plan.shards.at(shard), predicate, plan.signal_tolerance, plan.trim_tolerance, plan.start_depth);
+}
+
+std::vector<interval> segments::stitch_shards(const shard_plan& plan,
+                                              const std::vector<std::vector<interval>>& results,
+                                              const predicate_t& predicate)
+{
+    if (results.size() != plan.shards.size())
+    {
+        throw std::invalid_argument("expected one result for each shard of the plan");
+    }
+
+    std::vector<interval> stitched;
+    for (std::size_t shard = 0; shard < results.size(); ++shard)
+    {
+        const auto& bounds = plan.shards[shard];
+        auto found = results[shard];
+        std::sort(found.begin(), found.end(), [](const interval& lhs, const interval& rhs) {
+            return lhs.inf() < rhs.inf();
+        });
+
+        const bool open_left = !stitched.empty() && stitched.back().sup() == bounds.inf();
+        const bool meets_left = !found.empty() && found.front().inf() == bounds.inf();
+
+        if (open_left && !meets_left)
+        {
+            auto& last = stitched.back();
+            auto sup = found.empty() ? bounds.sup() : found.front().inf();
+            last = interval(last.inf(), extend_right(last.sup(), sup, predicate,
+                                                     plan.signal_tolerance, plan.trim_tolerance));
+        }
+        else if (meets_left && shard > 0 && !open_left)
+        {
+            auto inf = stitched.empty() ? plan.shards[shard - 1].inf()
+                                        : std::max(stitched.back().sup(), plan.shards[shard - 1].inf());
+            auto& first = found.front();
+            first = interval(extend_left(first.inf(), inf, predicate,
+                                         plan.signal_tolerance, plan.trim_tolerance), first.sup());
+        }
+
+        auto it = found.begin();
+        if (open_left && meets_left)
+        {
+            auto& last = stitched.back();
+            last = interval(last.inf(), it->sup());
+            ++it;
+        }
+        stitched.insert(stitched.end(), it, found.end());
+    }
+
+    clip_to_base(plan, stitched, predicate);
+    return stitched;
+}
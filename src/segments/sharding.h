@@ -0,0 +1,61 @@
+#ifndef SEGMENTS_SHARDING_H
+#define SEGMENTS_SHARDING_H
+
+#include "segments.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace segments {
+
+/*
+ * Sharding splits one long segmentation into independent searches that can
+ * run in separate processes or on separate machines.
+ *
+ * The base interval is cut at multiples of 2^-d, where d is the depth at
+ * which the search starts, so no dyadic interval probed by the search ever
+ * straddles a cut. Each shard is then searched with segment using the
+ * tolerances and start depth in the plan, and stitch_shards joins segments
+ * that meet at a cut. A segment that crosses a cut but is only detected on
+ * one side is extended across the cut by probing the predicate at the trim
+ * tolerance, so the stitched result is the result segment would give for the
+ * whole base interval.
+ *
+ * That holds when the predicate picks out a union of runs: it is true on an
+ * interval exactly when the interval lies inside one of a fixed set of
+ * disjoint intervals. Other predicates, even ones that are true on every
+ * sub-interval of an interval on which they are true, can be split
+ * differently near a cut, since the search couples the two sides of a cut
+ * through the components it keeps. The stitched segments are then still
+ * sorted, disjoint and made of dyadic intervals on which the predicate is
+ * true, but need not be those segment would give.
+ */
+
+struct shard_plan {
+    interval base;
+    std::vector<interval> shards;
+    depth_t signal_tolerance;
+    depth_t trim_tolerance;
+    depth_t start_depth;
+};
+
+/// Split arg into at most count shards with dyadic-aligned boundaries. The
+/// start depth of the plan is always a concrete depth, even if
+/// adaptive_start_depth was requested, so that every shard starts the search
+/// at the same level.
+shard_plan plan_shards(interval arg, std::size_t count, depth_t signal_tolerance, depth_t trim_tolerance=0,
+                       depth_t start_depth=0);
+
+/// Run segment on a single shard of plan.
+std::vector<interval> segment_shard(const shard_plan& plan, std::size_t shard, const predicate_t& predicate);
+
+/// Join the results of searching each shard of plan, in shard order, into
+/// the segments of the base interval, sorted by position. The result matches
+/// segment on the base interval for union-of-runs predicates only.
+std::vector<interval> stitch_shards(const shard_plan& plan,
+                                    const std::vector<std::vector<interval>>& results,
+                                    const predicate_t& predicate);
+
+} // namespace segments
+
+#endif //SEGMENTS_SHARDING_H
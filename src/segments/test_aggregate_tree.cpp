@@ -0,0 +1,125 @@
+#include "aggregate_tree.h"
+
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+struct concat_monoid {
+    using value_type = std::string;
+    value_type identity() const { return {}; }
+    value_type combine(const value_type& left, const value_type& right) const { return left + right; }
+};
+
+struct samples {
+    std::vector<double> positions;
+    std::vector<double> values;
+};
+
+samples make_samples(std::size_t count)
+{
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<double> gap(0.0, 0.02);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    samples result;
+    double position = -3.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        position += gap(rng);
+        result.positions.push_back(position);
+        result.values.push_back(std::sin(position) + noise(rng));
+    }
+    return result;
+}
+
+moments brute_force(const samples& data, const interval& probe)
+{
+    moments_monoid monoid;
+    moments result;
+    for (std::size_t i = 0; i < data.positions.size(); ++i) {
+        if (probe.inf() <= data.positions[i] && data.positions[i] < probe.sup()) {
+            result = monoid.combine(result, moments(data.values[i]));
+        }
+    }
+    return result;
+}
+
+}
+
+
+TEST(aggregate_tree_tests, moments_match_brute_force)
+{
+    auto data = make_samples(2000);
+    std::vector<moments> lifted(data.values.begin(), data.values.end());
+    AggregateTree<moments_monoid> tree(data.positions, lifted, 6);
+
+    for (depth_t n = -4; n <= 8; ++n) {
+        for (mult_t k = -4 * (1 << std::max(n, 0)); k <= 20 * (1 << std::max(n, 0)); ++k) {
+            const dyadic_interval block(k, n);
+            const auto expected = brute_force(data, interval(block));
+            const auto found = tree.query(block);
+            ASSERT_EQ(found.count, expected.count) << k << ' ' << n;
+            if (expected.count != 0.0) {
+                EXPECT_EQ(found.min, expected.min);
+                EXPECT_EQ(found.max, expected.max);
+                EXPECT_NEAR(found.mean, expected.mean, 1e-9);
+                EXPECT_NEAR(found.variance(), expected.variance(), 1e-9);
+            }
+        }
+    }
+}
+
+TEST(aggregate_tree_tests, combine_preserves_order)
+{
+    AggregateTree<concat_monoid> tree({0.0, 0.25, 0.5, 0.75, 1.5}, {"a", "b", "c", "d", "e"}, 2);
+
+    EXPECT_EQ(tree.query(dyadic_interval(0, 0)), "abcd");
+    EXPECT_EQ(tree.query(dyadic_interval(0, -1)), "abcde");
+    EXPECT_EQ(tree.query(dyadic_interval(0, -10)), "abcde");
+    EXPECT_EQ(tree.query(dyadic_interval(1, 1)), "cd");
+    EXPECT_EQ(tree.query(dyadic_interval(6, 3)), "d");
+    EXPECT_EQ(tree.query(dyadic_interval(12, 3)), "e");
+    EXPECT_EQ(tree.query(dyadic_interval(7, 3)), "");
+    EXPECT_EQ(tree.query(dyadic_interval(-1, 0)), "");
+}
+
+TEST(aggregate_tree_tests, predicate_search_matches_brute_force)
+{
+    auto data = make_samples(5000);
+    AggregateTree<max_monoid<>> max_tree(data.positions, data.values, 8);
+
+    // The max of an empty probe is -inf, so both accept probes between
+    // samples.
+    auto brute = [&data](const interval& probe) {
+        return brute_force(data, probe).max <= 0.5;
+    };
+    auto fast = max_tree.predicate([](double max) { return max <= 0.5; });
+
+    const interval base(data.positions.front(), data.positions.back());
+    auto expected = segment(base, brute, 10);
+    auto found = segment(base, fast, 10);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+}
+
+TEST(aggregate_tree_tests, sum_and_min)
+{
+    AggregateTree<sum_monoid<>> sums({-0.5, 0.1, 0.2}, {1.0, 2.0, 4.0}, 0);
+    EXPECT_EQ(sums.query(dyadic_interval(0, 0)), 6.0);
+    EXPECT_EQ(sums.query(dyadic_interval(-1, 0)), 1.0);
+    EXPECT_EQ(sums.query(dyadic_interval(0, 3)), 2.0);
+
+    AggregateTree<min_monoid<>> mins({}, {}, 4);
+    EXPECT_EQ(mins.query(dyadic_interval(0, 0)), INFINITY);
+
+    EXPECT_THROW(AggregateTree<sum_monoid<>>({1.0, 0.0}, {1.0, 1.0}, 0), std::invalid_argument);
+    EXPECT_THROW(AggregateTree<sum_monoid<>>({0.0}, {1.0, 1.0}, 0), std::invalid_argument);
+}
@@ -0,0 +1,185 @@
+#include "batch_segmentation.h"
+#include "run_segmentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+struct test_window {
+    interval base;
+    std::vector<double> values;
+};
+
+std::vector<test_window> make_signal_windows(std::size_t count)
+{
+    std::mt19937 rng(2718);
+    std::uniform_real_distribution<double> offset(-50.0, 50.0);
+    std::uniform_int_distribution<std::size_t> length(1, 400);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    std::vector<test_window> windows;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto inf = offset(rng);
+        test_window window{interval(inf, inf + 1.0 + double(i % 5)), {}};
+        const auto samples = length(rng);
+        for (std::size_t j = 0; j < samples; ++j) {
+            window.values.push_back(std::sin(0.05 * double(j)) + noise(rng));
+        }
+        windows.push_back(std::move(window));
+    }
+    return windows;
+}
+
+std::string write_input(const std::vector<test_window>& windows, const std::string& name)
+{
+    auto path = testing::TempDir() + name;
+    BatchInputWriter writer(path);
+    for (const auto& window : windows) {
+        writer.add(window.base, window.values.data(), window.values.size());
+    }
+    writer.finish();
+    return path;
+}
+
+std::vector<std::vector<interval>> run_batch(const std::string& input_path,
+                                             const window_predicate_t& predicate,
+                                             const batch_options& options,
+                                             const std::string& name)
+{
+    BatchInput input(input_path);
+    const auto output_path = testing::TempDir() + name;
+    {
+        BatchOutputWriter output(output_path, input.size());
+        auto totals = segment_batch(input, predicate, options, output);
+        EXPECT_EQ(totals.windows, input.size());
+    }
+    return read_batch_output(output_path);
+}
+
+void expect_same(const std::vector<interval>& found, const std::vector<interval>& expected)
+{
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+}
+
+}
+
+
+TEST(BatchSegmentation, InputRoundTrips)
+{
+    auto windows = make_signal_windows(20);
+    windows[3].values.clear();
+    BatchInput input(write_input(windows, "batch_round_trip.bin"));
+
+    ASSERT_EQ(input.size(), windows.size());
+    for (std::size_t i = 0; i < windows.size(); ++i) {
+        const auto window = input[i];
+        EXPECT_EQ(window.base.inf(), windows[i].base.inf());
+        EXPECT_EQ(window.base.sup(), windows[i].base.sup());
+        ASSERT_EQ(window.count, windows[i].values.size());
+        EXPECT_TRUE(std::equal(window.values, window.values + window.count, windows[i].values.begin()));
+    }
+}
+
+TEST(BatchSegmentation, ThresholdMatchesSegment)
+{
+    const auto windows = make_signal_windows(300);
+    const auto path = write_input(windows, "batch_threshold.bin");
+    const auto predicate = threshold_predicate(-0.5, 0.5);
+
+    batch_options options{6, 8};
+    options.threads = 4;
+    options.chunk_size = 7;
+    const auto found = run_batch(path, predicate, options, "batch_threshold.out");
+
+    ASSERT_EQ(found.size(), windows.size());
+    for (std::size_t i = 0; i < windows.size(); ++i) {
+        const batch_window window{windows[i].base, windows[i].values.data(), windows[i].values.size()};
+        expect_same(found[i], segment(windows[i].base, predicate(window), 6, 8));
+    }
+}
+
+TEST(BatchSegmentation, ThresholdPlacesValuesAcrossWindow)
+{
+    const std::vector<double> values{1.0, 0.0, 0.0, 1.0};
+    const batch_window window{interval(0.0, 4.0), values.data(), values.size()};
+    const auto predicate = threshold_predicate(0.5, 2.0)(window);
+
+    EXPECT_TRUE(predicate(interval(0.0, 1.0)));
+    EXPECT_FALSE(predicate(interval(0.0, 2.0)));
+    EXPECT_TRUE(predicate(interval(2.5, 4.0)));
+    EXPECT_FALSE(predicate(interval(3.25, 3.5)));
+}
+
+TEST(BatchSegmentation, RunsMatchSegmentRuns)
+{
+    std::vector<test_window> windows;
+    for (int i = 0; i < 50; ++i) {
+        const double inf = 10.0 * i;
+        windows.push_back({interval(inf, inf + 10.0), {inf + 0.3, inf + 4.1, inf + 2.2, inf + 9.0}});
+    }
+    const auto path = write_input(windows, "batch_runs.bin");
+
+    batch_options options{8};
+    options.threads = 3;
+    const auto found = run_batch(path, run_predicate(), options, "batch_runs.out");
+
+    ASSERT_EQ(found.size(), windows.size());
+    for (std::size_t i = 0; i < windows.size(); ++i) {
+        const auto& values = windows[i].values;
+        RunSet runs(values.data(), values.data() + 2, 2);
+        expect_same(found[i], segment_runs(windows[i].base, runs, 8));
+    }
+}
+
+TEST(BatchSegmentation, ReportsProgress)
+{
+    const auto windows = make_signal_windows(64);
+    BatchInput input(write_input(windows, "batch_progress.bin"));
+    BatchOutputWriter output(testing::TempDir() + "batch_progress.out", input.size());
+
+    batch_options options{4};
+    options.threads = 2;
+    options.chunk_size = 4;
+    std::vector<batch_progress> reports;
+    segment_batch(input, threshold_predicate(-0.5, 0.5), options, output, [&reports](const batch_progress& report) {
+        reports.push_back(report);
+    }, std::chrono::seconds(0));
+
+    ASSERT_FALSE(reports.empty());
+    EXPECT_EQ(reports.back().windows, windows.size());
+    for (std::size_t i = 1; i < reports.size(); ++i) {
+        EXPECT_LE(reports[i - 1].windows, reports[i].windows);
+    }
+}
+
+TEST(BatchSegmentation, PropagatesErrors)
+{
+    std::vector<test_window> windows{{interval(0.0, 1.0), {0.25, 0.5, 0.75}}};
+    BatchInput input(write_input(windows, "batch_error.bin"));
+    BatchOutputWriter output(testing::TempDir() + "batch_error.out", input.size());
+
+    EXPECT_THROW(segment_batch(input, run_predicate(), batch_options{4}, output), std::invalid_argument);
+}
+
+TEST(BatchSegmentation, RejectsOtherFiles)
+{
+    const auto path = testing::TempDir() + "batch_not_input.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "this is not a batch input file";
+    }
+    EXPECT_THROW(BatchInput input(path), std::runtime_error);
+    EXPECT_THROW(read_batch_output(path), std::runtime_error);
+}
@@ -0,0 +1,145 @@
+#include "bottom_up.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+bool multiple_intervals(double inf, double sup)
+{
+    return (inf >= 0.234 && sup <= 0.9523)
+            || (inf >= 1.042 && sup <= 1.093)
+            || (inf >= 2.852 && sup <= 3.401)
+            || (inf >= 6.013 && sup <= 6.521);
+}
+
+template <typename Predicate>
+batch_predicate_t batched(Predicate predicate, std::size_t* evaluations = nullptr)
+{
+    return [predicate, evaluations](const double* infs, const double* sups, std::size_t count, bool* results) {
+        for (std::size_t i = 0; i < count; ++i) {
+            results[i] = predicate(infs[i], sups[i]);
+        }
+        if (evaluations != nullptr) {
+            *evaluations += count;
+        }
+    };
+}
+
+void expect_same(const std::vector<interval>& found, const std::vector<interval>& expected)
+{
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf()) << i;
+        EXPECT_EQ(found[i].sup(), expected[i].sup()) << i;
+    }
+}
+
+}
+
+
+TEST(bottom_up_tests, matches_segment)
+{
+    auto predicate = [](const interval& arg) { return multiple_intervals(arg.inf(), arg.sup()); };
+
+    for (depth_t signal : {2, 5, 8}) {
+        for (depth_t trim : {0, 8, 12}) {
+            const interval base(-0.3, 10.0);
+            expect_same(segment_bottom_up(base, batched(multiple_intervals), signal, trim, 0, 1000),
+                        segment(base, predicate, signal, trim));
+            expect_same(segment_bottom_up(base, batched(multiple_intervals), signal, trim, adaptive_start_depth),
+                        segment(base, predicate, signal, trim, adaptive_start_depth));
+        }
+    }
+}
+
+TEST(bottom_up_tests, matches_segment_on_random_runs)
+{
+    // Random runs aligned to an odd grid give ragged segment ends.
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<double> gap(0.0, 0.3);
+    std::vector<std::pair<double, double>> runs;
+    for (double position = 0.0; position < 20.0;) {
+        const double start = position + gap(rng);
+        const double end = start + gap(rng);
+        runs.emplace_back(start, end);
+        position = end;
+    }
+
+    auto inside = [&runs](double inf, double sup) {
+        for (const auto& run : runs) {
+            if (run.first <= inf && sup <= run.second) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto predicate = [&inside](const interval& arg) { return inside(arg.inf(), arg.sup()); };
+
+    const interval base(0.1, 19.7);
+    std::size_t evaluations = 0;
+    auto found = segment_bottom_up(base, batched(inside, &evaluations), 6, 10);
+    expect_same(found, segment(base, predicate, 6, 10));
+    // Runs reaching an end of base are followed at most one unit probe past it.
+    EXPECT_GE(double(evaluations), bottom_up_evaluations(base, 6, 10));
+    EXPECT_LE(double(evaluations), bottom_up_evaluations(base, 6, 10) + 2 * 1024);
+}
+
+TEST(bottom_up_tests, runs_overhanging_the_base)
+{
+    auto check = [](const interval& base, std::vector<std::pair<double, double>> runs,
+                    depth_t signal, depth_t trim, depth_t start) {
+        auto inside = [&runs](double inf, double sup) {
+            return std::any_of(runs.begin(), runs.end(), [inf, sup](const std::pair<double, double>& run) {
+                return run.first <= inf && sup <= run.second;
+            });
+        };
+        auto predicate = [&inside](const interval& arg) { return inside(arg.inf(), arg.sup()); };
+        expect_same(segment_bottom_up(base, batched(inside), signal, trim, start, 64),
+                    segment(base, predicate, signal, trim, start));
+    };
+
+    check(interval(-0.34516506570207994, 6.8412563690088639), {{-0.6986, 0.8584}}, 8, 11, 3);
+
+    std::mt19937 rng(4242);
+    std::uniform_int_distribution<depth_t> signal_dist(0, 8);
+    std::uniform_int_distribution<depth_t> extra_trim_dist(0, 4);
+    std::uniform_real_distribution<double> overhang(0.0, 2.0);
+    std::uniform_real_distribution<double> gap(0.0, 1.0);
+    const depth_t starts[] = {0, 3, -1, adaptive_start_depth};
+
+    for (int trial = 0; trial < 500; ++trial) {
+        const interval base(std::uniform_real_distribution<double>(-3.0, 1.0)(rng),
+                            std::uniform_real_distribution<double>(4.0, 20.0)(rng));
+        std::vector<std::pair<double, double>> runs;
+        double position = base.inf() - overhang(rng);
+        runs.emplace_back(position, base.inf() + overhang(rng));
+        for (position = runs.back().second + gap(rng); position < base.sup() - 1.0; position += gap(rng)) {
+            runs.emplace_back(position, position + gap(rng));
+            position = runs.back().second;
+        }
+        runs.emplace_back(std::max(position, base.sup() - overhang(rng)), base.sup() + overhang(rng));
+
+        const auto signal = signal_dist(rng);
+        SCOPED_TRACE(trial);
+        check(base, runs, signal, signal + extra_trim_dist(rng), starts[trial % 4]);
+    }
+}
+
+TEST(bottom_up_tests, engine_choice)
+{
+    const interval base(0.0, 100.0);
+
+    EXPECT_EQ(choose_engine(base, 8, 8), search_engine::bottom_up);
+    EXPECT_EQ(choose_engine(base, 4, 16), search_engine::top_down);
+    EXPECT_EQ(choose_engine(base, 4, 16, 1e6), search_engine::bottom_up);
+
+    auto predicate = [](const interval& arg) { return multiple_intervals(arg.inf(), arg.sup()); };
+    expect_same(segment_auto(base, batched(multiple_intervals), 8, 8), segment(base, predicate, 8, 8));
+    expect_same(segment_auto(base, batched(multiple_intervals), 4, 16), segment(base, predicate, 4, 16));
+}
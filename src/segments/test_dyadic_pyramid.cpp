@@ -0,0 +1,158 @@
+#include "dyadic_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+constexpr depth_t resolution = 10;
+constexpr mult_t first_cell = -37;
+
+std::vector<double> make_samples(std::size_t count)
+{
+    std::mt19937 rng(12345);
+    std::normal_distribution<double> noise(0.0, 0.05);
+    std::vector<double> samples;
+    for (std::size_t i = 0; i < count; ++i) {
+        samples.push_back(std::sin(0.003 * double(i)) + noise(rng));
+    }
+    return samples;
+}
+
+std::string build(const std::vector<double>& samples, const std::string& name)
+{
+    auto path = testing::TempDir() + name;
+    PyramidBuilder builder(path, resolution, first_cell, samples.size());
+    builder.append(samples.data(), samples.size());
+    builder.finish();
+    return path;
+}
+
+block_summary brute_force(const std::vector<double>& samples, const dyadic_interval& block)
+{
+    // Sample i is in the block when its cell first_cell + i lies in
+    // [ceil(inf * 2^resolution), ceil(sup * 2^resolution)).
+    const interval ivl(block);
+    const auto begin = std::ceil(std::ldexp(ivl.inf(), resolution)) - double(first_cell);
+    const auto end = std::ceil(std::ldexp(ivl.sup(), resolution)) - double(first_cell);
+    const auto lo = static_cast<std::size_t>(std::clamp(begin, 0.0, double(samples.size())));
+    const auto hi = static_cast<std::size_t>(std::clamp(end, 0.0, double(samples.size())));
+
+    block_summary result{INFINITY, -INFINITY, 0.0, 0};
+    for (std::size_t i = lo; i < hi; ++i) {
+        result.min = std::min(result.min, samples[i]);
+        result.max = std::max(result.max, samples[i]);
+        result.sum += samples[i];
+        ++result.count;
+    }
+    return result;
+}
+
+}
+
+
+TEST(dyadic_pyramid_tests, summaries_match_brute_force)
+{
+    auto samples = make_samples(10000);
+    DyadicPyramid pyramid(build(samples, "segments_summaries.pyramid"));
+
+    EXPECT_EQ(pyramid.resolution(), resolution);
+    EXPECT_EQ(pyramid.first_cell(), first_cell);
+    EXPECT_EQ(pyramid.sample_count(), samples.size());
+
+    for (depth_t n = -6; n <= resolution + 3; ++n) {
+        const auto lo = static_cast<mult_t>(std::floor(std::ldexp(-0.1, n))) - 1;
+        const auto hi = static_cast<mult_t>(std::ceil(std::ldexp(10.0, n))) + 1;
+        const auto step = std::max(1, (hi - lo) / 500);
+        for (mult_t k = lo; k <= hi; k += step) {
+            const dyadic_interval block(k, n);
+            const auto expected = brute_force(samples, block);
+            const auto found = pyramid.summary(block);
+            ASSERT_EQ(found.count, expected.count) << k << ' ' << n;
+            if (expected.count != 0) {
+                EXPECT_EQ(found.min, expected.min);
+                EXPECT_EQ(found.max, expected.max);
+                EXPECT_NEAR(found.sum, expected.sum, 1e-9 * double(expected.count));
+            }
+        }
+    }
+}
+
+TEST(dyadic_pyramid_tests, threshold_search_matches_brute_force)
+{
+    auto samples = make_samples(10000);
+    DyadicPyramid pyramid(build(samples, "segments_search.pyramid"));
+
+    auto brute = [&samples](const interval& probe) {
+        auto found = brute_force(samples, probe_coordinates(probe));
+        return found.count != 0 && 0.2 <= found.min && found.max <= 0.8;
+    };
+
+    auto expected = segment(interval(-1.0, 12.0), brute, 12);
+    auto found = segment(interval(-1.0, 12.0), pyramid.within(0.2, 0.8), 12);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+}
+
+TEST(dyadic_pyramid_tests, single_sample)
+{
+    std::vector<double> samples{4.0};
+    DyadicPyramid pyramid(build(samples, "segments_single.pyramid"));
+
+    EXPECT_EQ(pyramid.levels(), 7);
+    EXPECT_EQ(pyramid.summary(dyadic_interval(first_cell, resolution)).count, 1);
+    EXPECT_EQ(pyramid.summary(dyadic_interval(2 * first_cell, resolution + 1)).count, 1);
+    EXPECT_EQ(pyramid.summary(dyadic_interval(2 * first_cell + 1, resolution + 1)).count, 0);
+    EXPECT_EQ(pyramid.summary(dyadic_interval(-1, 0)).max, 4.0);
+    EXPECT_TRUE(pyramid.summary(dyadic_interval(0, 0)).empty());
+}
+
+TEST(dyadic_pyramid_tests, errors)
+{
+    auto path = testing::TempDir() + "segments_errors.pyramid";
+    EXPECT_THROW(PyramidBuilder(path, resolution, 0, 0), std::invalid_argument);
+    EXPECT_THROW(PyramidBuilder(path, resolution, std::numeric_limits<mult_t>::max(), 1), std::invalid_argument);
+    EXPECT_THROW(PyramidBuilder(path, resolution, std::int64_t(std::numeric_limits<mult_t>::min()) - 1, 1),
+                 std::invalid_argument);
+    EXPECT_THROW(PyramidBuilder(path, resolution, 0, std::uint64_t(1) << 31), std::invalid_argument);
+    EXPECT_NO_THROW(PyramidBuilder(path, resolution, std::numeric_limits<mult_t>::max() - 1, 1));
+
+    {
+        PyramidBuilder builder(path, resolution, 0, 2);
+        builder.append(1.0);
+        EXPECT_THROW(builder.finish(), std::logic_error);
+        builder.append(2.0);
+        EXPECT_THROW(builder.append(3.0), std::logic_error);
+        builder.finish();
+    }
+    EXPECT_NO_THROW(DyadicPyramid{path});
+
+    {
+        // Move the samples of the pyramid beyond the cells a search can probe.
+        std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+        const std::int64_t far_cell = std::int64_t(1) << 40;
+        out.seekp(16);
+        out.write(reinterpret_cast<const char*>(&far_cell), sizeof(far_cell));
+    }
+    EXPECT_THROW(DyadicPyramid{path}, std::runtime_error);
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "not a pyramid at all, but long enough to hold a header of 64 bytes";
+    }
+    EXPECT_THROW(DyadicPyramid{path}, std::runtime_error);
+    EXPECT_THROW(DyadicPyramid{testing::TempDir() + "segments_missing.pyramid"}, std::runtime_error);
+}
@@ -0,0 +1,147 @@
+#include "expression.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+
+TEST(expression_tests, readme_example)
+{
+    Expression expr("inf >= 0.3 and sup <= 0.752");
+
+    EXPECT_TRUE(expr(interval(0.5, 0.75)));
+    EXPECT_FALSE(expr(interval(0.25, 0.5)));
+    EXPECT_FALSE(expr(interval(0.5, 1.0)));
+
+    auto found = segment(interval(-5.0, 5.0), expr.predicate(), 2);
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(found[0].inf(), 0.5);
+    EXPECT_EQ(found[0].sup(), 0.75);
+}
+
+TEST(expression_tests, arithmetic_precedence)
+{
+    Expression expr("1 + 2 * 3 - -4 / 2 == 9 and abs(inf - sup) == length and 2 * (1 + 1) == 4");
+    EXPECT_TRUE(expr(interval(0.0, 0.5)));
+}
+
+TEST(expression_tests, logic_and_chained_comparisons)
+{
+    Expression expr("not (0 <= inf < sup <= 1) or length > 4");
+
+    EXPECT_FALSE(expr(interval(0.0, 1.0)));
+    EXPECT_TRUE(expr(interval(0.5, 1.5)));
+    EXPECT_TRUE(expr(interval(-8.0, -1.0)));
+}
+
+TEST(expression_tests, constants)
+{
+    Expression expr("inf >= lo and sup <= hi");
+    EXPECT_EQ(expr.names(), (std::vector<std::string>{"lo", "hi"}));
+    EXPECT_THROW(expr(interval(0.0, 1.0)), std::logic_error);
+
+    expr.bind("lo", 0.25);
+    expr.bind("hi", 0.75);
+    EXPECT_TRUE(expr(interval(0.25, 0.5)));
+    EXPECT_FALSE(expr(interval(0.0, 0.5)));
+
+    auto snapshot = expr.predicate();
+    expr.bind("lo", 0.0);
+    EXPECT_FALSE(snapshot(interval(0.0, 0.5)));
+    EXPECT_TRUE(expr(interval(0.0, 0.5)));
+}
+
+TEST(expression_tests, aggregates)
+{
+    std::vector<double> positions{0.0, 0.25, 0.5, 0.75, 1.0, 1.25, 1.5};
+    std::vector<double> values{3.0, 1.0, 4.0, 1.0, 5.0, 9.0, 2.0};
+
+    Expression expr("count(x) == 3 and min(x) == 1 and max(x) == 4 and sum(x) == 6 and mean(x) == 2");
+    expr.bind("x", positions, values);
+    EXPECT_TRUE(expr(interval(0.25, 1.0)));
+    EXPECT_FALSE(expr(interval(0.0, 0.75)));
+
+    Expression range("max(x) - min(x) <= 3");
+    range.bind("x", positions, values);
+    EXPECT_TRUE(range(interval(0.0, 1.0)));
+    EXPECT_FALSE(range(interval(0.0, 1.5)));
+    // The min and max of an empty range are NaN, so comparisons are false.
+    EXPECT_FALSE(range(interval(2.0, 3.0)));
+
+    Expression empty("count(x) == 0");
+    empty.bind("x", positions, values);
+    EXPECT_TRUE(empty(interval(0.1, 0.2)));
+}
+
+TEST(expression_tests, aggregate_matches_brute_force)
+{
+    std::vector<double> positions, values;
+    for (int i = 0; i < 1000; ++i) {
+        positions.push_back(0.01 * i);
+        values.push_back(std::sin(0.37 * i) + 0.1 * (i % 7));
+    }
+
+    Expression expr("max(x) - min(x) <= 1.2");
+    expr.bind("x", positions, values);
+    auto predicate = [&](const interval& arg) {
+        double lo = INFINITY, hi = -INFINITY;
+        bool any = false;
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            if (arg.inf() <= positions[i] && positions[i] < arg.sup()) {
+                lo = std::min(lo, values[i]);
+                hi = std::max(hi, values[i]);
+                any = true;
+            }
+        }
+        return any && hi - lo <= 1.2;
+    };
+
+    auto found = segment(interval(0.0, 10.0), expr.predicate(), 8);
+    auto expected = segment(interval(0.0, 10.0), predicate, 8);
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+}
+
+TEST(expression_tests, errors)
+{
+    EXPECT_THROW(Expression("inf >="), std::invalid_argument);
+    EXPECT_THROW(Expression("(inf > 0"), std::invalid_argument);
+    EXPECT_THROW(Expression("inf > 0 sup"), std::invalid_argument);
+    EXPECT_THROW(Expression("min(1)"), std::invalid_argument);
+    EXPECT_THROW(Expression("inf $ 0"), std::invalid_argument);
+
+    Expression expr("min(x) > y");
+    EXPECT_THROW(expr.bind("z", 1.0), std::invalid_argument);
+    EXPECT_THROW(expr.bind("x", {1.0, 0.0}, {1.0, 2.0}), std::invalid_argument);
+    expr.bind("x", 1.0);
+    expr.bind("y", 1.0);
+    EXPECT_THROW(expr.predicate(), std::logic_error);
+}
+
+TEST(expression_tests, nesting_is_limited)
+{
+    const std::size_t deep = 100000;
+    EXPECT_THROW(Expression(std::string(deep, '(') + "inf" + std::string(deep, ')') + " > 0"), std::invalid_argument);
+
+    std::string negations;
+    std::string minuses;
+    std::string sum = "1";
+    for (std::size_t i = 0; i < deep; ++i) {
+        negations += "not ";
+        minuses += "- ";
+        sum += " + 1";
+    }
+    EXPECT_THROW(Expression(negations + "inf > 0"), std::invalid_argument);
+    EXPECT_THROW(Expression(minuses + "inf > 0"), std::invalid_argument);
+    EXPECT_THROW(Expression(sum + " > 0"), std::invalid_argument);
+
+    Expression shallow(std::string(50, '(') + "inf" + std::string(50, ')') + " >= 0");
+    EXPECT_TRUE(shallow.predicate()(interval(0.0, 1.0)));
+}
@@ -0,0 +1,141 @@
+#include "predicate_cache.h"
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+bool multiple_intervals(const interval& arg)
+{
+    return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+            || (arg.inf() >= 1.042 && arg.sup() <= 1.093)
+            || (arg.inf() >= 2.852 && arg.sup() <= 3.401)
+            || (arg.inf() >= 6.013 && arg.sup() <= 6.521);
+}
+
+void expect_same(const std::vector<interval>& result, const std::vector<interval>& expected)
+{
+    ASSERT_EQ(result.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(result[i].inf(), expected[i].inf());
+        EXPECT_EQ(result[i].sup(), expected[i].sup());
+    }
+}
+
+}
+
+
+TEST(predicate_cache_tests, cached_search_matches_uncached)
+{
+    PredicateCache cache(1 << 16);
+    auto predicate = cached_predicate(cache, multiple_intervals);
+
+    expect_same(segment(interval(0.0, 10.0), predicate, 8, 10),
+                segment(interval(0.0, 10.0), multiple_intervals, 8, 10));
+    EXPECT_EQ(cache.size(), cache.misses());
+}
+
+TEST(predicate_cache_tests, overlapping_windows_hit_the_cache)
+{
+    PredicateCache cache(1 << 16);
+    int evaluations = 0;
+    auto predicate = cached_predicate(cache, [&evaluations](const interval& arg) {
+        ++evaluations;
+        return multiple_intervals(arg);
+    });
+    int probes = 0;
+    auto counting = [&probes](const interval& arg) {
+        ++probes;
+        return multiple_intervals(arg);
+    };
+
+    for (int step = 0; step < 8; ++step) {
+        const interval window(0.25 * step, 0.25 * step + 4.0);
+        evaluations = 0;
+        probes = 0;
+        expect_same(segment(window, predicate, 8, 10), segment(window, counting, 8, 10));
+        if (step > 0) {
+            EXPECT_LT(4 * evaluations, probes);
+        }
+    }
+    EXPECT_GT(cache.hits(), cache.misses());
+}
+
+TEST(predicate_cache_tests, lru_evicts_least_recently_used)
+{
+    PredicateCache cache(2, PredicateCache::eviction_policy::lru);
+    cache.insert({0, 0}, true);
+    cache.insert({1, 0}, false);
+
+    ASSERT_TRUE(cache.lookup({0, 0}).has_value());
+    cache.insert({2, 0}, true);
+
+    EXPECT_TRUE(cache.lookup({0, 0}).has_value());
+    EXPECT_FALSE(cache.lookup({1, 0}).has_value());
+    EXPECT_EQ(*cache.lookup({2, 0}), true);
+    EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(predicate_cache_tests, fifo_evicts_first_inserted)
+{
+    PredicateCache cache(2, PredicateCache::eviction_policy::fifo);
+    cache.insert({0, 0}, true);
+    cache.insert({1, 0}, false);
+
+    ASSERT_TRUE(cache.lookup({0, 0}).has_value());
+    cache.insert({2, 0}, true);
+
+    EXPECT_FALSE(cache.lookup({0, 0}).has_value());
+    EXPECT_EQ(*cache.lookup({1, 0}), false);
+    EXPECT_EQ(*cache.lookup({2, 0}), true);
+}
+
+TEST(predicate_cache_tests, invalidate_region)
+{
+    PredicateCache cache(16);
+    cache.insert({0, 1}, true);     // [0, 0.5)
+    cache.insert({1, 1}, true);     // [0.5, 1)
+    cache.insert({3, 2}, true);     // [0.75, 1)
+    cache.insert({-1, 0}, true);    // [-1, 0)
+
+    cache.invalidate(interval(0.5, 0.8));
+    EXPECT_TRUE(cache.lookup({0, 1}).has_value());
+    EXPECT_FALSE(cache.lookup({1, 1}).has_value());
+    EXPECT_FALSE(cache.lookup({3, 2}).has_value());
+    EXPECT_TRUE(cache.lookup({-1, 0}).has_value());
+
+    cache.invalidate();
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(predicate_cache_tests, shared_between_threads)
+{
+    PredicateCache cache(1 << 12);
+    auto predicate = cached_predicate(cache, multiple_intervals);
+    const auto expected = segment(interval(0.0, 10.0), multiple_intervals, 8, 10);
+
+    std::vector<std::vector<interval>> results(4);
+    std::vector<std::thread> threads;
+    for (auto& result : results) {
+        threads.emplace_back([&result, &predicate] {
+            result = segment(interval(0.0, 10.0), predicate, 8, 10);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& result : results) {
+        expect_same(result, expected);
+    }
+}
+
+TEST(predicate_cache_tests, zero_capacity_throws)
+{
+    EXPECT_THROW(PredicateCache(0), std::invalid_argument);
+}
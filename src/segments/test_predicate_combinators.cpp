@@ -0,0 +1,94 @@
+#include "predicate_combinators.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+bool multiple_intervals(const interval& arg)
+{
+    return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+            || (arg.inf() >= 1.042 && arg.sup() <= 1.093)
+            || (arg.inf() >= 2.852 && arg.sup() <= 3.401)
+            || (arg.inf() >= 6.013 && arg.sup() <= 6.521);
+}
+
+bool left_half(const interval& arg)
+{
+    return arg.sup() <= 5.0;
+}
+
+bool slow_true(const interval&)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+    return true;
+}
+
+void expect_same(const std::vector<interval>& result, const std::vector<interval>& expected)
+{
+    ASSERT_EQ(result.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(result[i].inf(), expected[i].inf());
+        EXPECT_EQ(result[i].sup(), expected[i].sup());
+    }
+}
+
+}
+
+
+TEST(predicate_combinator_tests, all_of_matches_conjunction)
+{
+    auto combined = all_of({multiple_intervals, negate(left_half)}, 8);
+    auto expected = segment(interval(0.0, 10.0), [](const interval& arg) {
+        return multiple_intervals(arg) && !left_half(arg);
+    }, 8, 10);
+
+    expect_same(segment(interval(0.0, 10.0), combined, 8, 10), expected);
+}
+
+TEST(predicate_combinator_tests, any_of_matches_disjunction)
+{
+    auto combined = any_of({left_half, multiple_intervals}, 8);
+    auto expected = segment(interval(0.0, 10.0), [](const interval& arg) {
+        return left_half(arg) || multiple_intervals(arg);
+    }, 8, 10);
+
+    expect_same(segment(interval(0.0, 10.0), combined, 8, 10), expected);
+}
+
+TEST(predicate_combinator_tests, cheap_selective_check_moves_first)
+{
+    AdaptivePredicate combined(AdaptivePredicate::combine_mode::all_of, {slow_true, multiple_intervals}, 16);
+    EXPECT_EQ(combined.order()[0], 0);
+
+    for (int i = 0; i < 64; ++i) {
+        combined(interval(0.125 * i, 0.125 * (i + 1)));
+    }
+
+    EXPECT_EQ(combined.order()[0], 1);
+    EXPECT_LT(combined.stats(0).calls, 64);
+    EXPECT_EQ(combined.stats(1).calls, 64);
+    EXPECT_GT(combined.stats(0).mean_cost, combined.stats(1).mean_cost);
+}
+
+TEST(predicate_combinator_tests, short_circuits)
+{
+    AdaptivePredicate combined(AdaptivePredicate::combine_mode::any_of, {left_half, multiple_intervals});
+
+    EXPECT_TRUE(combined(interval(0.0, 1.0)));
+    EXPECT_EQ(combined.stats(1).calls, 0);
+    EXPECT_TRUE(combined(interval(6.25, 6.5)));
+    EXPECT_FALSE(combined(interval(8.0, 9.0)));
+    EXPECT_EQ(combined.stats(1).calls, 2);
+    EXPECT_EQ(combined.stats(1).decisive, 1);
+}
+
+TEST(predicate_combinator_tests, empty_throws)
+{
+    EXPECT_THROW(all_of({}), std::invalid_argument);
+}
@@ -0,0 +1,92 @@
+#include "predicate_trace.h"
+
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+bool multiple_intervals(const interval& arg)
+{
+    return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+            || (arg.inf() >= 1.042 && arg.sup() <= 1.093)
+            || (arg.inf() >= 2.852 && arg.sup() <= 3.401)
+            || (arg.inf() >= 6.013 && arg.sup() <= 6.521);
+}
+
+}
+
+
+TEST(predicate_trace_tests, probe_coordinates_are_exact)
+{
+    dyadic_interval di(-13, 5);
+    auto coords = probe_coordinates(interval(di));
+
+    EXPECT_EQ(coords.k, -13);
+    EXPECT_EQ(coords.n, 5);
+
+    coords = probe_coordinates(interval(8.0, 12.0));
+    EXPECT_EQ(coords.k, 2);
+    EXPECT_EQ(coords.n, -2);
+}
+
+TEST(predicate_trace_tests, replay_reproduces_search)
+{
+    auto path = testing::TempDir() + "segments_replay.trace";
+    int probes = 0;
+    auto counting = [&probes](const interval& arg) {
+        ++probes;
+        return multiple_intervals(arg);
+    };
+
+    auto expected = record_segment(path, interval(0.0, 10.0), counting, 8, 10);
+
+    TraceReplay replay(path);
+    EXPECT_EQ(replay.header().base.sup(), 10.0);
+    EXPECT_EQ(replay.header().signal_tolerance, 8);
+    EXPECT_EQ(replay.header().trim_tolerance, 10);
+    EXPECT_EQ(replay.records().size(), probes);
+
+    auto replayed = replay_segment(replay);
+    ASSERT_EQ(replayed.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(replayed[i].inf(), expected[i].inf());
+        EXPECT_EQ(replayed[i].sup(), expected[i].sup());
+    }
+}
+
+TEST(predicate_trace_tests, diverging_search_throws)
+{
+    const trace_header header{interval(0.0, 1.0), 2, 2, 0};
+    auto path = testing::TempDir() + "segments_diverging.trace";
+    {
+        TraceWriter writer(path, header);
+        writer.write(dyadic_interval(1, 20), true);
+        writer.flush();
+    }
+    EXPECT_THROW(replay_segment(TraceReplay(path)), std::runtime_error);
+
+    auto short_path = testing::TempDir() + "segments_short.trace";
+    record_segment(path, interval(0.0, 1.0), multiple_intervals, 2);
+    {
+        TraceReplay full(path);
+        TraceWriter writer(short_path, header);
+        writer.write(dyadic_interval(full.records()[0].k, full.records()[0].n), full.records()[0].result);
+        writer.flush();
+    }
+    EXPECT_THROW(replay_segment(TraceReplay(short_path)), std::runtime_error);
+
+    auto long_path = testing::TempDir() + "segments_long.trace";
+    {
+        TraceReplay full(path);
+        TraceWriter writer(long_path, header);
+        for (const auto& rec : full.records()) {
+            writer.write(dyadic_interval(rec.k, rec.n), rec.result);
+        }
+        writer.write(dyadic_interval(0, 0), false);
+        writer.flush();
+    }
+    EXPECT_THROW(replay_segment(TraceReplay(long_path)), std::runtime_error);
+}
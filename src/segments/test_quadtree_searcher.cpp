@@ -0,0 +1,133 @@
+#include "quadtree_searcher.h"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+double area(const std::vector<rectangle>& rects)
+{
+    double total = 0.0;
+    for (const auto& rect : rects) {
+        total += (rect.x.sup() - rect.x.inf()) * (rect.y.sup() - rect.y.inf());
+    }
+    return total;
+}
+
+bool disjoint(const rectangle& lhs, const rectangle& rhs)
+{
+    return lhs.x.sup() <= rhs.x.inf() || rhs.x.sup() <= lhs.x.inf()
+           || lhs.y.sup() <= rhs.y.inf() || rhs.y.sup() <= lhs.y.inf();
+}
+
+}
+
+
+TEST(quadtree_tests, children_partition_parent)
+{
+    dyadic_rectangle cell(3, -2, 2);
+    for (const auto& child : cell.children()) {
+        EXPECT_EQ(child.depth(), 3);
+        EXPECT_EQ(child.parent(), cell);
+    }
+}
+
+TEST(quadtree_tests, negative_predicate_checks_every_cell_once)
+{
+    int probes = 0;
+    auto predicate = [&probes](const rectangle&) {
+        ++probes;
+        return false;
+    };
+
+    auto found = segment2d({interval(0, 1), interval(0, 1)}, predicate, 3);
+
+    EXPECT_TRUE(found.empty());
+    EXPECT_EQ(probes, 1 + 4 + 16 + 64);
+}
+
+TEST(quadtree_tests, aligned_square_is_found_exactly)
+{
+    auto predicate = [](const rectangle& rect) {
+        return rect.x.inf() >= 0.25 && rect.x.sup() <= 0.75
+               && rect.y.inf() >= 0.5 && rect.y.sup() <= 1.0;
+    };
+
+    auto found = segment2d({interval(0, 1), interval(0, 1)}, predicate, 4);
+
+    EXPECT_EQ(found.size(), 4);
+    EXPECT_DOUBLE_EQ(area(found), 0.25);
+}
+
+TEST(quadtree_tests, disk_is_covered_from_inside)
+{
+    const double radius = 0.3;
+    auto inside = [radius](double x, double y) {
+        return (x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5) <= radius * radius;
+    };
+    auto predicate = [&inside](const rectangle& rect) {
+        return inside(rect.x.inf(), rect.y.inf()) && inside(rect.x.sup(), rect.y.inf())
+               && inside(rect.x.inf(), rect.y.sup()) && inside(rect.x.sup(), rect.y.sup());
+    };
+    const rectangle base{interval(0, 1), interval(0, 1)};
+    const double disk_area = M_PI * radius * radius;
+
+    auto coarse = segment2d(base, predicate, 5);
+    auto trimmed = segment2d(base, predicate, 5, 8);
+
+    for (std::size_t i = 0; i < trimmed.size(); ++i) {
+        ASSERT_TRUE(predicate(trimmed[i]));
+        for (std::size_t j = i + 1; j < trimmed.size(); ++j) {
+            ASSERT_TRUE(disjoint(trimmed[i], trimmed[j]));
+        }
+    }
+
+    EXPECT_LT(area(coarse), disk_area);
+    EXPECT_LT(area(coarse), area(trimmed));
+    EXPECT_LT(area(trimmed), disk_area);
+    EXPECT_GT(area(trimmed), 0.95 * disk_area);
+}
+
+TEST(quadtree_tests, result_is_clipped_to_base)
+{
+    auto predicate = [](const rectangle&) { return true; };
+    const rectangle base{interval(0.1, 0.7), interval(-0.2, 0.3)};
+
+    auto found = segment2d(base, predicate, 2);
+
+    EXPECT_DOUBLE_EQ(area(found), 0.6 * 0.5);
+    for (const auto& rect : found) {
+        EXPECT_GE(rect.x.inf(), 0.1);
+        EXPECT_LE(rect.x.sup(), 0.7);
+        EXPECT_GE(rect.y.inf(), -0.2);
+        EXPECT_LE(rect.y.sup(), 0.3);
+    }
+}
+
+TEST(quadtree_tests, batched_matches_scalar)
+{
+    auto predicate = [](const rectangle& rect) {
+        return rect.x.inf() >= 0.1 && rect.x.sup() <= 0.83 && rect.y.inf() >= 0.27 && rect.y.sup() <= 0.6;
+    };
+    std::size_t batches = 0;
+    auto batched = [&predicate, &batches](const rectangle* cells, std::size_t count, bool* results) {
+        ++batches;
+        for (std::size_t i = 0; i < count; ++i) {
+            results[i] = predicate(cells[i]);
+        }
+    };
+    const rectangle base{interval(0, 1), interval(0, 1)};
+
+    auto expected = segment2d(base, predicate, 4, 6);
+    auto found = segment2d_batched(base, batched, 4, 6);
+
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].x.inf(), expected[i].x.inf());
+        EXPECT_EQ(found[i].y.inf(), expected[i].y.inf());
+    }
+    EXPECT_LE(batches, 7);
+}
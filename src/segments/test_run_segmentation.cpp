@@ -0,0 +1,133 @@
+#include "run_segmentation.h"
+
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+void expect_same(const std::vector<interval>& result, const std::vector<interval>& expected)
+{
+    ASSERT_EQ(result.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(result[i].inf(), expected[i].inf());
+        EXPECT_EQ(result[i].sup(), expected[i].sup());
+    }
+}
+
+std::vector<interval> sorted(std::vector<interval> ivls)
+{
+    std::sort(ivls.begin(), ivls.end(), [](const interval& lhs, const interval& rhs) {
+        return lhs.inf() < rhs.inf();
+    });
+    return ivls;
+}
+
+RunSet random_runs(std::mt19937& rng, double inf, double sup, int count)
+{
+    std::uniform_real_distribution<double> point(inf, sup);
+    std::uniform_int_distribution<int> coarse(0, 64);
+    std::bernoulli_distribution use_grid(0.3);
+
+    std::vector<double> ends;
+    for (int i = 0; i < 2 * count; ++i) {
+        // Mix dyadic and arbitrary endpoints, since runs that start or end
+        // on the grid exercise different branches of the search.
+        ends.push_back(use_grid(rng) ? inf + (sup - inf) * coarse(rng) / 64.0 : point(rng));
+    }
+    std::sort(ends.begin(), ends.end());
+
+    std::vector<double> starts, finishes;
+    for (int i = 0; i < count; ++i) {
+        starts.push_back(ends[2 * i]);
+        finishes.push_back(ends[2 * i + 1]);
+    }
+    return {starts.data(), finishes.data(), starts.size()};
+}
+
+}
+
+
+TEST(run_segmentation_tests, matches_segment_on_bm_intervals)
+{
+    std::vector<interval> runs{
+            {0.234, 0.9523}, {1.042, 1.093}, {1.252, 1.301}, {1.354, 2.252}, {2.852, 3.401},
+            {3.405, 3.509}, {3.791, 4.411}, {4.925, 5.995}, {6.013, 6.521}, {6.525, 6.599},
+            {7.354, 8.023}, {8.154, 8.832}, {9.021, 9.411}
+    };
+    RunSet set(runs);
+
+    for (depth_t tol = 0; tol <= 16; ++tol) {
+        expect_same(segment_runs(interval(0.0, 10.0), set, tol, tol + 2),
+                    segment(interval(0.0, 10.0), set, tol, tol + 2));
+    }
+}
+
+TEST(run_segmentation_tests, matches_segment_on_random_runs)
+{
+    std::mt19937 rng(20261018);
+    std::uniform_real_distribution<double> endpoint(-3.0, 3.0);
+    std::uniform_int_distribution<int> tolerance(0, 10);
+    std::uniform_int_distribution<int> extra(0, 4);
+    std::uniform_int_distribution<int> start(-3, 2);
+    std::uniform_int_distribution<int> run_count(0, 12);
+
+    for (int trial = 0; trial < 2000; ++trial) {
+        double inf = endpoint(rng), sup = endpoint(rng);
+        if (sup - inf < 0.01) {
+            continue;
+        }
+
+        auto runs = random_runs(rng, inf - 0.5, sup + 0.5, run_count(rng));
+        const auto signal = tolerance(rng);
+        const auto trim = signal + extra(rng);
+        const auto first = trial % 3 == 0 ? adaptive_start_depth : start(rng);
+
+        expect_same(segment_runs(interval(inf, sup), runs, signal, trim, first),
+                    segment(interval(inf, sup), runs, signal, trim, first));
+        if (HasFailure()) {
+            FAIL() << "trial " << trial << " [" << inf << ", " << sup << ") tol " << signal << "/" << trim;
+        }
+    }
+}
+
+TEST(run_segmentation_tests, parallel_matches_sorted_segment)
+{
+    std::mt19937 rng(42);
+    auto runs = random_runs(rng, 0.0, 1000.0, 20000);
+
+    expect_same(segment_runs_parallel(interval(0.0, 1000.0), runs, 6, 12, 0, 4),
+                sorted(segment(interval(0.0, 1000.0), runs, 6, 12)));
+}
+
+TEST(run_segmentation_tests, long_base_without_scanning)
+{
+    std::vector<interval> runs{{7.0e4 + 0.3, 7.0e4 + 2.7}};
+    RunSet set(runs);
+    int probes = 0;
+    auto counting = [&probes, &set](const interval& arg) {
+        ++probes;
+        return set(arg);
+    };
+
+    expect_same(segment_runs(interval(0.0, 1.0e5), set, 10, 14),
+                segment(interval(0.0, 1.0e5), counting, 10, 14));
+    EXPECT_GT(probes, 100000);
+}
+
+TEST(run_segmentation_tests, merges_and_validates_runs)
+{
+    std::vector<double> starts{0.0, 0.5, 0.75, 2.0};
+    std::vector<double> ends{0.5, 0.8, 1.0, 2.0};
+    RunSet set(starts.data(), ends.data(), starts.size());
+
+    EXPECT_EQ(set.size(), 1);
+    EXPECT_TRUE(set.contains(interval(0.25, 1.0)));
+    EXPECT_FALSE(set.contains(interval(0.5, 1.5)));
+
+    std::vector<double> unsorted{1.0, 0.0};
+    EXPECT_THROW(RunSet(unsorted.data(), ends.data(), 2), std::invalid_argument);
+}
@@ -0,0 +1,106 @@
+#include "sample_grid.h"
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+bool multiple_intervals(const interval& arg)
+{
+    return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+            || (arg.inf() >= 1.042 && arg.sup() <= 1.093)
+            || (arg.inf() >= 2.852 && arg.sup() <= 3.401)
+            || (arg.inf() >= 6.013 && arg.sup() <= 6.521);
+}
+
+}
+
+
+TEST(sample_grid_tests, dyadic_predicate_matches_interval_predicate)
+{
+    int calls = 0;
+    dyadic_predicate_t dyadic = [&calls](mult_t k, depth_t n) {
+        ++calls;
+        return multiple_intervals(interval(dyadic_interval(k, n)));
+    };
+
+    auto expected = segment(interval(0.0, 10.0), multiple_intervals, 8, 12);
+    auto found = segment(interval(0.0, 10.0), dyadic, 8, 12);
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+    EXPECT_GT(calls, 0);
+
+    auto expected_dyadic = segment_dyadic(interval(0.0, 10.0), multiple_intervals, 8);
+    auto found_dyadic = segment_dyadic(interval(0.0, 10.0), dyadic, 8);
+    ASSERT_EQ(found_dyadic.size(), expected_dyadic.size());
+    for (std::size_t i = 0; i < found_dyadic.size(); ++i) {
+        EXPECT_EQ(found_dyadic[i].inf.k, expected_dyadic[i].inf.k);
+        EXPECT_EQ(found_dyadic[i].sup.n, expected_dyadic[i].sup.n);
+    }
+}
+
+TEST(sample_grid_tests, samples_match_positions)
+{
+    const sample_grid grid{6, -45, 300};
+
+    for (depth_t n = -3; n <= 9; ++n) {
+        for (mult_t k = -70; k <= 70; ++k) {
+            const interval ivl(dyadic_interval(k, n));
+            std::size_t begin = grid.count, end = 0;
+            for (std::size_t i = 0; i < grid.count; ++i) {
+                const double position = std::ldexp(double(grid.first_cell + std::int64_t(i)), -grid.resolution);
+                if (ivl.inf() <= position && position < ivl.sup()) {
+                    begin = std::min(begin, i);
+                    end = i + 1;
+                }
+            }
+            auto range = grid.samples(k, n);
+            if (end == 0) {
+                EXPECT_EQ(range.first, range.second) << k << ' ' << n;
+            } else {
+                EXPECT_EQ(range.first, begin) << k << ' ' << n;
+                EXPECT_EQ(range.second, end) << k << ' ' << n;
+            }
+        }
+    }
+
+    auto far = grid.samples(1 << 30, -40);
+    EXPECT_EQ(far.first, far.second);
+    auto everything = grid.samples(-1, -40);
+    EXPECT_EQ(everything.first, 0);
+    EXPECT_EQ(everything.second, 45);
+}
+
+TEST(sample_grid_tests, grid_predicate_search)
+{
+    const sample_grid grid{10, 0, 10 * 1024};
+    std::vector<double> values(grid.count);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = std::sin(double(i) / 1024.0);
+    }
+
+    auto by_index = on_grid(grid, [&values](std::size_t begin, std::size_t end) {
+        return begin < end && *std::min_element(values.begin() + begin, values.begin() + end) > 0.5;
+    });
+    auto by_position = [&values](const interval& arg) {
+        auto begin = static_cast<std::size_t>(std::max(0.0, std::ceil(arg.inf() * 1024.0)));
+        auto end = static_cast<std::size_t>(std::min(double(values.size()), std::ceil(arg.sup() * 1024.0)));
+        return begin < end && *std::min_element(values.begin() + begin, values.begin() + end) > 0.5;
+    };
+
+    auto expected = segment(interval(0.0, 10.0), by_position, 10);
+    auto found = segment(interval(0.0, 10.0), by_index, 10);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+}
@@ -4,6 +4,7 @@
 
 #include "expanding_searcher.h"
 
+#include <algorithm>
 #include <cmath>
 #include <unordered_map>
 #include <iostream>
@@ -269,3 +270,277 @@ TEST(dyadic_search_tests, check_multiple_intervals_scaled_high_depth)
 
     EXPECT_LE(found.size(), 13);
 }
+
+TEST(dyadic_search_tests, keeps_left_of_segment_ending_component)
+{
+    // [0.5, 1) is found at depth 1 and runs to the end of the base interval,
+    // but [0, 0.5) must still be searched at the finer depths.
+    auto predicate = [](const interval& arg) {
+        return (arg.inf() >= 0.5 && arg.sup() <= 1.0)
+                || (arg.inf() >= 0.125 && arg.sup() <= 0.1875);
+    };
+
+    auto found = segment(interval(0.0, 1.0), predicate, 4);
+    std::sort(found.begin(), found.end(), [](const interval& lhs, const interval& rhs) {
+        return lhs.inf() < rhs.inf();
+    });
+
+    ASSERT_EQ(found.size(), 2);
+    EXPECT_EQ(found[0], interval(0.125, 0.1875));
+    EXPECT_EQ(found[1], interval(0.5, 1.0));
+}
+
+TEST(dyadic_search_tests, searches_component_after_exhausted_component)
+{
+    // Removing a component whose last segment runs to its end must not skip
+    // the component after it at the same depth.
+    auto predicate = [](const interval& arg) {
+        return (arg.inf() >= 0.125 && arg.sup() <= 0.1875)
+                || (arg.inf() >= 0.1875 && arg.sup() <= 0.5)
+                || (arg.inf() >= 0.6875 && arg.sup() <= 0.75);
+    };
+
+    auto found = segment(interval(0.0, 1.0), predicate, 4);
+    std::sort(found.begin(), found.end(), [](const interval& lhs, const interval& rhs) {
+        return lhs.inf() < rhs.inf();
+    });
+
+    ASSERT_EQ(found.size(), 3);
+    EXPECT_EQ(found[0], interval(0.125, 0.1875));
+    EXPECT_EQ(found[1], interval(0.1875, 0.5));
+    EXPECT_EQ(found[2], interval(0.6875, 0.75));
+}
+
+TEST(dyadic_search_tests, coarsest_fitting_depth_from_length)
+{
+    EXPECT_EQ(ExpandingSearcher::coarsest_fitting_depth(interval(0.0, 1.0)), 0);
+    EXPECT_EQ(ExpandingSearcher::coarsest_fitting_depth(interval(0.0, 10.0)), -3);
+    EXPECT_EQ(ExpandingSearcher::coarsest_fitting_depth(interval(0.0, 1.0e6)), -19);
+    EXPECT_EQ(ExpandingSearcher::coarsest_fitting_depth(interval(0.0, 1.0e-3)), 10);
+
+    ExpandingSearcher search(3, 3, adaptive_start_depth);
+    EXPECT_EQ(search.start_depth(interval(0.0, 1.0e-3)), 3);
+}
+
+TEST(dyadic_search_tests, adaptive_start_depth_long_interval)
+{
+    const interval base(0.0, 1048576.0);
+    auto predicate = [](const interval& arg) {
+        return arg.inf() >= 0.0 && arg.sup() <= 1048576.0;
+    };
+
+    int default_probes = 0;
+    ExpandingSearcher default_search(0, 0);
+    default_search.search_interval(base, [&](const interval& arg) {
+        ++default_probes;
+        return predicate(arg);
+    });
+    auto expected = std::move(default_search).result();
+
+    int adaptive_probes = 0;
+    ExpandingSearcher adaptive_search(0, 0, adaptive_start_depth);
+    adaptive_search.search_interval(base, [&](const interval& arg) {
+        ++adaptive_probes;
+        return predicate(arg);
+    });
+    auto found = std::move(adaptive_search).result();
+
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(expected.size(), 1);
+    EXPECT_EQ(found[0], expected[0]);
+    EXPECT_EQ(found[0], base);
+    EXPECT_EQ(adaptive_probes, 1);
+    EXPECT_EQ(default_probes, 1048576);
+}
+
+TEST(dyadic_search_tests, negative_start_depth_matches_default)
+{
+    auto predicate = [](const segments::interval& arg) {
+        return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+                || (arg.inf() >= 1.354 && arg.sup() <= 2.252)
+                || (arg.inf() >= 4.925 && arg.sup() <= 5.995)
+                || (arg.inf() >= 9.021 && arg.sup() <= 9.411)
+                ;
+    };
+    auto by_position = [](const interval& lhs, const interval& rhs) { return lhs.inf() < rhs.inf(); };
+
+    ExpandingSearcher default_search(10, 10);
+    default_search.search_interval(interval(0.0, 10.0), predicate);
+    auto expected = std::move(default_search).result();
+    std::sort(expected.begin(), expected.end(), by_position);
+
+    for (depth_t start : {-5, -3, -1, 2, adaptive_start_depth}) {
+        ExpandingSearcher search(10, 10, start);
+        search.search_interval(interval(0.0, 10.0), predicate);
+        auto found = std::move(search).result();
+        std::sort(found.begin(), found.end(), by_position);
+
+        ASSERT_EQ(found.size(), expected.size()) << start;
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            EXPECT_EQ(found[i], expected[i]) << start;
+        }
+    }
+}
+
+TEST(dyadic_search_tests, dyadic_result_matches_double_result)
+{
+    auto predicate = [](const segments::interval& arg) {
+        return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+                || (arg.inf() >= 3.791 && arg.sup() <= 4.411)
+                || (arg.inf() >= 9.021 && arg.sup() <= 9.411)
+                ;
+    };
+
+    ExpandingSearcher search(12, 8);
+    search.m_record_dyadic = true;
+    search.search_interval(interval(0.0, 10.0), predicate);
+    auto found = search.m_found;
+    auto found_dyadic = std::move(search).dyadic_result();
+
+    ASSERT_EQ(found_dyadic.size(), found.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(double(found_dyadic[i].inf), found[i].inf());
+        EXPECT_EQ(double(found_dyadic[i].sup), found[i].sup());
+        EXPECT_TRUE(found_dyadic[i].inf.k % 2 != 0 || found_dyadic[i].inf.k == 0);
+        EXPECT_TRUE(found_dyadic[i].sup.k % 2 != 0 || found_dyadic[i].sup.k == 0);
+    }
+}
+
+TEST(dyadic_search_tests, dyadic_result_clipped_to_base)
+{
+    auto predicate = [](const segments::interval& arg) {
+        return arg.sup() <= 0.5;
+    };
+
+    // Bounds on the grid at the trim tolerance are exact.
+    auto on_grid = segment_dyadic(interval(0.25, 1.0), predicate, 3);
+    ASSERT_EQ(on_grid.size(), 1);
+    EXPECT_EQ(on_grid[0].inf.k, 1);
+    EXPECT_EQ(on_grid[0].inf.n, 2);
+    EXPECT_EQ(on_grid[0].sup.k, 1);
+    EXPECT_EQ(on_grid[0].sup.n, 1);
+
+    // Bounds off the grid are rounded outwards to it, whether or not they
+    // have a short dyadic expansion themselves.
+    auto found = segment(interval(0.3, 1.0), predicate, 3);
+    auto off_grid = segment_dyadic(interval(0.3, 1.0), predicate, 3);
+    ASSERT_EQ(off_grid.size(), 1);
+    EXPECT_EQ(found[0].inf(), 0.3);
+    EXPECT_EQ(off_grid[0].inf.k, 1);
+    EXPECT_EQ(off_grid[0].inf.n, 2);
+    EXPECT_EQ(double(off_grid[0].sup), 0.5);
+
+    auto short_dyadic = segment_dyadic(interval(0.3125, 1.0), predicate, 3);
+    ASSERT_EQ(short_dyadic.size(), 1);
+    EXPECT_EQ(double(short_dyadic[0].inf), 0.25);
+
+    auto finer_trim = segment_dyadic(interval(0.3125, 1.0), predicate, 3, 4);
+    ASSERT_EQ(finer_trim.size(), 1);
+    EXPECT_EQ(finer_trim[0].inf.k, 5);
+    EXPECT_EQ(finer_trim[0].inf.n, 4);
+}
+
+TEST(dyadic_search_tests, dyadic_result_is_opt_in)
+{
+    auto predicate = [](const segments::interval& arg) {
+        return arg.sup() <= 0.5;
+    };
+
+    ExpandingSearcher search(3, 3);
+    search.search_interval(interval(0.0, 1.0), predicate);
+    EXPECT_EQ(search.m_found.size(), 1);
+    EXPECT_TRUE(search.m_found_dyadic.empty());
+}
+
+TEST(dyadic_search_tests, pyramid_matches_separate_searches)
+{
+    int probes = 0;
+    auto predicate = [&probes](const segments::interval& arg) {
+        ++probes;
+        return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+                || (arg.inf() >= 1.042 && arg.sup() <= 1.093)
+                || (arg.inf() >= 3.791 && arg.sup() <= 4.411)
+                || (arg.inf() >= 9.021 && arg.sup() <= 9.411)
+                ;
+    };
+
+    const std::vector<depth_t> levels{12, 4, 0, 8, 16};
+    for (depth_t start : {0, 6, adaptive_start_depth}) {
+        probes = 0;
+        auto pyramid = segment_pyramid(interval(0.3, 10.0), predicate, levels, 0, start);
+        const auto pyramid_probes = probes;
+
+        probes = 0;
+        ASSERT_EQ(pyramid.size(), levels.size());
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            auto expected = segment(interval(0.3, 10.0), predicate, levels[i], 16, start);
+            ASSERT_EQ(pyramid[i].size(), expected.size()) << "level " << levels[i] << " start " << start;
+            for (std::size_t j = 0; j < expected.size(); ++j) {
+                EXPECT_EQ(pyramid[i][j], expected[j]);
+            }
+        }
+        EXPECT_LT(pyramid_probes, probes);
+    }
+}
+
+TEST(dyadic_search_tests, query_modes_match_segment)
+{
+    int probes = 0;
+    auto predicate = [&probes](const segments::interval& arg) {
+        ++probes;
+        return (arg.inf() >= 0.234 && arg.sup() <= 0.2523)
+                || (arg.inf() >= 1.042 && arg.sup() <= 1.093)
+                || (arg.inf() >= 3.791 && arg.sup() <= 6.411)
+                || (arg.inf() >= 9.021 && arg.sup() <= 9.411)
+                ;
+    };
+
+    for (depth_t start : {0, 6, adaptive_start_depth}) {
+        for (depth_t signal : {2, 4, 8, 12}) {
+            probes = 0;
+            const auto expected = segment(interval(0.0, 10.0), predicate, signal, 16, start);
+            const auto full_probes = probes;
+
+            double measure = 0.0;
+            for (const auto& found : expected) {
+                measure += found.sup() - found.inf();
+            }
+            EXPECT_EQ(count_segments(interval(0.0, 10.0), predicate, signal, 16, start), expected.size());
+            EXPECT_DOUBLE_EQ(segment_measure(interval(0.0, 10.0), predicate, signal, 16, start), measure);
+
+            probes = 0;
+            EXPECT_EQ(any_segment(interval(0.0, 10.0), predicate, signal, 16, start), !expected.empty());
+            EXPECT_LE(probes, full_probes);
+
+            probes = 0;
+            const auto first = first_segment(interval(0.0, 10.0), predicate, signal, 16, start);
+            EXPECT_LE(probes, full_probes);
+            ASSERT_EQ(first.has_value(), !expected.empty()) << "signal " << signal << " start " << start;
+            if (first) {
+                auto leftmost = *std::min_element(expected.begin(), expected.end(), [](const interval& lhs, const interval& rhs) {
+                    return lhs.inf() < rhs.inf();
+                });
+                EXPECT_EQ(*first, leftmost) << "signal " << signal << " start " << start;
+            }
+        }
+    }
+}
+
+TEST(dyadic_search_tests, any_segment_stops_at_first_hit)
+{
+    int probes = 0;
+    auto predicate = [&probes](const segments::interval& arg) {
+        ++probes;
+        return arg.sup() <= 2.0;
+    };
+
+    EXPECT_TRUE(any_segment(interval(0.0, 8.0), predicate, 10, 20));
+    EXPECT_EQ(probes, 1);
+    EXPECT_FALSE(any_segment(interval(4.0, 8.0), predicate, 4, 8));
+
+    const dyadic_predicate_t never = [](mult_t, depth_t) { return false; };
+    EXPECT_FALSE(any_segment(interval(0.0, 1.0), never, 4));
+    EXPECT_FALSE(first_segment(interval(0.0, 1.0), never, 4).has_value());
+    EXPECT_EQ(count_segments(interval(0.0, 1.0), never, 4), 0u);
+    EXPECT_EQ(segment_measure(interval(0.0, 1.0), never, 4), 0.0);
+}
@@ -0,0 +1,128 @@
+#include "expanding_searcher.h"
+#include "search_tracer.h"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+std::size_t count_occurrences(const std::string& haystack, const std::string& needle)
+{
+    std::size_t count = 0;
+    for (auto pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+}
+
+
+TEST(search_tracer_tests, records_search_timeline)
+{
+    auto path = testing::TempDir() + "segments_search_trace.json";
+    int probes = 0;
+    auto predicate = [&probes](const interval& arg) {
+        ++probes;
+        return arg.inf() >= 0.25 && arg.sup() <= 0.75;
+    };
+
+    {
+        SearchTracer tracer(path);
+        ExpandingSearcher search(3, 3);
+        search.m_tracer = &tracer;
+        search.search_interval(interval(0, 1), predicate);
+        ASSERT_EQ(std::move(search).result().size(), 1);
+    }
+
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const auto json = buffer.str();
+
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+    EXPECT_EQ(count_occurrences(json, R"("name":"search","cat":"search","ph":"B")"), 1);
+    EXPECT_EQ(count_occurrences(json, R"("name":"search","cat":"search","ph":"E")"), 1);
+    EXPECT_EQ(count_occurrences(json, R"("name":"depth","cat":"search","ph":"B")"), 4);
+    EXPECT_EQ(count_occurrences(json, R"("name":"expand","cat":"search","ph":"B")"), 1);
+    EXPECT_EQ(count_occurrences(json, R"("name":"predicate","cat":"search","ph":"X")"), probes);
+}
+
+TEST(search_tracer_tests, tracing_does_not_change_result)
+{
+    auto predicate = [](const interval& arg) {
+        return (arg.inf() >= 0.234 && arg.sup() <= 0.9523)
+                || (arg.inf() >= 3.791 && arg.sup() <= 4.411);
+    };
+
+    ExpandingSearcher plain(8, 8);
+    plain.search_interval(interval(0.0, 10.0), predicate);
+    auto expected = std::move(plain).result();
+
+    SearchTracer tracer(testing::TempDir() + "segments_search_trace_2.json");
+    ExpandingSearcher traced(8, 8);
+    traced.m_tracer = &tracer;
+    traced.search_interval(interval(0.0, 10.0), predicate);
+    auto found = std::move(traced).result();
+
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].inf(), expected[i].inf());
+        EXPECT_EQ(found[i].sup(), expected[i].sup());
+    }
+}
+
+TEST(search_tracer_tests, throwing_predicate_leaves_balanced_trace)
+{
+    auto path = testing::TempDir() + "segments_search_trace_throw.json";
+    {
+        SearchTracer tracer(path);
+        ExpandingSearcher search(3, 3);
+        search.m_tracer = &tracer;
+        int probes = 0;
+        auto predicate = [&probes](const interval& arg) {
+            if (++probes == 6) {
+                throw std::runtime_error("predicate failed");
+            }
+            return arg.inf() >= 0.25 && arg.sup() <= 0.75;
+        };
+        EXPECT_THROW(search.search_interval(interval(0, 1), predicate), std::runtime_error);
+        EXPECT_EQ(tracer.open_events(), 0);
+    }
+
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const auto json = buffer.str();
+
+    EXPECT_EQ(count_occurrences(json, R"("ph":"B")"), count_occurrences(json, R"("ph":"E")"));
+    EXPECT_EQ(count_occurrences(json, R"("name":"search","cat":"search","ph":"E")"), 1);
+}
+
+TEST(search_tracer_tests, non_finite_args_are_written_as_null)
+{
+    auto path = testing::TempDir() + "segments_search_trace_null.json";
+    {
+        SearchTracer tracer(path);
+        tracer.begin("search", {{"inf", -std::numeric_limits<double>::infinity()},
+                                {"sup", std::numeric_limits<double>::quiet_NaN()}});
+        tracer.end("search");
+    }
+
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const auto json = buffer.str();
+
+    EXPECT_NE(json.find(R"("args":{"inf":null,"sup":null})"), std::string::npos);
+    EXPECT_EQ(json.find("inf,"), std::string::npos);
+    EXPECT_EQ(json.find("nan"), std::string::npos);
+}
@@ -0,0 +1,127 @@
+#include "segment_index.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+std::ptrdiff_t naive_locate(const SegmentIndex& index, double point)
+{
+    for (std::size_t i = 0; i < index.size(); ++i) {
+        if (index[i].contains(point)) {
+            return static_cast<std::ptrdiff_t>(i);
+        }
+    }
+    return SegmentIndex::npos;
+}
+
+SegmentIndex make_index()
+{
+    return SegmentIndex({
+        interval(0.625, 0.75),
+        interval(0.125, 0.25),
+        interval(0.25, 0.375),
+        interval(0.875, 1.0)
+    });
+}
+
+}
+
+
+TEST(segment_index_tests, segments_are_sorted)
+{
+    auto index = make_index();
+
+    ASSERT_EQ(index.size(), 4);
+    EXPECT_EQ(index[0].inf(), 0.125);
+    EXPECT_EQ(index[1].inf(), 0.25);
+    EXPECT_EQ(index[2].inf(), 0.625);
+    EXPECT_EQ(index[3].inf(), 0.875);
+}
+
+TEST(segment_index_tests, overlapping_segments_rejected)
+{
+    EXPECT_THROW(SegmentIndex({interval(0.0, 0.5), interval(0.25, 1.0)}), std::invalid_argument);
+}
+
+TEST(segment_index_tests, locate_single_points)
+{
+    auto index = make_index();
+
+    EXPECT_EQ(index.locate(0.0), SegmentIndex::npos);
+    EXPECT_EQ(index.locate(0.125), 0);
+    EXPECT_EQ(index.locate(0.25), 1);
+    EXPECT_EQ(index.locate(0.5), SegmentIndex::npos);
+    EXPECT_EQ(index.locate(0.75), SegmentIndex::npos);
+    EXPECT_EQ(index.locate(0.99), 3);
+    EXPECT_EQ(index.locate(1.0), SegmentIndex::npos);
+}
+
+TEST(segment_index_tests, locate_empty_index)
+{
+    SegmentIndex index({});
+
+    EXPECT_EQ(index.locate(0.5), SegmentIndex::npos);
+}
+
+TEST(segment_index_tests, batched_paths_match_naive)
+{
+    std::vector<interval> segs;
+    for (int i = 0; i < 1000; ++i) {
+        segs.emplace_back(i + 0.25, i + 0.75);
+    }
+    SegmentIndex index(std::move(segs));
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> dist(-10.0, 1010.0);
+    std::vector<double> points(200000);
+    for (auto& point : points) {
+        point = dist(rng);
+    }
+
+    std::vector<std::ptrdiff_t> unsorted(points.size());
+    index.locate(points.data(), points.size(), unsorted.data(), 4);
+
+    std::sort(points.begin(), points.end());
+    std::vector<std::ptrdiff_t> sorted(points.size());
+    index.locate(points.data(), points.size(), sorted.data(), 4);
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        ASSERT_EQ(sorted[i], naive_locate(index, points[i])) << points[i];
+    }
+
+    std::sort(unsorted.begin(), unsorted.end());
+    std::vector<std::ptrdiff_t> expected(sorted);
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(unsorted, expected);
+}
+
+TEST(segment_index_tests, overlapping_ranges)
+{
+    auto index = make_index();
+
+    auto all = index.overlapping(interval(0.0, 1.0));
+    EXPECT_EQ(all.first, 0);
+    EXPECT_EQ(all.second, 4);
+
+    auto middle = index.overlapping(interval(0.3, 0.7));
+    EXPECT_EQ(middle.first, 1);
+    EXPECT_EQ(middle.second, 3);
+
+    auto gap = index.overlapping(interval(0.375, 0.625));
+    EXPECT_EQ(gap.first, gap.second);
+
+    double infs[] = {0.0, 0.3};
+    double sups[] = {0.2, 0.9};
+    std::size_t first[2], last[2];
+    index.overlapping(infs, sups, 2, first, last);
+    EXPECT_EQ(first[0], 0);
+    EXPECT_EQ(last[0], 1);
+    EXPECT_EQ(first[1], 1);
+    EXPECT_EQ(last[1], 4);
+}
@@ -0,0 +1,151 @@
+#include "segment_stream.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+bool in_union(const std::vector<interval>& parts, const interval& arg)
+{
+    return std::any_of(parts.begin(), parts.end(), [&arg](const interval& part) {
+        return part.inf() <= arg.inf() && arg.sup() <= part.sup();
+    });
+}
+
+std::vector<interval> sorted(std::vector<interval> ivls)
+{
+    std::sort(ivls.begin(), ivls.end(), [](const interval& lhs, const interval& rhs) {
+        return lhs.inf() < rhs.inf();
+    });
+    return ivls;
+}
+
+}
+
+
+TEST(segment_stream_tests, range_for_yields_sorted_segments)
+{
+    auto predicate = [](const interval& arg) {
+        return (arg.inf() >= 0.1 && arg.sup() <= 0.35)
+                || (arg.inf() >= 0.55 && arg.sup() <= 0.81);
+    };
+
+    std::vector<interval> found;
+    for (const auto& segment : SegmentStream(interval(0, 1), predicate, 3)) {
+        found.push_back(segment);
+    }
+
+    ASSERT_EQ(found.size(), 2);
+    EXPECT_EQ(found[0].inf(), 0.125);
+    EXPECT_EQ(found[0].sup(), 0.25);
+    EXPECT_EQ(found[1].inf(), 0.625);
+    EXPECT_EQ(found[1].sup(), 0.75);
+}
+
+TEST(segment_stream_tests, first_segment_before_search_completes)
+{
+    int probes = 0;
+    auto predicate = [&probes](const interval& arg) {
+        ++probes;
+        return (arg.inf() >= 0.0234 && arg.sup() <= 0.09523)
+                || (arg.inf() >= 0.3791 && arg.sup() <= 0.4411)
+                || (arg.inf() >= 0.9021 && arg.sup() <= 0.9411);
+    };
+
+    SegmentStream stream(interval(0, 1), predicate, 10);
+    interval first(0.0, 0.0);
+    ASSERT_TRUE(stream.next(first));
+    const auto probes_to_first = probes;
+
+    interval rest(0.0, 0.0);
+    while (stream.next(rest)) {}
+
+    EXPECT_LT(first.sup(), 0.1);
+    EXPECT_LT(probes_to_first, probes / 2);
+}
+
+TEST(segment_stream_tests, matches_segment)
+{
+    std::mt19937 rng(2718);
+    std::uniform_int_distribution<int> count_dist(1, 20);
+    std::uniform_int_distribution<depth_t> signal_dist(0, 8);
+    std::uniform_int_distribution<depth_t> extra_trim_dist(0, 3);
+    const depth_t starts[] = {0, 2, -1, adaptive_start_depth};
+
+    for (int trial = 0; trial < 500; ++trial) {
+        const interval base(std::uniform_real_distribution<double>(-3.0, 1.0)(rng),
+                            std::uniform_real_distribution<double>(4.0, 20.0)(rng));
+        std::uniform_real_distribution<double> point_dist(base.inf() - 1.0, base.sup() + 1.0);
+        std::vector<double> points(2 * count_dist(rng));
+        for (auto& point : points) {
+            point = point_dist(rng);
+        }
+        std::sort(points.begin(), points.end());
+        std::vector<interval> parts;
+        for (std::size_t i = 0; i < points.size(); i += 2) {
+            parts.emplace_back(points[i], points[i + 1]);
+        }
+        auto predicate = [&parts](const interval& arg) { return in_union(parts, arg); };
+
+        const auto signal = signal_dist(rng);
+        const auto trim = signal + extra_trim_dist(rng);
+        const auto start = starts[trial % 4];
+
+        auto expected = sorted(segment(base, predicate, signal, trim, start));
+        std::vector<interval> found;
+        for (const auto& segment : SegmentStream(base, predicate, signal, trim, start)) {
+            found.push_back(segment);
+        }
+
+        ASSERT_EQ(found.size(), expected.size()) << "trial " << trial;
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            ASSERT_EQ(found[i].inf(), expected[i].inf()) << "trial " << trial << " segment " << i;
+            ASSERT_EQ(found[i].sup(), expected[i].sup()) << "trial " << trial << " segment " << i;
+        }
+    }
+}
+
+TEST(segment_stream_tests, resumes_after_predicate_throws)
+{
+    const std::vector<interval> parts{{0.234, 0.9523}, {1.337, 2.7}, {3.791, 4.411}};
+    const interval base(0.0, 5.0);
+    auto plain = [&parts](const interval& arg) { return in_union(parts, arg); };
+    auto expected = sorted(segment(base, plain, 6, 8));
+
+    for (int fail_at = 1; fail_at < 200; fail_at += 7) {
+        int calls = 0;
+        auto predicate = [&](const interval& arg) {
+            if (++calls == fail_at) {
+                throw std::runtime_error("predicate failed");
+            }
+            return in_union(parts, arg);
+        };
+
+        SegmentStream stream(base, predicate, 6, 8);
+        std::vector<interval> found;
+        interval segment(0.0, 0.0);
+        for (;;) {
+            bool more;
+            try {
+                more = stream.next(segment);
+            } catch (const std::runtime_error&) {
+                continue;
+            }
+            if (!more) {
+                break;
+            }
+            found.push_back(segment);
+        }
+
+        ASSERT_EQ(found.size(), expected.size()) << "fail at " << fail_at;
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            EXPECT_EQ(found[i].inf(), expected[i].inf()) << "fail at " << fail_at;
+            EXPECT_EQ(found[i].sup(), expected[i].sup()) << "fail at " << fail_at;
+        }
+    }
+}
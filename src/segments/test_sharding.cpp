@@ -0,0 +1,211 @@
+#include "sharding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include <gtest/gtest.h>
+
+using namespace segments;
+
+namespace {
+
+struct union_predicate {
+    std::vector<interval> parts;
+
+    bool operator()(const interval& arg) const
+    {
+        return std::any_of(parts.begin(), parts.end(), [&arg](const interval& part) {
+            return part.inf() <= arg.inf() && arg.sup() <= part.sup();
+        });
+    }
+};
+
+union_predicate random_union(std::mt19937& rng, double inf, double sup)
+{
+    std::uniform_int_distribution<int> count_dist(1, 12);
+    std::uniform_real_distribution<double> point_dist(inf, sup);
+
+    std::vector<double> points(2 * count_dist(rng));
+    for (auto& point : points) {
+        point = point_dist(rng);
+    }
+    std::sort(points.begin(), points.end());
+
+    union_predicate result;
+    for (std::size_t i = 0; i < points.size(); i += 2) {
+        result.parts.emplace_back(points[i], points[i + 1]);
+    }
+    return result;
+}
+
+/// True on intervals over which a random walk varies by at most a threshold.
+/// Sub-intervals of a true interval are true, but the true intervals are not
+/// those inside a union of runs.
+struct range_predicate {
+    double inf;
+    double step;
+    std::vector<double> walk;
+    double threshold;
+
+    bool operator()(const interval& arg) const
+    {
+        const auto last = static_cast<std::ptrdiff_t>(walk.size()) - 1;
+        const auto first_index = std::clamp<std::ptrdiff_t>(
+                static_cast<std::ptrdiff_t>(std::floor((arg.inf() - inf) / step)), 0, last);
+        const auto last_index = std::clamp<std::ptrdiff_t>(
+                static_cast<std::ptrdiff_t>(std::ceil((arg.sup() - inf) / step)), 0, last);
+        auto range = std::minmax_element(walk.begin() + first_index, walk.begin() + last_index + 1);
+        return *range.second - *range.first <= threshold;
+    }
+};
+
+range_predicate random_range(std::mt19937& rng, double inf, double sup)
+{
+    range_predicate result{inf, (sup - inf) / 4000.0, std::vector<double>(4001), 0.0};
+    std::normal_distribution<double> step_dist;
+    double value = 0.0;
+    for (auto& point : result.walk) {
+        value += step_dist(rng);
+        point = value;
+    }
+    result.threshold = std::uniform_real_distribution<double>(3.0, 30.0)(rng);
+    return result;
+}
+
+std::vector<interval> sorted(std::vector<interval> ivls)
+{
+    std::sort(ivls.begin(), ivls.end(), [](const interval& lhs, const interval& rhs) {
+        return lhs.inf() < rhs.inf();
+    });
+    return ivls;
+}
+
+std::vector<interval> sharded(const interval& arg, const predicate_t& predicate, std::size_t count,
+                              depth_t signal, depth_t trim, depth_t start)
+{
+    auto plan = plan_shards(arg, count, signal, trim, start);
+    std::vector<std::vector<interval>> results;
+    for (std::size_t i = 0; i < plan.shards.size(); ++i) {
+        results.push_back(segment_shard(plan, i, predicate));
+    }
+    return stitch_shards(plan, results, predicate);
+}
+
+}
+
+
+TEST(sharding_tests, shards_are_aligned_and_cover_base)
+{
+    auto plan = plan_shards(interval(0.3, 10.7), 4, 6);
+
+    ASSERT_EQ(plan.start_depth, 0);
+    ASSERT_EQ(plan.shards.size(), 4);
+    EXPECT_EQ(plan.shards.front().inf(), 0.3);
+    EXPECT_EQ(plan.shards.back().sup(), 10.7);
+    for (std::size_t i = 1; i < plan.shards.size(); ++i) {
+        EXPECT_EQ(plan.shards[i].inf(), plan.shards[i - 1].sup());
+        EXPECT_EQ(plan.shards[i].inf(), std::floor(plan.shards[i].inf()));
+    }
+}
+
+TEST(sharding_tests, adaptive_start_depth_is_resolved)
+{
+    auto plan = plan_shards(interval(0.0, 1024.0), 8, 4, 4, adaptive_start_depth);
+
+    EXPECT_EQ(plan.start_depth, -10);
+    ASSERT_EQ(plan.shards.size(), 1);
+}
+
+TEST(sharding_tests, at_most_one_shard_per_block)
+{
+    auto plan = plan_shards(interval(0.0, 3.0), 16, 4);
+
+    EXPECT_EQ(plan.shards.size(), 3);
+}
+
+TEST(sharding_tests, segment_crossing_cut_is_joined)
+{
+    auto predicate = [](const interval& arg) {
+        return arg.inf() >= 0.3 && arg.sup() <= 1.7;
+    };
+
+    auto plan = plan_shards(interval(0.0, 2.0), 2, 4);
+    ASSERT_EQ(plan.shards.size(), 2);
+
+    std::vector<std::vector<interval>> results{
+            segment_shard(plan, 0, predicate),
+            segment_shard(plan, 1, predicate)
+    };
+    auto found = stitch_shards(plan, results, predicate);
+
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(found[0].inf(), 0.3125);
+    EXPECT_EQ(found[0].sup(), 1.6875);
+}
+
+TEST(sharding_tests, stitched_matches_single_search)
+{
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<depth_t> signal_dist(0, 6);
+    std::uniform_int_distribution<depth_t> extra_trim_dist(0, 4);
+    std::uniform_int_distribution<std::size_t> shard_dist(1, 9);
+    const depth_t starts[] = {0, 2, -1, adaptive_start_depth};
+
+    for (int trial = 0; trial < 2000; ++trial) {
+        const interval base(std::uniform_real_distribution<double>(-3.0, 1.0)(rng),
+                            std::uniform_real_distribution<double>(4.0, 20.0)(rng));
+        auto predicate = random_union(rng, base.inf() - 1.0, base.sup() + 1.0);
+        const auto signal = signal_dist(rng);
+        const auto trim = signal + extra_trim_dist(rng);
+        const auto start = starts[trial % 4];
+        const auto count = shard_dist(rng);
+
+        auto expected = sorted(segment(base, predicate, signal, trim, start));
+        auto found = sharded(base, predicate, count, signal, trim, start);
+
+        ASSERT_EQ(found.size(), expected.size()) << "trial " << trial;
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            ASSERT_EQ(found[i].inf(), expected[i].inf()) << "trial " << trial << " segment " << i;
+            ASSERT_EQ(found[i].sup(), expected[i].sup()) << "trial " << trial << " segment " << i;
+        }
+    }
+}
+
+TEST(sharding_tests, stitched_segments_are_sound_for_other_predicates)
+{
+    std::mt19937 rng(54321);
+    std::uniform_int_distribution<depth_t> signal_dist(0, 6);
+    std::uniform_int_distribution<depth_t> extra_trim_dist(0, 4);
+    std::uniform_int_distribution<std::size_t> shard_dist(1, 9);
+    const depth_t starts[] = {0, 2, -1, adaptive_start_depth};
+
+    for (int trial = 0; trial < 500; ++trial) {
+        const interval base(std::uniform_real_distribution<double>(-3.0, 1.0)(rng),
+                            std::uniform_real_distribution<double>(4.0, 20.0)(rng));
+        auto predicate = random_range(rng, base.inf() - 1.0, base.sup() + 1.0);
+        const auto signal = signal_dist(rng);
+        const auto trim = signal + extra_trim_dist(rng);
+        const auto count = shard_dist(rng);
+
+        auto found = sharded(base, predicate, count, signal, trim, starts[trial % 4]);
+
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            ASSERT_LT(found[i].inf(), found[i].sup()) << "trial " << trial << " segment " << i;
+            ASSERT_GE(found[i].inf(), base.inf()) << "trial " << trial << " segment " << i;
+            ASSERT_LE(found[i].sup(), base.sup()) << "trial " << trial << " segment " << i;
+            if (i > 0) {
+                ASSERT_LE(found[i - 1].sup(), found[i].inf()) << "trial " << trial << " segment " << i;
+            }
+
+            dyadic_interval cell(found[i].inf(), trim);
+            if (cell.inf() < found[i].inf()) {
+                ++cell;
+            }
+            for (; cell.sup() <= found[i].sup(); ++cell) {
+                ASSERT_TRUE(predicate(cell)) << "trial " << trial << " segment " << i;
+            }
+        }
+    }
+}